@@ -1,12 +1,14 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
-layout(location = 0) in vec3 fragColor;
-layout(location = 1) in vec2 fragTexCoord;
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) flat in uint fragMaterialIndex;
 
-layout(binding = 1) uniform sampler2D texSampler;
+// Bindless: every loaded texture, one instanced draw mixes materials freely
+layout(set = 1, binding = 0) uniform sampler2D textures[];
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-  outColor = texture(texSampler, fragTexCoord) * vec4(fragColor, 1.0);
+  outColor = texture(textures[nonuniformEXT(fragMaterialIndex)], fragTexCoord);
 }
\ No newline at end of file
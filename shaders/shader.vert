@@ -1,8 +1,8 @@
 #version 450
 
+// PackedVertex: unorm16 position inside the mesh AABB, half float UV
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTexCoord;
+layout(location = 1) in vec2 inTexCoord;
 
 layout(binding = 0) uniform UniformBufferObject
 {
@@ -10,16 +10,49 @@ layout(binding = 0) uniform UniformBufferObject
   mat4 proj;
 } ubo;
 
-layout(push_constant) uniform PushConstants {
+struct ObjectData
+{
   mat4 model;
-} push;
+  vec4 boundingSphere;
+  uint meshIndex;
+  uint materialIndex;
+};
+
+layout(std430, binding = 1) readonly buffer ObjectBuffer
+{
+  ObjectData objects[];
+};
+
+// Written by cull.comp, the indirect draw of each mesh covers its own range
+layout(std430, binding = 2) readonly buffer VisibleBuffer
+{
+  uint visible[];
+};
+
+struct MeshInfo
+{
+  vec4 lodErrors;
+  vec4 positionOffset;
+  vec4 positionScale;
+};
+
+layout(std430, binding = 5) readonly buffer MeshInfoBuffer
+{
+  MeshInfo meshes[];
+};
+
+// The depth pre-pass and the color pass must produce identical depth for the LESS_OR_EQUAL test
+invariant gl_Position;
 
-layout(location = 0) out vec3 fragColor;
-layout(location = 1) out vec2 fragTexCoord;
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) flat out uint fragMaterialIndex;
 
 void main()
 {
-  gl_Position = ubo.proj * ubo.view * push.model * vec4(inPosition, 1.0);
-  fragColor = inColor;
+  ObjectData object = objects[visible[gl_InstanceIndex]];
+  MeshInfo mesh = meshes[object.meshIndex];
+  vec3 position = mesh.positionOffset.xyz + inPosition * mesh.positionScale.xyz;
+  gl_Position = ubo.proj * ubo.view * object.model * vec4(position, 1.0);
   fragTexCoord = inTexCoord;
+  fragMaterialIndex = object.materialIndex;
 }
\ No newline at end of file
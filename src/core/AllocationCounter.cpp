@@ -0,0 +1,47 @@
+#include "AllocationCounter.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> sAllocationCount{0};
+
+uint64_t AllocationCounter::GetCount()
+{
+  return sAllocationCount.load(std::memory_order_relaxed);
+}
+
+void *operator new(std::size_t size)
+{
+  sAllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+  if (void *data = std::malloc(size != 0 ? size : 1))
+  {
+    return data;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+  return ::operator new(size);
+}
+
+void operator delete(void *data) noexcept
+{
+  std::free(data);
+}
+
+void operator delete[](void *data) noexcept
+{
+  std::free(data);
+}
+
+void operator delete(void *data, std::size_t) noexcept
+{
+  std::free(data);
+}
+
+void operator delete[](void *data, std::size_t) noexcept
+{
+  std::free(data);
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+
+// Counts calls of the global operator new from every thread. AllocationCounter.cpp replaces
+// the plain and array forms, over-aligned allocations go through the runtime's own and are not counted.
+// Used to check that the steady state frame loop stays off the heap
+class AllocationCounter
+{
+public:
+  static uint64_t GetCount();
+};
\ No newline at end of file
@@ -1,32 +1,55 @@
 #include "Engine.hpp"
+#include "Logger.hpp"
+#include "AllocationCounter.hpp"
+#include <cmath>
 
 Engine::Engine() : mIsRunning(false) {}
 
 Engine::~Engine()
 {
+  if (mRenderThread.joinable())
+  {
+    mSnapshotQueue.Close();
+    mRenderThread.join();
+  }
+
   mRenderer.WaitIdle();
 
   mAssetManager.Cleanup();
   mRenderer.Cleanup();
   mContext.Cleanup();
   mWindow.Cleanup();
+  mJobSystem.Shutdown();
 }
 
-bool Engine::Init()
+bool Engine::Init(const EngineSettings &settings)
 {
+  mSettings = settings;
+
+  Profiler::SetEnabled(mSettings.profile || !mSettings.tracePath.empty());
+  Profiler::SetSummaryInterval(mSettings.profile ? mSettings.profileInterval : 0);
+  Profiler::SetThreadName("Main");
+
   try
   {
-    mWindow.Init(mAppName, 800, 600);
+    // The render thread records draw chunks in parallel, it gets a job queue of its own
+    mJobSystem.Init(mSettings.workerThreads, mSettings.renderThread ? 1 : 0);
+    mCommands.Init(mJobSystem.GetThreadCount());
+
+    mWindow.Init(mAppName, mSettings.width, mSettings.height, mSettings.headless);
     mContext.Init(&mWindow, mAppName, mEngineName);
-    mRenderer.Init(&mContext);
     mAssetManager.Init(&mContext);
+    mRenderer.Init(&mContext, &mAssetManager, &mJobSystem, mSettings.renderer);
 
-    mAssetManager.LoadMesh("panda", "models/Panda.obj");
+    mAssetManager.LoadMeshAsync("panda", "models/Panda.obj");
     mAssetManager.CreateQuad("ground", 1.0f);
 
     mScene.Init(&mAssetManager);
 
-    mInputSystem.Init(mWindow.GetGLFWwindow());
+    if (!mSettings.headless)
+    {
+      mInputSystem.Init(mWindow.GetGLFWwindow());
+    }
   }
   catch (const std::exception &e)
   {
@@ -39,40 +62,235 @@ bool Engine::Init()
   return true;
 }
 
-void Engine::Run()
+bool Engine::Run()
 {
   Timer timer;
+  uint32_t frameCount = 0;
+  auto startTime = std::chrono::steady_clock::now();
+
+  // Heap allocations of the second half of a frame limited run, past loading and warm up
+  uint64_t allocationCount = AllocationCounter::GetCount();
+  uint64_t steadyAllocations = 0;
+  uint32_t steadyFrames = 0;
+
+  if (mSettings.renderThread)
+  {
+    mRenderThread = std::thread(&Engine::RenderThreadLoop, this);
+  }
+
+  const float step = 1.0f / std::max(mSettings.tickRate, 1.0f);
+  float accumulator = 0.0f;
 
   while (mIsRunning)
   {
+    if (mSettings.maxQueuedFrames >= 0 && !mRenderThread.joinable())
+    {
+      mRenderer.WaitForQueuedFrames(static_cast<uint32_t>(mSettings.maxQueuedFrames));
+    }
+
     float dt = timer.Tick();
 
     ProccessInput(dt);
-    Update(dt);
-    Render();
+
+    {
+      PROFILE_SCOPE("AssetManager::Update");
+      mAssetManager.Update();
+    }
+
+    accumulator += dt;
+    uint32_t ticks = 0;
+
+    while (accumulator >= step && ticks < mSettings.maxTicksPerFrame)
+    {
+      FixedUpdate(step);
+      accumulator -= step;
+      ++ticks;
+    }
+
+    if (accumulator >= step)
+    {
+      // Too far behind to catch up, keep only the phase within the current tick
+      accumulator = std::fmod(accumulator, step);
+    }
+
+    Render(accumulator / step);
+
+    // All threads, the render thread's allocations land in whichever frame they happen in
+    uint64_t allocations = AllocationCounter::GetCount();
+    Profiler::RecordCounter("Heap Allocations", static_cast<double>(allocations - allocationCount));
+    if (mSettings.frameLimit != 0 && frameCount >= mSettings.frameLimit / 2)
+    {
+      steadyAllocations += allocations - allocationCount;
+      ++steadyFrames;
+    }
+    allocationCount = allocations;
+
+    Profiler::EndFrame();
+
+    ++frameCount;
+    if (mSettings.frameLimit != 0 && frameCount >= mSettings.frameLimit)
+    {
+      mIsRunning = false;
+    }
+  }
+
+  // Queued snapshots are still drawn, so the frame count and capture match the single threaded path
+  if (mRenderThread.joinable())
+  {
+    mSnapshotQueue.Close();
+    mRenderThread.join();
+  }
+
+  bool succeeded = true;
+  if (mSettings.frameLimit != 0)
+  {
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    Logger::Log(LogLevel::Info, "Rendered " + std::to_string(frameCount) + " frames in " + std::to_string(totalMs) +
+                                    " ms (avg " + std::to_string(totalMs / frameCount) + " ms)");
+    Logger::Log(LogLevel::Info, "Heap allocations per frame: " +
+                                    std::to_string(steadyFrames != 0 ? double(steadyAllocations) / steadyFrames : 0.0) +
+                                    " over the last " + std::to_string(steadyFrames) + " frames");
+    if (steadyAllocations != 0)
+    {
+      Logger::Log(mSettings.requireZeroAllocations ? LogLevel::Error : LogLevel::Warning,
+                  "The steady state frame loop allocated " + std::to_string(steadyAllocations) + " times, it should stay off the heap");
+      succeeded = !mSettings.requireZeroAllocations;
+    }
+    if (mSettings.renderer.occlusionCulling)
+    {
+      const CullStats &cullStats = mRenderer.GetCullStats();
+      Logger::Log(LogLevel::Info, "Occlusion culled " + std::to_string(cullStats.occlusionCulled) + " objects, " +
+                                      std::to_string(cullStats.lateDrawn) + " drawn by the late pass in the last finished frame");
+    }
+  }
+
+  if (!mSettings.tracePath.empty())
+  {
+    if (Profiler::WriteTrace(mSettings.tracePath))
+    {
+      Logger::Log(LogLevel::Info, "Trace written to " + mSettings.tracePath);
+    }
+    else
+    {
+      Logger::Log(LogLevel::Error, "Failed to write trace: " + mSettings.tracePath);
+    }
+  }
+
+  if (!mSettings.capturePath.empty())
+  {
+    try
+    {
+      mRenderer.SaveFrame(mSettings.capturePath);
+    }
+    catch (const std::exception &e)
+    {
+      std::cerr << "Capture Error: " << e.what() << std::endl;
+    }
   }
+
+  return succeeded;
 }
 
 void Engine::ProccessInput(float dt)
 {
+  PROFILE_SCOPE("ProccessInput");
+
+  if (mSettings.headless)
+  {
+    return;
+  }
+
   mInputSystem.HandleEvents(mWindow.GetGLFWwindow(), mScene.GetRegistry(), dt, mIsRunning);
+  mWindow.UpdateDimensions();
 }
 
-void Engine::Update(float dt)
+void Engine::FixedUpdate(float step)
 {
-  mScene.Update(dt);
-  mMovementSystem.Update(mScene.GetRegistry(), dt);
-  mCollisionSystem.Update(mScene.GetRegistry(), dt);
+  PROFILE_SCOPE("Update");
+
+  mScene.StorePreviousTransforms();
+  mScene.Update(step);
+
+  {
+    PROFILE_SCOPE("MovementSystem");
+    mMovementSystem.Update(mScene.GetRegistry(), mJobSystem, mCommands, step);
+    mCommands.Playback(mScene.GetRegistry());
+  }
+
+  {
+    PROFILE_SCOPE("CollisionSystem");
+    mCollisionSystem.Update(mScene.GetRegistry(), mJobSystem, step);
+  }
+
+  {
+    PROFILE_SCOPE("SpatialIndex");
+    mScene.SyncSpatialIndex();
+  }
 }
 
-void Engine::Render()
+void Engine::Render(float alpha)
 {
-  if (mWindow.CanRender())
+  if (!mWindow.CanRender())
   {
-    auto renderData = mScene.ExtractRenderData();
-    float aspect = static_cast<float>(mWindow.GetWindowWidth()) / static_cast<float>(mWindow.GetWindowHeight());
-    auto cameraData = mScene.ExtractCameraData(aspect);
+    return;
+  }
 
-    mRenderer.DrawFrame(renderData, cameraData);
+  float aspect = static_cast<float>(mWindow.GetWindowWidth()) / static_cast<float>(mWindow.GetWindowHeight());
+
+  if (!mRenderThread.joinable())
+  {
+    {
+      PROFILE_SCOPE("ExtractRenderData");
+      mSnapshot.camera = mScene.ExtractCameraData(aspect);
+      mScene.ExtractRenderData(mJobSystem, mSnapshot, alpha);
+    }
+
+    PROFILE_SCOPE("DrawFrame");
+    mRenderer.DrawFrame(mSnapshot);
+    return;
+  }
+
+  // Blocks while the render thread is a full queue behind, frames are never dropped
+  RenderSnapshot *snapshot = nullptr;
+  {
+    PROFILE_SCOPE("Snapshot Wait");
+    snapshot = mSnapshotQueue.BeginWrite();
+  }
+  if (!snapshot)
+  {
+    // The render thread stopped on an error
+    mIsRunning = false;
+    return;
+  }
+
+  {
+    PROFILE_SCOPE("ExtractRenderData");
+    snapshot->camera = mScene.ExtractCameraData(aspect);
+    mScene.ExtractRenderData(mJobSystem, *snapshot, alpha);
+  }
+
+  mSnapshotQueue.EndWrite();
+}
+
+void Engine::RenderThreadLoop()
+{
+  Profiler::SetThreadName("Render");
+
+  try
+  {
+    // Sharing the main thread's index would race on its queue and on per-thread scratch like mCommands
+    mJobSystem.AttachThread();
+
+    while (RenderSnapshot *snapshot = mSnapshotQueue.BeginRead())
+    {
+      PROFILE_SCOPE("DrawFrame");
+      mRenderer.DrawFrame(*snapshot);
+      mSnapshotQueue.EndRead();
+    }
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Render Error: " << e.what() << std::endl;
+    mSnapshotQueue.Close();
   }
 }
\ No newline at end of file
@@ -3,32 +3,78 @@
 #include "Window.hpp"
 #include "Timer.hpp"
 #include "Scene.hpp"
+#include "JobSystem.hpp"
+#include "FrameQueue.hpp"
+#include "Profiler.hpp"
+#include <thread>
 #include "../ecs/Components.hpp"
 #include "../ecs/CameraComponent.hpp"
 #include "../ecs/TransformComponent.hpp"
 #include "../ecs/MeshComponent.hpp"
+#include "../ecs/EntityCommandBuffer.hpp"
 #include "../system/InputSystem.hpp"
 #include "../system/MovementSystem.hpp"
 #include "../system/CollisionSystem.hpp"
 #include "../graphics/VulkanRenderer.hpp"
 
+struct EngineSettings
+{
+  // Render into an offscreen image without a window or swapchain
+  bool headless = false;
+  int width = 800;
+  int height = 600;
+  // Stop after this many frames, 0 runs until the window is closed
+  uint32_t frameLimit = 0;
+  // Headless only: the last frame is written here on exit
+  std::string capturePath;
+  // Job system workers, 0 uses every hardware thread
+  uint32_t workerThreads = 0;
+  // Simulation ticks per second, systems always integrate with 1 / tickRate
+  float tickRate = 60.0f;
+  // Ticks run at most this many times per frame, older backlog is dropped instead of spiralling
+  uint32_t maxTicksPerFrame = 5;
+  // Collect CPU scopes and GPU timestamps, a summary is logged every profileInterval frames
+  bool profile = false;
+  uint32_t profileInterval = 120;
+  // Chrome trace-event JSON written on exit, implies profile
+  std::string tracePath;
+  // Record and submit frame N on a render thread while frame N+1 is simulated
+  bool renderThread = false;
+  // Frames in flight and the preferred present mode
+  RendererSettings renderer;
+  // Latency limiter: before input is sampled, wait until at most this many frames are queued on the GPU.
+  // -1 disables it, 0 waits for an idle GPU. Ignored with the render thread, the snapshot queue paces it
+  int maxQueuedFrames = -1;
+  // Frame limited runs fail when their second half allocated on the heap, instead of only warning
+  bool requireZeroAllocations = false;
+};
+
 class Engine
 {
 public:
   Engine();
   ~Engine();
 
-  bool Init();
-  void Run();
+  bool Init(const EngineSettings &settings = {});
+  // False when a frame limited run broke a requirement of the settings
+  bool Run();
 
 private:
   void ProccessInput(float dt);
-  void Update(float dt);
-  void Render();
+  void FixedUpdate(float step);
+  void Render(float alpha);
+  void RenderThreadLoop();
 
   const char *mAppName = "Aboba Engine";
   const char *mEngineName = "Aboba Engine";
   bool mIsRunning;
+  EngineSettings mSettings;
+
+  // Three snapshots: one being drawn, one queued, one being extracted
+  static constexpr uint32_t SnapshotCount = 3;
+
+  JobSystem mJobSystem;
+  EntityCommandBuffer mCommands;
 
   Window mWindow;
   VulkanContext mContext;
@@ -39,4 +85,8 @@ private:
   InputSystem mInputSystem;
   MovementSystem mMovementSystem;
   CollisionSystem mCollisionSystem;
+
+  RenderSnapshot mSnapshot;
+  FrameQueue<RenderSnapshot, SnapshotCount> mSnapshotQueue;
+  std::thread mRenderThread;
 };
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+#include <memory_resource>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+// Bump allocator for data that lives for one frame, usable by std::pmr containers.
+// Deallocation is a no-op, Reset hands the whole block back at once. A frame that outgrows
+// the block spills into the upstream resource and the next Reset grows the block to the
+// high-water mark, so the steady state never reaches the global heap.
+// Not thread safe, every thread that allocates needs its own arena.
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+  explicit FrameArena(size_t capacity = 64 * 1024, std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+      : mUpstream(upstream)
+  {
+    Grow(capacity);
+  }
+
+  ~FrameArena() override
+  {
+    ReleaseOverflow();
+    if (mBlock)
+    {
+      mUpstream->deallocate(mBlock, mCapacity, alignof(std::max_align_t));
+    }
+  }
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  // Everything allocated since the last reset becomes invalid
+  void Reset()
+  {
+    size_t highWater = mOffset + mOverflowBytes;
+    ReleaseOverflow();
+    mOffset = 0;
+
+    if (highWater > mCapacity)
+    {
+      Grow(std::max(highWater, mCapacity * 2));
+    }
+  }
+
+  size_t GetUsed() const { return mOffset + mOverflowBytes; }
+  size_t GetCapacity() const { return mCapacity; }
+
+private:
+  struct Overflow
+  {
+    void *data;
+    size_t bytes;
+    size_t alignment;
+  };
+
+  std::pmr::memory_resource *mUpstream;
+  std::byte *mBlock = nullptr;
+  size_t mCapacity = 0;
+  size_t mOffset = 0;
+
+  // Spilled allocations of the current frame, std::vector on the upstream keeps them off the arena itself
+  std::pmr::vector<Overflow> mOverflow{mUpstream};
+  size_t mOverflowBytes = 0;
+
+  void *do_allocate(size_t bytes, size_t alignment) override
+  {
+    size_t offset = (mOffset + alignment - 1) & ~(alignment - 1);
+    if (alignment <= alignof(std::max_align_t) && offset + bytes <= mCapacity)
+    {
+      mOffset = offset + bytes;
+      return mBlock + offset;
+    }
+
+    void *data = mUpstream->allocate(bytes, alignment);
+    mOverflow.push_back({data, bytes, alignment});
+    mOverflowBytes += bytes + alignment;
+    return data;
+  }
+
+  void do_deallocate(void *, size_t, size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+  {
+    return this == &other;
+  }
+
+  void Grow(size_t capacity)
+  {
+    if (mBlock)
+    {
+      mUpstream->deallocate(mBlock, mCapacity, alignof(std::max_align_t));
+    }
+    mBlock = static_cast<std::byte *>(mUpstream->allocate(capacity, alignof(std::max_align_t)));
+    mCapacity = capacity;
+  }
+
+  void ReleaseOverflow()
+  {
+    for (const Overflow &overflow : mOverflow)
+    {
+      mUpstream->deallocate(overflow.data, overflow.bytes, overflow.alignment);
+    }
+    mOverflow.clear();
+    mOverflowBytes = 0;
+  }
+};
\ No newline at end of file
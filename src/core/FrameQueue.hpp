@@ -0,0 +1,113 @@
+#pragma once
+#include <array>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+// Bounded handoff of per-frame data between a producer and a consumer thread.
+// Slots are reused, so their buffers keep capacity across frames. The producer blocks
+// instead of dropping a frame once every slot is queued or being read. Handing off never allocates.
+template <typename T, uint32_t Count>
+class FrameQueue
+{
+public:
+  FrameQueue()
+  {
+    for (uint32_t i = 0; i != Count; ++i)
+    {
+      mFree.Push(i);
+    }
+  }
+
+  // Slot to fill, nullptr once the queue is closed
+  T *BeginWrite()
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this]()
+                    { return mClosed || !mFree.Empty(); });
+
+    if (mClosed)
+    {
+      return nullptr;
+    }
+
+    mWriting = mFree.Pop();
+    return &mSlots[mWriting];
+  }
+
+  void EndWrite()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mReady.Push(mWriting);
+    }
+    mCondition.notify_all();
+  }
+
+  // Oldest filled slot, nullptr once the queue is closed and drained
+  T *BeginRead()
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this]()
+                    { return mClosed || !mReady.Empty(); });
+
+    if (mReady.Empty())
+    {
+      return nullptr;
+    }
+
+    mReading = mReady.Pop();
+    return &mSlots[mReading];
+  }
+
+  void EndRead()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mFree.Push(mReading);
+    }
+    mCondition.notify_all();
+  }
+
+  // Wakes both sides, frames already queued are still handed to the reader
+  void Close()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mClosed = true;
+    }
+    mCondition.notify_all();
+  }
+
+private:
+  // FIFO of slot indices, a slot is in at most one of them so Count entries always fit
+  struct SlotRing
+  {
+    std::array<uint32_t, Count> indices;
+    uint32_t head = 0;
+    uint32_t size = 0;
+
+    bool Empty() const { return size == 0; }
+    void Push(uint32_t index)
+    {
+      indices[(head + size++) % Count] = index;
+    }
+    uint32_t Pop()
+    {
+      uint32_t index = indices[head];
+      head = (head + 1) % Count;
+      --size;
+      return index;
+    }
+  };
+
+  std::array<T, Count> mSlots;
+  SlotRing mFree;
+  SlotRing mReady;
+  uint32_t mWriting = 0;
+  uint32_t mReading = 0;
+  bool mClosed = false;
+
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+};
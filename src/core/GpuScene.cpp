@@ -0,0 +1,268 @@
+#include "GpuScene.hpp"
+#include "../ecs/MeshComponent.hpp"
+#include "../ecs/TransformComponent.hpp"
+#include "../geometry/TransformBatch.hpp"
+#include <array>
+
+void GpuScene::Connect(entt::registry &registry, AssetManager *assets)
+{
+  mAssets = assets;
+  mMaterialGeneration = assets->GetMaterialGeneration();
+  mMeshGeneration = assets->GetMeshGeneration();
+
+  registry.on_construct<MeshComponent>().connect<&GpuScene::OnMeshConstruct>(this);
+  registry.on_destroy<MeshComponent>().connect<&GpuScene::OnMeshDestroy>(this);
+  registry.on_update<MeshComponent>().connect<&GpuScene::OnChanged>(this);
+  registry.on_construct<TransformComponent>().connect<&GpuScene::OnChanged>(this);
+  registry.on_update<TransformComponent>().connect<&GpuScene::OnChanged>(this);
+}
+
+void GpuScene::Disconnect(entt::registry &registry)
+{
+  registry.on_construct<MeshComponent>().disconnect(this);
+  registry.on_destroy<MeshComponent>().disconnect(this);
+  registry.on_update<MeshComponent>().disconnect(this);
+  registry.on_construct<TransformComponent>().disconnect(this);
+  registry.on_update<TransformComponent>().disconnect(this);
+}
+
+void GpuScene::OnMeshConstruct(entt::registry &registry, entt::entity entity)
+{
+  uint32_t slot = mSlotCount;
+  if (!mFreeSlots.empty())
+  {
+    slot = mFreeSlots.back();
+    mFreeSlots.pop_back();
+  }
+  else
+  {
+    ++mSlotCount;
+    mSlotMeshes.push_back(INVALID_MESH_INDEX);
+    mSphereX.push_back(0.0f);
+    mSphereY.push_back(0.0f);
+    mSphereZ.push_back(0.0f);
+    mSphereRadius.push_back(-1.0f);
+  }
+  mSphereRadius[slot] = -1.0f;
+
+  auto index = static_cast<size_t>(entt::to_entity(entity));
+  if (index >= mEntitySlots.size())
+  {
+    mEntitySlots.resize(index + 1, NoSlot);
+  }
+  mEntitySlots[index] = slot;
+
+  mClearedSlots.push_back({slot, {.meshIndex = INVALID_MESH_INDEX}});
+  registry.emplace_or_replace<RenderDirty>(entity);
+}
+
+void GpuScene::OnMeshDestroy(entt::registry &registry, entt::entity entity)
+{
+  auto index = static_cast<size_t>(entt::to_entity(entity));
+  uint32_t slot = mEntitySlots[index];
+  mEntitySlots[index] = NoSlot;
+
+  // The slot keeps its old contents on the GPU until the cleared copy lands
+  SetSlotMesh(slot, INVALID_MESH_INDEX);
+  mSphereRadius[slot] = -1.0f;
+  mClearedSlots.push_back({slot, {.meshIndex = INVALID_MESH_INDEX}});
+  mFreeSlots.push_back(slot);
+
+  registry.remove<RenderDirty>(entity);
+}
+
+void GpuScene::OnChanged(entt::registry &registry, entt::entity entity)
+{
+  if (registry.all_of<MeshComponent>(entity))
+  {
+    registry.emplace_or_replace<RenderDirty>(entity);
+  }
+}
+
+void GpuScene::SetSlotMesh(uint32_t slot, uint32_t meshIndex)
+{
+  uint32_t &current = mSlotMeshes[slot];
+  if (current == meshIndex)
+  {
+    return;
+  }
+
+  if (current != INVALID_MESH_INDEX)
+  {
+    --mMeshObjectCounts[current];
+  }
+  if (meshIndex != INVALID_MESH_INDEX)
+  {
+    if (meshIndex >= mMeshObjectCounts.size())
+    {
+      mMeshObjectCounts.resize(meshIndex + 1, 0);
+    }
+    ++mMeshObjectCounts[meshIndex];
+  }
+  current = meshIndex;
+}
+
+void GpuScene::Extract(entt::registry &registry, JobSystem &jobs, RenderSnapshot &snapshot, float alpha)
+{
+  // A texture finished streaming: material indices resolved to the default texture must be redone.
+  // A mesh finished streaming: its bounding sphere was still zero when its entities were last uploaded
+  if (mMaterialGeneration != mAssets->GetMaterialGeneration() || mMeshGeneration != mAssets->GetMeshGeneration())
+  {
+    mMaterialGeneration = mAssets->GetMaterialGeneration();
+    mMeshGeneration = mAssets->GetMeshGeneration();
+
+    auto meshes = registry.view<MeshComponent>();
+    for (entt::entity entity : meshes)
+    {
+      registry.emplace_or_replace<RenderDirty>(entity);
+    }
+  }
+
+  // Scratch of this extraction, rewound every frame
+  mFrameArena.Reset();
+
+  auto view = registry.view<RenderDirty, TransformComponent, MeshComponent>();
+
+  std::pmr::vector<entt::entity> dirtyEntities(&mFrameArena);
+  dirtyEntities.reserve(view.size_hint());
+  for (entt::entity entity : view)
+  {
+    const auto &meshComp = view.get<MeshComponent>(entity);
+    uint32_t slot = mEntitySlots[static_cast<size_t>(entt::to_entity(entity))];
+    SetSlotMesh(slot, meshComp.mesh ? meshComp.mesh->GetMeshIndex() : INVALID_MESH_INDEX);
+
+    dirtyEntities.push_back(entity);
+  }
+
+  snapshot.objectUpdates.resize(mClearedSlots.size() + dirtyEntities.size());
+  std::copy(mClearedSlots.begin(), mClearedSlots.end(), snapshot.objectUpdates.begin());
+  ObjectUpdate *updates = snapshot.objectUpdates.data() + mClearedSlots.size();
+  mClearedSlots.clear();
+
+  // Matrix build is the expensive part, every update is written by exactly one job. Transforms are gathered
+  // (interpolated) into arrays per batch and the kernel writes matrices straight into the updates
+  jobs.ParallelFor(static_cast<uint32_t>(dirtyEntities.size()), 128, [&](uint32_t begin, uint32_t end)
+                   {
+    std::array<std::array<float, TRANSFORM_GATHER_BATCH>, 9> gathered;
+    TransformArrays arrays{gathered[0].data(), gathered[1].data(), gathered[2].data(),
+                           gathered[3].data(), gathered[4].data(), gathered[5].data(),
+                           gathered[6].data(), gathered[7].data(), gathered[8].data()};
+
+    for (uint32_t first = begin; first != end;)
+    {
+      uint32_t count = std::min(end - first, TRANSFORM_GATHER_BATCH);
+      for (uint32_t k = 0; k != count; ++k)
+      {
+        entt::entity entity = dirtyEntities[first + k];
+        const auto &current = view.get<TransformComponent>(entity);
+        const PreviousTransform *previous = registry.try_get<PreviousTransform>(entity);
+        TransformComponent transform = previous && alpha < 1.0f ? InterpolateTransform(*previous, current, alpha) : current;
+
+        for (uint32_t axis = 0; axis != 3; ++axis)
+        {
+          gathered[axis][k] = transform.position[axis];
+          gathered[3 + axis][k] = transform.rotation[axis];
+          gathered[6 + axis][k] = transform.scale[axis];
+        }
+      }
+      BuildModelMatrices(arrays, count, &updates[first].data.model, sizeof(ObjectUpdate));
+
+      for (uint32_t i = first; i != first + count; ++i)
+      {
+        entt::entity entity = dirtyEntities[i];
+        const auto &meshComp = view.get<MeshComponent>(entity);
+
+        uint32_t slot = mEntitySlots[static_cast<size_t>(entt::to_entity(entity))];
+        ObjectData &data = updates[i].data;
+        const glm::mat4 &model = data.model;
+        updates[i].slot = slot;
+
+        if (meshComp.mesh)
+        {
+          data.boundingSphere = meshComp.mesh->boundingSphere;
+          data.meshIndex = meshComp.mesh->GetMeshIndex();
+
+          // Same conservative transform as cull.comp: the largest axis scale grows the radius
+          glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(data.boundingSphere), 1.0f));
+          float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+          mSphereX[slot] = center.x;
+          mSphereY[slot] = center.y;
+          mSphereZ[slot] = center.z;
+          mSphereRadius[slot] = data.boundingSphere.w * scale;
+        }
+        else
+        {
+          data.boundingSphere = glm::vec4(0.0f);
+          data.meshIndex = INVALID_MESH_INDEX;
+          mSphereRadius[slot] = -1.0f;
+        }
+        data.materialIndex = mAssets->ResolveMaterial(meshComp.materialIndex);
+      }
+      first += count;
+    } });
+
+  // Interpolated entities stay dirty until a render shows them exactly at their current transform
+  std::pmr::vector<entt::entity> settledEntities(&mFrameArena);
+  settledEntities.reserve(dirtyEntities.size());
+  for (entt::entity entity : dirtyEntities)
+  {
+    const PreviousTransform *previous = registry.try_get<PreviousTransform>(entity);
+    const auto &transform = view.get<TransformComponent>(entity);
+
+    if (!previous || (previous->position == transform.position && previous->rotation == transform.rotation && previous->scale == transform.scale))
+    {
+      settledEntities.push_back(entity);
+    }
+  }
+  registry.remove<RenderDirty>(settledEntities.begin(), settledEntities.end());
+
+  std::span<VulkanMesh *const> meshTable = mAssets->GetMeshTable();
+  mMeshObjectCounts.resize(std::max(mMeshObjectCounts.size(), meshTable.size()), 0);
+
+  std::pmr::vector<uint32_t> meshVisibleCounts(&mFrameArena);
+  CullSlots(jobs, snapshot.camera, meshVisibleCounts);
+
+  snapshot.meshes.resize(meshTable.size());
+  for (size_t i = 0; i != meshTable.size(); ++i)
+  {
+    // Readiness and geometry placement are resolved here, the render thread never reads asset state
+    VulkanMesh *mesh = meshTable[i] && meshTable[i]->IsReady() ? meshTable[i] : nullptr;
+    snapshot.meshes[i] = {mesh, mMeshObjectCounts[i], meshVisibleCounts[i],
+                          mesh ? mesh->geometry.firstIndex : 0, mesh ? static_cast<int32_t>(mesh->geometry.vertexOffset) : 0};
+  }
+
+  const GeometryPool &geometry = mAssets->GetGeometryPool();
+  snapshot.vertexBuffer = geometry.GetVertexBuffer();
+  snapshot.indexBuffer = geometry.GetIndexBuffer();
+  snapshot.geometryReadyValue = geometry.GetReadyValue();
+
+  snapshot.objectCount = mSlotCount;
+}
+
+void GpuScene::CullSlots(JobSystem &jobs, const CameraRenderData &camera, std::pmr::vector<uint32_t> &meshVisibleCounts)
+{
+  Frustum frustum = Frustum::FromMatrix(camera.projection * camera.view);
+
+  std::pmr::vector<uint8_t> slotVisible(mSlotCount, &mFrameArena);
+  jobs.ParallelFor(mSlotCount, 1024, [&](uint32_t begin, uint32_t end)
+                   { frustum.CullSpheres(mSphereX.data() + begin, mSphereY.data() + begin, mSphereZ.data() + begin,
+                                         mSphereRadius.data() + begin, slotVisible.data() + begin, end - begin); });
+
+  meshVisibleCounts.assign(mMeshObjectCounts.size(), 0);
+  mVisibleCount = 0;
+  for (uint32_t slot = 0; slot != mSlotCount; ++slot)
+  {
+    if (slotVisible[slot])
+    {
+      ++meshVisibleCounts[mSlotMeshes[slot]];
+      ++mVisibleCount;
+    }
+  }
+
+  uint32_t drawable = 0;
+  for (uint32_t count : mMeshObjectCounts)
+  {
+    drawable += count;
+  }
+  mCulledCount = drawable - mVisibleCount;
+}
\ No newline at end of file
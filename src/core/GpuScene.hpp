@@ -0,0 +1,69 @@
+#pragma once
+#include <entt/entt.hpp>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <memory_resource>
+#include "JobSystem.hpp"
+#include "FrameArena.hpp"
+#include "../graphics/AssetManager.hpp"
+#include "../graphics/RenderTypes.hpp"
+#include "../geometry/Frustum.hpp"
+
+// Dirty transforms gathered per batch for the SoA matrix kernel, small enough to live on a job's stack
+const uint32_t TRANSFORM_GATHER_BATCH = 64;
+
+// Simulation side of the persistent object buffer. Every entity with a MeshComponent owns one slot,
+// allocated and freed by registry signals. Extraction only rebuilds matrices of entities tagged
+// RenderDirty, static entities cost nothing after their first frame.
+// World space bounding spheres are kept per slot as separate arrays for the CPU frustum pass.
+class GpuScene
+{
+public:
+  void Connect(entt::registry &registry, AssetManager *assets);
+  void Disconnect(entt::registry &registry);
+
+  // Fills the snapshot with updated slots and the mesh table, alpha as in Scene::ExtractRenderData.
+  // snapshot.camera must already be set, the mesh table carries visible counts for it
+  void Extract(entt::registry &registry, JobSystem &jobs, RenderSnapshot &snapshot, float alpha);
+
+  uint32_t GetObjectCount() const { return mSlotCount; }
+  // Result of the last Extract, freed slots are counted in neither
+  uint32_t GetVisibleCount() const { return mVisibleCount; }
+  uint32_t GetCulledCount() const { return mCulledCount; }
+
+private:
+  static constexpr uint32_t NoSlot = UINT32_MAX;
+
+  AssetManager *mAssets = nullptr;
+  uint32_t mMaterialGeneration = 0;
+  uint32_t mMeshGeneration = 0;
+
+  // Slot of each entity, indexed by entt::to_entity
+  std::vector<uint32_t> mEntitySlots;
+  // Mesh index each slot was last uploaded with, keeps the per-mesh object counts right
+  std::vector<uint32_t> mSlotMeshes;
+  std::vector<uint32_t> mMeshObjectCounts;
+  std::vector<uint32_t> mFreeSlots;
+  uint32_t mSlotCount = 0;
+
+  // Slots to reset to INVALID_MESH_INDEX: freed ones, and new ones until their entity has a transform
+  std::vector<ObjectUpdate> mClearedSlots;
+  // Per-extraction scratch: dirty and settled entity lists, slot visibility, visible counts
+  FrameArena mFrameArena;
+
+  // World space spheres by slot, radius -1 for slots without a drawable object
+  std::vector<float> mSphereX;
+  std::vector<float> mSphereY;
+  std::vector<float> mSphereZ;
+  std::vector<float> mSphereRadius;
+  uint32_t mVisibleCount = 0;
+  uint32_t mCulledCount = 0;
+
+  void OnMeshConstruct(entt::registry &registry, entt::entity entity);
+  void OnMeshDestroy(entt::registry &registry, entt::entity entity);
+  void OnChanged(entt::registry &registry, entt::entity entity);
+
+  void SetSlotMesh(uint32_t slot, uint32_t meshIndex);
+  void CullSlots(JobSystem &jobs, const CameraRenderData &camera, std::pmr::vector<uint32_t> &meshVisibleCounts);
+};
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "JobSystem.hpp"
+#include <stdexcept>
+
+thread_local uint32_t JobSystem::sThreadIndex = 0;
+
+JobSystem::~JobSystem()
+{
+  Shutdown();
+}
+
+void JobSystem::Init(uint32_t workerCount, uint32_t externalThreadCount)
+{
+  if (workerCount == 0)
+  {
+    uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+  }
+
+  mQueues.clear();
+  for (uint32_t i = 0; i != workerCount + 1 + externalThreadCount; ++i)
+  {
+    mQueues.push_back(std::make_unique<JobQueue>());
+  }
+
+  mRunning = true;
+  sThreadIndex = 0;
+  mNextExternalQueue = workerCount + 1;
+
+  for (uint32_t i = 1; i <= workerCount; ++i)
+  {
+    mWorkers.emplace_back(&JobSystem::WorkerLoop, this, i);
+  }
+}
+
+void JobSystem::Shutdown()
+{
+  if (!mRunning)
+  {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mSleepMutex);
+    mRunning = false;
+  }
+  mWakeCondition.notify_all();
+
+  for (auto &worker : mWorkers)
+  {
+    worker.join();
+  }
+  mWorkers.clear();
+  mQueues.clear();
+}
+
+void JobSystem::AttachThread()
+{
+  uint32_t threadIndex = mNextExternalQueue.fetch_add(1);
+  if (threadIndex >= mQueues.size())
+  {
+    throw std::runtime_error("No job queue left to attach a thread to");
+  }
+
+  sThreadIndex = threadIndex;
+}
+
+void JobSystem::WorkerLoop(uint32_t threadIndex)
+{
+  sThreadIndex = threadIndex;
+
+  while (mRunning)
+  {
+    if (RunOne(threadIndex))
+    {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mSleepMutex);
+    mWakeCondition.wait(lock, [this]()
+                        { return !mRunning || mQueuedJobs.load() > 0; });
+  }
+}
+
+void JobSystem::Push(const Job &job)
+{
+  JobQueue &queue = *mQueues[sThreadIndex];
+
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.count != JobQueue::Capacity)
+    {
+      queue.jobs[(queue.head + queue.count) % JobQueue::Capacity] = job;
+      ++queue.count;
+      mQueuedJobs.fetch_add(1);
+      return;
+    }
+  }
+
+  // Queue full, running the job right away still keeps ParallelFor correct
+  Execute(job);
+}
+
+void JobSystem::WakeWorkers()
+{
+  // Taking the lock orders the notify after any worker that already checked the predicate went to sleep
+  {
+    std::lock_guard<std::mutex> lock(mSleepMutex);
+  }
+  mWakeCondition.notify_all();
+}
+
+bool JobSystem::RunOne(uint32_t threadIndex)
+{
+  Job job;
+  bool found = false;
+
+  {
+    JobQueue &own = *mQueues[threadIndex];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (own.count != 0)
+    {
+      --own.count;
+      job = own.jobs[(own.head + own.count) % JobQueue::Capacity];
+      found = true;
+    }
+  }
+
+  for (size_t offset = 1; !found && offset != mQueues.size(); ++offset)
+  {
+    JobQueue &victim = *mQueues[(threadIndex + offset) % mQueues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (victim.count != 0)
+    {
+      job = victim.jobs[victim.head];
+      victim.head = (victim.head + 1) % JobQueue::Capacity;
+      --victim.count;
+      found = true;
+    }
+  }
+
+  if (!found)
+  {
+    return false;
+  }
+
+  mQueuedJobs.fetch_sub(1);
+  Execute(job);
+
+  return true;
+}
+
+void JobSystem::Wait(const std::atomic<uint32_t> &remaining)
+{
+  while (remaining.load(std::memory_order_acquire) != 0)
+  {
+    if (!RunOne(sThreadIndex))
+    {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::Execute(const Job &job)
+{
+  job.function(job.data, job.begin, job.end);
+  job.remaining->fetch_sub(1, std::memory_order_release);
+}
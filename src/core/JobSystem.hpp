@@ -0,0 +1,148 @@
+#pragma once
+#include <atomic>
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <tuple>
+#include <algorithm>
+#include <cstdint>
+
+// Fixed pool of worker threads, every thread owns a job queue and idle threads steal from the others.
+// A thread waiting for a ParallelFor keeps running jobs instead of blocking, so calls can nest.
+// Jobs are a function pointer over an index range, submitting work does not allocate.
+// Job functions must not throw.
+class JobSystem
+{
+public:
+  ~JobSystem();
+
+  // 0 starts one worker per hardware thread besides the calling one. Other threads that submit or wait for jobs,
+  // like the render thread, need a queue and an index of their own: externalThreadCount reserves them
+  void Init(uint32_t workerCount = 0, uint32_t externalThreadCount = 0);
+  void Shutdown();
+  // Hands the calling thread one of the reserved queues, throws when none is left
+  void AttachThread();
+
+  // Workers, the thread that called Init and the reserved external threads
+  uint32_t GetThreadCount() const { return static_cast<uint32_t>(mQueues.size()); }
+  // 0 on the main thread, 1..N on workers, after that attached threads; indexes per-thread scratch data
+  static uint32_t GetThreadIndex() { return sThreadIndex; }
+
+  // Calls fn(begin, end) over batches of [0, count) on all threads, returns once every batch is done
+  template <typename Fn>
+  void ParallelFor(uint32_t count, uint32_t minBatch, Fn &&fn)
+  {
+    if (count == 0)
+    {
+      return;
+    }
+
+    uint32_t threadCount = GetThreadCount();
+    if (threadCount <= 1 || count <= minBatch)
+    {
+      fn(0u, count);
+      return;
+    }
+
+    // A few batches per thread leave room for stealing when batches take uneven time
+    uint32_t batchSize = std::max({minBatch, (count + threadCount * 4 - 1) / (threadCount * 4), 1u});
+    uint32_t batchCount = (count + batchSize - 1) / batchSize;
+
+    using FnType = std::remove_reference_t<Fn>;
+    void *data = const_cast<void *>(static_cast<const void *>(std::addressof(fn)));
+
+    std::atomic<uint32_t> remaining{batchCount};
+
+    for (uint32_t begin = batchSize; begin < count; begin += batchSize)
+    {
+      Push({[](void *fnData, uint32_t jobBegin, uint32_t jobEnd)
+            { (*static_cast<FnType *>(fnData))(jobBegin, jobEnd); },
+            data, begin, std::min(count, begin + batchSize), &remaining});
+    }
+    WakeWorkers();
+
+    fn(0u, std::min(count, batchSize));
+    remaining.fetch_sub(1, std::memory_order_release);
+
+    Wait(remaining);
+  }
+
+  // Calls fn(entity, components...) for every entity of an EnTT view.
+  // Views over several pools can not be split by index, so entities are gathered first into lists kept per thread
+  // and nesting depth: workers read the list through the capture, and a thread waiting here may run another
+  // ParallelEach meanwhile. Once the lists have grown to the views' sizes nothing allocates
+  template <typename View, typename Fn>
+  void ParallelEach(const View &view, uint32_t minBatch, Fn &&fn)
+  {
+    using Entity = typename View::entity_type;
+
+    // A deque keeps the lists of outer calls in place while a nested call adds a level
+    thread_local std::deque<std::vector<Entity>> scratch;
+    thread_local size_t depth = 0;
+    if (depth == scratch.size())
+    {
+      scratch.emplace_back();
+    }
+
+    std::vector<Entity> &entities = scratch[depth];
+    entities.clear();
+    for (Entity entity : view)
+    {
+      entities.push_back(entity);
+    }
+
+    ++depth;
+    ParallelFor(static_cast<uint32_t>(entities.size()), minBatch, [&](uint32_t begin, uint32_t end)
+                {
+                  for (uint32_t i = begin; i != end; ++i)
+                  {
+                    Entity entity = entities[i];
+                    std::apply([&](auto &...components)
+                               { fn(entity, components...); }, view.get(entity));
+                  } });
+    --depth;
+  }
+
+private:
+  struct Job
+  {
+    void (*function)(void *data, uint32_t begin, uint32_t end);
+    void *data;
+    uint32_t begin;
+    uint32_t end;
+    std::atomic<uint32_t> *remaining;
+  };
+
+  // Ring of jobs, the owner pushes and pops at the back, thieves take from the front
+  struct JobQueue
+  {
+    static constexpr uint32_t Capacity = 1024;
+
+    std::mutex mutex;
+    std::array<Job, Capacity> jobs;
+    uint32_t head = 0;
+    uint32_t count = 0;
+  };
+
+  std::vector<std::unique_ptr<JobQueue>> mQueues;
+  std::vector<std::thread> mWorkers;
+  std::atomic<uint32_t> mNextExternalQueue{0};
+
+  std::atomic<bool> mRunning{false};
+  std::atomic<uint32_t> mQueuedJobs{0};
+  std::mutex mSleepMutex;
+  std::condition_variable mWakeCondition;
+
+  static thread_local uint32_t sThreadIndex;
+
+  void WorkerLoop(uint32_t threadIndex);
+  void Push(const Job &job);
+  void WakeWorkers();
+  bool RunOne(uint32_t threadIndex);
+  void Wait(const std::atomic<uint32_t> &remaining);
+  static void Execute(const Job &job);
+};
@@ -0,0 +1,151 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+  Close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+{
+  MoveFrom(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+  if (this != &other)
+  {
+    Close();
+    MoveFrom(other);
+  }
+  return *this;
+}
+
+void MappedFile::MoveFrom(MappedFile &other)
+{
+  mData = other.mData;
+  mSize = other.mSize;
+  other.mData = nullptr;
+  other.mSize = 0;
+
+#ifdef _WIN32
+  mFileHandle = other.mFileHandle;
+  mMappingHandle = other.mMappingHandle;
+  other.mFileHandle = nullptr;
+  other.mMappingHandle = nullptr;
+#endif
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string &filepath)
+{
+  Close();
+
+  HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+
+  LARGE_INTEGER fileSize{};
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+  {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping)
+  {
+    CloseHandle(file);
+    return false;
+  }
+
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!data)
+  {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  mFileHandle = file;
+  mMappingHandle = mapping;
+  mData = static_cast<const uint8_t *>(data);
+  mSize = static_cast<size_t>(fileSize.QuadPart);
+
+  return true;
+}
+
+void MappedFile::Close()
+{
+  if (mData)
+  {
+    UnmapViewOfFile(mData);
+    CloseHandle(static_cast<HANDLE>(mMappingHandle));
+    CloseHandle(static_cast<HANDLE>(mFileHandle));
+  }
+
+  mData = nullptr;
+  mSize = 0;
+  mFileHandle = nullptr;
+  mMappingHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::string &filepath)
+{
+  Close();
+
+  int fd = open(filepath.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  struct stat fileStat{};
+  if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+  {
+    close(fd);
+    return false;
+  }
+
+  void *data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file
+  close(fd);
+
+  if (data == MAP_FAILED)
+  {
+    return false;
+  }
+
+  mData = static_cast<const uint8_t *>(data);
+  mSize = static_cast<size_t>(fileStat.st_size);
+
+  return true;
+}
+
+void MappedFile::Close()
+{
+  if (mData)
+  {
+    munmap(const_cast<uint8_t *>(mData), mSize);
+  }
+
+  mData = nullptr;
+  mSize = 0;
+}
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  bool Open(const std::string &filepath);
+  void Close();
+
+  bool IsOpen() const { return mData != nullptr; }
+  const uint8_t *GetData() const { return mData; }
+  size_t GetSize() const { return mSize; }
+
+private:
+  const uint8_t *mData = nullptr;
+  size_t mSize = 0;
+
+#ifdef _WIN32
+  void *mFileHandle = nullptr;
+  void *mMappingHandle = nullptr;
+#endif
+
+  void MoveFrom(MappedFile &other);
+};
@@ -0,0 +1,284 @@
+#include "Profiler.hpp"
+#include "Logger.hpp"
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+namespace
+{
+  // Trace events are kept up to this count, stats keep running after that
+  constexpr size_t MaxTraceEvents = 1 << 20;
+  constexpr uint32_t GpuThreadId = 1000;
+
+  struct TraceEvent
+  {
+    const char *name;
+    uint32_t threadId;
+    double beginUs;
+    double durationUs;
+  };
+
+  struct CounterEvent
+  {
+    const char *name;
+    double timeUs;
+    double value;
+  };
+
+  struct Stat
+  {
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+    uint32_t count = 0;
+  };
+
+  struct CounterStat
+  {
+    double total = 0.0;
+    double max = 0.0;
+    uint32_t count = 0;
+  };
+
+  struct ProfilerState
+  {
+    std::atomic<bool> enabled{false};
+    std::atomic<uint32_t> nextThreadId{1};
+    uint32_t summaryInterval = 0;
+    uint32_t windowFrames = 0;
+    Profiler::Clock::time_point origin = Profiler::Clock::now();
+
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    std::vector<CounterEvent> counterEvents;
+    std::unordered_map<const char *, Stat> stats;
+    std::unordered_map<const char *, CounterStat> counters;
+    std::vector<std::pair<uint32_t, std::string>> threadNames;
+  };
+
+  ProfilerState &State()
+  {
+    static ProfilerState state;
+    return state;
+  }
+
+  uint32_t ThreadId()
+  {
+    thread_local uint32_t threadId = State().nextThreadId.fetch_add(1);
+    return threadId;
+  }
+
+  double ToUs(Profiler::Clock::time_point time)
+  {
+    return std::chrono::duration<double, std::micro>(time - State().origin).count();
+  }
+
+  void Record(const char *name, uint32_t threadId, double beginUs, double durationUs)
+  {
+    ProfilerState &state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    if (state.events.size() < MaxTraceEvents)
+    {
+      state.events.push_back({name, threadId, beginUs, durationUs});
+    }
+
+    Stat &stat = state.stats[name];
+    double durationMs = durationUs / 1000.0;
+    stat.totalMs += durationMs;
+    stat.maxMs = std::max(stat.maxMs, durationMs);
+    ++stat.count;
+  }
+
+  void WriteJsonString(std::ostream &out, const std::string &text)
+  {
+    out << '"';
+    for (char c : text)
+    {
+      if (c == '"' || c == '\\')
+      {
+        out << '\\';
+      }
+      out << c;
+    }
+    out << '"';
+  }
+}
+
+void Profiler::SetEnabled(bool enabled)
+{
+  State().enabled = enabled;
+}
+
+bool Profiler::IsEnabled()
+{
+  return State().enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::SetSummaryInterval(uint32_t frames)
+{
+  std::lock_guard<std::mutex> lock(State().mutex);
+  State().summaryInterval = frames;
+}
+
+void Profiler::SetThreadName(const char *name)
+{
+  ProfilerState &state = State();
+  uint32_t threadId = ThreadId();
+
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.threadNames.emplace_back(threadId, name);
+}
+
+void Profiler::RecordCpu(const char *name, Clock::time_point begin, Clock::time_point end)
+{
+  Record(name, ThreadId(), ToUs(begin), std::chrono::duration<double, std::micro>(end - begin).count());
+}
+
+void Profiler::RecordGpu(const char *name, Clock::time_point anchor, double durationMs)
+{
+  if (!IsEnabled())
+  {
+    return;
+  }
+
+  Record(name, GpuThreadId, ToUs(anchor), durationMs * 1000.0);
+}
+
+void Profiler::RecordCounter(const char *name, double value)
+{
+  if (!IsEnabled())
+  {
+    return;
+  }
+
+  ProfilerState &state = State();
+  double timeUs = ToUs(Clock::now());
+  std::lock_guard<std::mutex> lock(state.mutex);
+
+  if (state.counterEvents.size() < MaxTraceEvents)
+  {
+    state.counterEvents.push_back({name, timeUs, value});
+  }
+
+  CounterStat &stat = state.counters[name];
+  stat.total += value;
+  stat.max = std::max(stat.max, value);
+  ++stat.count;
+}
+
+void Profiler::EndFrame()
+{
+  if (!IsEnabled())
+  {
+    return;
+  }
+
+  bool summaryDue = false;
+  {
+    ProfilerState &state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    ++state.windowFrames;
+    summaryDue = state.summaryInterval != 0 && state.windowFrames >= state.summaryInterval;
+  }
+
+  if (summaryDue)
+  {
+    LogSummary();
+  }
+}
+
+void Profiler::LogSummary()
+{
+  ProfilerState &state = State();
+  std::vector<std::pair<std::string, Stat>> rows;
+  std::vector<std::pair<std::string, CounterStat>> counterRows;
+  uint32_t frames = 0;
+
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    frames = std::max(state.windowFrames, 1u);
+    for (const auto &[name, stat] : state.stats)
+    {
+      rows.emplace_back(name, stat);
+    }
+    for (const auto &[name, stat] : state.counters)
+    {
+      counterRows.emplace_back(name, stat);
+    }
+    state.stats.clear();
+    state.counters.clear();
+    state.windowFrames = 0;
+  }
+
+  std::sort(rows.begin(), rows.end(), [](const auto &a, const auto &b)
+            { return a.second.totalMs > b.second.totalMs; });
+
+  std::ostringstream summary;
+  summary << std::fixed << std::setprecision(3) << "Profile over " << frames << " frames (ms per frame / max single):";
+  for (const auto &[name, stat] : rows)
+  {
+    summary << "\n  " << std::left << std::setw(24) << name << std::right << std::setw(9) << stat.totalMs / frames
+            << std::setw(9) << stat.maxMs;
+  }
+
+  if (!counterRows.empty())
+  {
+    std::sort(counterRows.begin(), counterRows.end(), [](const auto &a, const auto &b)
+              { return a.first < b.first; });
+
+    summary << "\nCounters (average / max):";
+    for (const auto &[name, stat] : counterRows)
+    {
+      summary << "\n  " << std::left << std::setw(24) << name << std::right << std::setw(9) << stat.total / std::max(stat.count, 1u)
+              << std::setw(9) << stat.max;
+    }
+  }
+
+  Logger::Log(LogLevel::Info, summary.str());
+}
+
+bool Profiler::WriteTrace(const std::string &filepath)
+{
+  ProfilerState &state = State();
+  std::ofstream file(filepath, std::ios::trunc);
+  if (!file)
+  {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(state.mutex);
+
+  file << std::fixed << std::setprecision(3);
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GpuThreadId << ",\"args\":{\"name\":\"GPU\"}}";
+
+  for (const auto &[threadId, name] : state.threadNames)
+  {
+    file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadId << ",\"args\":{\"name\":";
+    WriteJsonString(file, name);
+    file << "}}";
+  }
+
+  for (const TraceEvent &event : state.events)
+  {
+    file << ",\n{\"name\":";
+    WriteJsonString(file, event.name);
+    file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.threadId << ",\"ts\":" << event.beginUs << ",\"dur\":" << event.durationUs << "}";
+  }
+
+  for (const CounterEvent &event : state.counterEvents)
+  {
+    file << ",\n{\"name\":";
+    WriteJsonString(file, event.name);
+    file << ",\"ph\":\"C\",\"pid\":1,\"ts\":" << event.timeUs << ",\"args\":{\"value\":" << event.value << "}}";
+  }
+
+  file << "\n]}\n";
+
+  return static_cast<bool>(file);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <cstdint>
+
+// Collects named CPU scopes from any thread and GPU intervals from the renderer.
+// Keeps per-name stats over a rolling window of frames and can dump every event as a
+// Chrome trace-event JSON file (chrome://tracing, Perfetto).
+// Names must be string literals, they are keyed by address.
+class Profiler
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static void SetEnabled(bool enabled);
+  static bool IsEnabled();
+  // Frames per stats window, the summary is logged when a window completes
+  static void SetSummaryInterval(uint32_t frames);
+
+  // Label for the calling thread in the trace
+  static void SetThreadName(const char *name);
+
+  static void RecordCpu(const char *name, Clock::time_point begin, Clock::time_point end);
+  // GPU clock is not the CPU clock, intervals are placed on their own track starting at anchor
+  static void RecordGpu(const char *name, Clock::time_point anchor, double durationMs);
+  // Per-frame quantity such as an object count, averaged in the summary and drawn as a graph in the trace
+  static void RecordCounter(const char *name, double value);
+
+  // Call once per frame on the main thread
+  static void EndFrame();
+  static void LogSummary();
+  static bool WriteTrace(const std::string &filepath);
+};
+
+class ProfileScope
+{
+public:
+  explicit ProfileScope(const char *name)
+      : mName(Profiler::IsEnabled() ? name : nullptr)
+  {
+    if (mName)
+    {
+      mBegin = Profiler::Clock::now();
+    }
+  }
+
+  ~ProfileScope()
+  {
+    if (mName)
+    {
+      Profiler::RecordCpu(mName, mBegin, Profiler::Clock::now());
+    }
+  }
+
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+  const char *mName;
+  Profiler::Clock::time_point mBegin;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
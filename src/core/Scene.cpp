@@ -2,9 +2,20 @@
 #include "../ecs/CameraComponent.hpp"
 #include "../ecs/MeshComponent.hpp"
 #include "../ecs/TransformComponent.hpp"
+#include "Profiler.hpp"
+
+Scene::~Scene()
+{
+  // The observer touches the registry when it disconnects, so it must happen while the registry is alive
+  mSpatialIndex.Disconnect(mRegistry);
+}
 
 void Scene::Init(AssetManager *assetManager)
 {
+  mAssets = assetManager;
+  mGpuScene.Connect(mRegistry, assetManager);
+  mSpatialIndex.Connect(mRegistry);
+
   auto camEntity = mRegistry.create();
   mRegistry.emplace<CameraComponent>(camEntity);
 
@@ -15,24 +26,32 @@ void Scene::Init(AssetManager *assetManager)
   auto unit = mRegistry.create();
   mRegistry.emplace<TransformComponent>(unit, glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f));
   mRegistry.emplace<MeshComponent>(unit, assetManager->GetMesh("panda"));
+  mRegistry.emplace<PreviousTransform>(unit);
 }
 
 void Scene::Update(float dt) {}
 
-std::vector<RenderObject> Scene::ExtractRenderData()
+void Scene::StorePreviousTransforms()
 {
-  std::vector<RenderObject> renderQueue;
-
-  auto view = mRegistry.view<TransformComponent, MeshComponent>();
-  renderQueue.reserve(view.size_hint());
+  auto view = mRegistry.view<TransformComponent, PreviousTransform>();
 
-  for (auto [entity, transform, meshComp] : view.each())
+  for (auto [entity, transform, previous] : view.each())
   {
-    renderQueue.push_back({meshComp.mesh,
-                           transform.GetModelMatrix()});
+    previous = {transform.position, transform.rotation, transform.scale};
   }
+}
 
-  return renderQueue;
+void Scene::ExtractRenderData(JobSystem &jobs, RenderSnapshot &snapshot, float alpha)
+{
+  mGpuScene.Extract(mRegistry, jobs, snapshot, alpha);
+
+  Profiler::RecordCounter("Visible Objects", mGpuScene.GetVisibleCount());
+  Profiler::RecordCounter("Culled Objects", mGpuScene.GetCulledCount());
+}
+
+void Scene::SyncSpatialIndex()
+{
+  mSpatialIndex.Sync(mRegistry);
 }
 
 CameraRenderData Scene::ExtractCameraData(float aspectRatio)
@@ -2,16 +2,33 @@
 #include <entt/entt.hpp>
 #include "../graphics/AssetManager.hpp"
 #include "../graphics/VulkanRenderer.hpp"
+#include "JobSystem.hpp"
+#include "GpuScene.hpp"
+#include "SpatialIndex.hpp"
 
 class Scene
 {
 public:
+  ~Scene();
+
   void Init(AssetManager *assetManager);
   void Update(float dt);
-  std::vector<RenderObject> ExtractRenderData();
+  // Call before each simulation tick, remembers the transforms the tick starts from
+  void StorePreviousTransforms();
+  // Fills the snapshot in place so its capacity is reused between frames, only changed objects are written
+  // alpha blends between the previous and the current tick, 1 renders the latest state.
+  // Culls against snapshot.camera, so set it first
+  void ExtractRenderData(JobSystem &jobs, RenderSnapshot &snapshot, float alpha = 1.0f);
   CameraRenderData ExtractCameraData(float aspectRatio);
+  // Call after the systems of a tick moved entities
+  void SyncSpatialIndex();
   entt::registry &GetRegistry() { return mRegistry; }
+  const SpatialIndex &GetSpatialIndex() const { return mSpatialIndex; }
 
 private:
+  // Declared first so they outlive the registry whose signals they are connected to
+  GpuScene mGpuScene;
+  SpatialIndex mSpatialIndex;
   entt::registry mRegistry;
+  AssetManager *mAssets = nullptr;
 };
\ No newline at end of file
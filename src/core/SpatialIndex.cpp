@@ -0,0 +1,115 @@
+#include "SpatialIndex.hpp"
+#include "../ecs/MeshComponent.hpp"
+#include "../ecs/TransformComponent.hpp"
+
+void SpatialIndex::Connect(entt::registry &registry)
+{
+  mObserver.connect(registry, entt::collector.group<TransformComponent>().update<TransformComponent>().update<MeshComponent>().where<TransformComponent>());
+  registry.on_destroy<TransformComponent>().connect<&SpatialIndex::OnTransformDestroy>(this);
+}
+
+void SpatialIndex::Disconnect(entt::registry &registry)
+{
+  mObserver.disconnect();
+  registry.on_destroy<TransformComponent>().disconnect(this);
+}
+
+void SpatialIndex::OnTransformDestroy(entt::registry &registry, entt::entity entity)
+{
+  auto index = static_cast<size_t>(entt::to_entity(entity));
+  if (index < mEntityProxies.size() && mEntityProxies[index] != AabbTree::NullNode)
+  {
+    mTree.DestroyProxy(mEntityProxies[index]);
+    mEntityProxies[index] = AabbTree::NullNode;
+  }
+
+  std::erase(mPendingBounds, entity);
+}
+
+bool SpatialIndex::ComputeBounds(const entt::registry &registry, entt::entity entity, Aabb &box)
+{
+  const auto &transform = registry.get<TransformComponent>(entity);
+  const auto *meshComp = registry.try_get<MeshComponent>(entity);
+
+  if (!meshComp || !meshComp->mesh || !meshComp->mesh->IsReady())
+  {
+    box = {transform.position, transform.position};
+    return !meshComp || !meshComp->mesh;
+  }
+
+  // Same conservative sphere as the renderer's culling
+  glm::mat4 model = transform.GetModelMatrix();
+  glm::vec4 sphere = meshComp->mesh->boundingSphere;
+  glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(sphere), 1.0f));
+  float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+  float radius = sphere.w * scale;
+
+  box = {center - radius, center + radius};
+  return true;
+}
+
+void SpatialIndex::Update(const entt::registry &registry, entt::entity entity)
+{
+  Aabb box;
+  if (!ComputeBounds(registry, entity, box))
+  {
+    mPendingBounds.push_back(entity);
+  }
+
+  auto index = static_cast<size_t>(entt::to_entity(entity));
+  if (index >= mEntityProxies.size())
+  {
+    mEntityProxies.resize(index + 1, AabbTree::NullNode);
+  }
+
+  if (mEntityProxies[index] == AabbTree::NullNode)
+  {
+    mEntityProxies[index] = mTree.CreateProxy(box, static_cast<uint32_t>(entity));
+  }
+  else
+  {
+    mTree.MoveProxy(mEntityProxies[index], box);
+  }
+}
+
+void SpatialIndex::Sync(entt::registry &registry)
+{
+  // Recheck entities waiting for their mesh, an observed change below may queue them again
+  mStillPending.clear();
+  mPendingBounds.swap(mStillPending);
+  for (entt::entity entity : mStillPending)
+  {
+    if (!mObserver.contains(entity))
+    {
+      Update(registry, entity);
+    }
+  }
+
+  for (entt::entity entity : mObserver)
+  {
+    Update(registry, entity);
+  }
+  mObserver.clear();
+}
+
+entt::entity SpatialIndex::PickClosest(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, float *distance) const
+{
+  entt::entity closest = entt::null;
+  float closestDistance = maxDistance;
+
+  Raycast(origin, direction, maxDistance, [&](entt::entity entity, float hitDistance)
+          {
+            if (hitDistance < closestDistance)
+            {
+              closest = entity;
+              closestDistance = hitDistance;
+            }
+            return closestDistance; });
+
+  if (distance)
+  {
+    *distance = closestDistance;
+  }
+
+  return closest;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+#include <entt/entt.hpp>
+#include <vector>
+#include <cstdint>
+#include "../geometry/AabbTree.hpp"
+
+// AABB tree over every entity with a TransformComponent. An observer collects entities whose
+// TransformComponent or MeshComponent was added or patched, Sync moves only their leaves.
+// Mesh entities are bounded by their world space bounding sphere, others by their position.
+// Queries return candidates by fat box, exact tests are up to the caller.
+class SpatialIndex
+{
+public:
+  void Connect(entt::registry &registry);
+  void Disconnect(entt::registry &registry);
+
+  // Applies the changes observed since the last call, run after systems that move entities
+  void Sync(entt::registry &registry);
+
+  uint32_t GetEntityCount() const { return mTree.GetProxyCount(); }
+
+  // fn(entt::entity) for every candidate
+  template <typename Fn>
+  void QueryBox(const Aabb &box, Fn &&fn) const
+  {
+    mTree.QueryBox(box, [&](uint32_t userData)
+                   { fn(static_cast<entt::entity>(userData)); });
+  }
+
+  template <typename Fn>
+  void QueryRadius(const glm::vec3 &center, float radius, Fn &&fn) const
+  {
+    mTree.QueryRadius(center, radius, [&](uint32_t userData)
+                      { fn(static_cast<entt::entity>(userData)); });
+  }
+
+  template <typename Fn>
+  void QueryFrustum(const Frustum &frustum, Fn &&fn) const
+  {
+    mTree.QueryFrustum(frustum, [&](uint32_t userData)
+                       { fn(static_cast<entt::entity>(userData)); });
+  }
+
+  // fn(entt::entity, float distance) returns the new max distance, see AabbTree::Raycast
+  template <typename Fn>
+  void Raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, Fn &&fn) const
+  {
+    mTree.Raycast(origin, direction, maxDistance, [&](uint32_t userData, float distance)
+                  { return fn(static_cast<entt::entity>(userData), distance); });
+  }
+
+  // Closest entity whose box the ray enters, entt::null when there is none
+  entt::entity PickClosest(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, float *distance = nullptr) const;
+
+private:
+  AabbTree mTree;
+  entt::observer mObserver;
+
+  // Proxy of each entity, indexed by entt::to_entity
+  std::vector<int32_t> mEntityProxies;
+  // Entities bounded by their position because their mesh is still streaming in
+  std::vector<entt::entity> mPendingBounds;
+  std::vector<entt::entity> mStillPending;
+
+  void OnTransformDestroy(entt::registry &registry, entt::entity entity);
+  // Returns false when the bounds are a placeholder until the mesh is ready
+  static bool ComputeBounds(const entt::registry &registry, entt::entity entity, Aabb &box);
+  void Update(const entt::registry &registry, entt::entity entity);
+};
\ No newline at end of file
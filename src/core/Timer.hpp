@@ -1,25 +1,23 @@
 #pragma once
-#include <GLFW/glfw3.h>
+#include <chrono>
 
 class Timer
 {
 public:
   Timer()
   {
-    mFrequency = glfwGetTimerFrequency();
     Reset();
   }
 
   void Reset()
   {
-    mLastTime = glfwGetTimerValue();
+    mLastTime = std::chrono::steady_clock::now();
   }
 
   float Tick()
   {
-    uint64_t currentTime = glfwGetTimerValue();
-    uint64_t deltaTicks = currentTime - mLastTime;
-    float dt = static_cast<float>(deltaTicks) / static_cast<float>(mFrequency);
+    auto currentTime = std::chrono::steady_clock::now();
+    float dt = std::chrono::duration<float>(currentTime - mLastTime).count();
 
     mLastTime = currentTime;
 
@@ -32,6 +30,5 @@ public:
   }
 
 private:
-  uint64_t mFrequency;
-  uint64_t mLastTime;
-};
\ No newline at end of file
+  std::chrono::steady_clock::time_point mLastTime;
+};
@@ -13,8 +13,18 @@ GLFWwindow *Window::GetGLFWwindow()
   return mWindow;
 }
 
-void Window::Init(const char *title, int width, int height)
+void Window::Init(const char *title, int width, int height, bool headless)
 {
+  mHeadless = headless;
+
+  // Headless: fixed size, GLFW is never initialized
+  if (mHeadless)
+  {
+    mWindowWidth = mFramebufferWidth = width;
+    mWindowHeight = mFramebufferHeight = height;
+    return;
+  }
+
   glfwInit();
 
   glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -34,17 +44,37 @@ void Window::Init(const char *title, int width, int height)
 
 void Window::UpdateDimensions()
 {
-  glfwGetWindowSize(mWindow, &mWindowWidth, &mWindowHeight);
-  glfwGetFramebufferSize(mWindow, &mFramebufferWidth, &mFramebufferHeight);
+  if (mHeadless)
+  {
+    return;
+  }
+
+  int windowWidth = 0;
+  int windowHeight = 0;
+  int framebufferWidth = 0;
+  int framebufferHeight = 0;
+
+  glfwGetWindowSize(mWindow, &windowWidth, &windowHeight);
+  glfwGetFramebufferSize(mWindow, &framebufferWidth, &framebufferHeight);
+
+  mWindowWidth = windowWidth;
+  mWindowHeight = windowHeight;
+  mFramebufferWidth = framebufferWidth;
+  mFramebufferHeight = framebufferHeight;
 }
 
 bool Window::CanRender()
 {
-  return true;
+  // Minimized windows have a zero sized framebuffer
+  return mFramebufferWidth > 0 && mFramebufferHeight > 0;
 }
 
 void Window::Cleanup()
 {
-  glfwDestroyWindow(mWindow);
-  glfwTerminate();
+  if (mWindow)
+  {
+    glfwDestroyWindow(mWindow);
+    mWindow = nullptr;
+    glfwTerminate();
+  }
 }
\ No newline at end of file
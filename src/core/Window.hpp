@@ -1,6 +1,7 @@
 #pragma once
 #include <GLFW/glfw3.h>
 #include <stdexcept>
+#include <atomic>
 
 class Window
 {
@@ -8,7 +9,7 @@ public:
   Window();
   ~Window();
 
-  void Init(const char *title, int width, int height);
+  void Init(const char *title, int width, int height, bool headless = false);
   void Cleanup();
   bool CanRender();
   GLFWwindow *GetGLFWwindow();
@@ -16,13 +17,16 @@ public:
   int GetWindowHeight() const { return mWindowHeight; };
   int GetFramebufferWidth() const { return mFramebufferWidth; };
   int GetFramebufferHeight() const { return mFramebufferHeight; };
+  // Main thread only, the cached sizes can be read from any thread
   void UpdateDimensions();
+  bool IsHeadless() const { return mHeadless; }
 
 private:
-  int mWindowWidth;
-  int mWindowHeight;
-  int mFramebufferWidth;
-  int mFramebufferHeight;
+  std::atomic<int> mWindowWidth{0};
+  std::atomic<int> mWindowHeight{0};
+  std::atomic<int> mFramebufferWidth{0};
+  std::atomic<int> mFramebufferHeight{0};
 
   GLFWwindow *mWindow = nullptr;
+  bool mHeadless = false;
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include <entt/entt.hpp>
+#include <vector>
+#include "../core/JobSystem.hpp"
+
+// Structural registry changes recorded while systems iterate in parallel, applied later on one thread.
+// Every job thread records into its own list, so recording takes no locks.
+class EntityCommandBuffer
+{
+public:
+  void Init(uint32_t threadCount)
+  {
+    mThreadCommands.resize(threadCount);
+  }
+
+  template <typename Component>
+  void Remove(entt::entity entity)
+  {
+    Record({entity, [](entt::registry &registry, entt::entity target)
+            { registry.remove<Component>(target); }});
+  }
+
+  void Destroy(entt::entity entity)
+  {
+    Record({entity, [](entt::registry &registry, entt::entity target)
+            { registry.destroy(target); }});
+  }
+
+  // Applies the commands thread by thread in recording order, entities destroyed meanwhile are skipped
+  void Playback(entt::registry &registry)
+  {
+    for (auto &commands : mThreadCommands)
+    {
+      for (const Command &command : commands)
+      {
+        if (registry.valid(command.entity))
+        {
+          command.apply(registry, command.entity);
+        }
+      }
+      commands.clear();
+    }
+  }
+
+private:
+  struct Command
+  {
+    entt::entity entity;
+    void (*apply)(entt::registry &registry, entt::entity entity);
+  };
+
+  std::vector<std::vector<Command>> mThreadCommands;
+
+  void Record(const Command &command)
+  {
+    mThreadCommands[JobSystem::GetThreadIndex()].push_back(command);
+  }
+};
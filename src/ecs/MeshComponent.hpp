@@ -4,4 +4,12 @@
 struct MeshComponent
 {
   VulkanMesh *mesh = nullptr;
+  // Slot of the albedo texture in the bindless array, see VulkanTexture::GetMaterialIndex
+  uint32_t materialIndex = 0;
+};
+
+// Tag: the entity's slot in the GPU object buffer is stale. Added by GpuScene whenever the transform or
+// mesh component is emplaced or patched, so systems must write them through registry.patch/replace
+struct RenderDirty
+{
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
 
 struct TransformComponent
 {
@@ -8,6 +9,7 @@ struct TransformComponent
   glm::vec3 rotation{0.0f};
   glm::vec3 scale{1.0f};
 
+  // Scalar path, render extraction builds the same matrices in batches with BuildModelMatrices
   glm::mat4 GetModelMatrix() const
   {
     glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
@@ -17,4 +19,28 @@ struct TransformComponent
     model = glm::scale(model, scale);
     return model;
   }
-};
\ No newline at end of file
+};
+
+// Transform at the start of the last simulation tick, rendering blends from it towards the current one.
+// Only entities that move during simulation need it
+struct PreviousTransform
+{
+  glm::vec3 position{0.0f};
+  glm::vec3 rotation{0.0f};
+  glm::vec3 scale{1.0f};
+};
+
+inline TransformComponent InterpolateTransform(const PreviousTransform &previous, const TransformComponent &current, float alpha)
+{
+  // Euler angles in degrees, blend along the shorter way around
+  glm::vec3 rotationDelta = current.rotation - previous.rotation;
+  rotationDelta.x = std::remainder(rotationDelta.x, 360.0f);
+  rotationDelta.y = std::remainder(rotationDelta.y, 360.0f);
+  rotationDelta.z = std::remainder(rotationDelta.z, 360.0f);
+
+  TransformComponent result;
+  result.position = glm::mix(previous.position, current.position, alpha);
+  result.rotation = previous.rotation + rotationDelta * alpha;
+  result.scale = glm::mix(previous.scale, current.scale, alpha);
+  return result;
+}
\ No newline at end of file
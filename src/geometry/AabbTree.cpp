@@ -0,0 +1,278 @@
+#include "AabbTree.hpp"
+
+int32_t AabbTree::CreateProxy(const Aabb &box, uint32_t userData)
+{
+  int32_t proxy = AllocateNode();
+
+  Node &node = mNodes[proxy];
+  node.box = {box.min - mMargin, box.max + mMargin};
+  node.userData = userData;
+  node.height = 0;
+
+  InsertLeaf(proxy);
+  ++mProxyCount;
+
+  return proxy;
+}
+
+void AabbTree::DestroyProxy(int32_t proxy)
+{
+  RemoveLeaf(proxy);
+  FreeNode(proxy);
+  --mProxyCount;
+}
+
+bool AabbTree::MoveProxy(int32_t proxy, const Aabb &box)
+{
+  Node &node = mNodes[proxy];
+
+  // A fat box far bigger than the object, left from a fast move or a shrink, would make queries sloppy
+  Aabb grown = {box.min - 4.0f * mMargin, box.max + 4.0f * mMargin};
+  if (node.box.Contains(box) && grown.Contains(node.box))
+  {
+    return false;
+  }
+
+  // Extend the fat box in the direction of movement, the next moves likely stay inside it
+  glm::vec3 displacement = (box.min + box.max) * 0.5f - (node.box.min + node.box.max) * 0.5f;
+
+  RemoveLeaf(proxy);
+
+  Aabb fat = {box.min - mMargin, box.max + mMargin};
+  fat.min += glm::min(displacement, glm::vec3(0.0f));
+  fat.max += glm::max(displacement, glm::vec3(0.0f));
+  mNodes[proxy].box = fat;
+
+  InsertLeaf(proxy);
+  return true;
+}
+
+void AabbTree::Clear()
+{
+  mNodes.clear();
+  mRoot = NullNode;
+  mFreeList = NullNode;
+  mProxyCount = 0;
+}
+
+int32_t AabbTree::AllocateNode()
+{
+  if (mFreeList == NullNode)
+  {
+    mNodes.emplace_back();
+    return static_cast<int32_t>(mNodes.size() - 1);
+  }
+
+  int32_t node = mFreeList;
+  mFreeList = mNodes[node].parent;
+  mNodes[node] = Node{};
+  return node;
+}
+
+void AabbTree::FreeNode(int32_t node)
+{
+  mNodes[node].parent = mFreeList;
+  mNodes[node].height = -1;
+  mFreeList = node;
+}
+
+void AabbTree::InsertLeaf(int32_t leaf)
+{
+  if (mRoot == NullNode)
+  {
+    mRoot = leaf;
+    mNodes[leaf].parent = NullNode;
+    return;
+  }
+
+  // Descend towards the sibling with the lowest surface area cost
+  Aabb leafBox = mNodes[leaf].box;
+  int32_t index = mRoot;
+  while (!mNodes[index].IsLeaf())
+  {
+    const Node &node = mNodes[index];
+
+    float area = node.box.SurfaceArea();
+    float combinedArea = Aabb::Union(node.box, leafBox).SurfaceArea();
+
+    // Cost of making a new parent for this node and the leaf
+    float cost = 2.0f * combinedArea;
+    // Minimum cost of pushing the leaf further down
+    float inheritanceCost = 2.0f * (combinedArea - area);
+
+    auto descendCost = [&](int32_t child)
+    {
+      const Aabb &childBox = mNodes[child].box;
+      float unionArea = Aabb::Union(childBox, leafBox).SurfaceArea();
+      return mNodes[child].IsLeaf() ? unionArea + inheritanceCost : unionArea - childBox.SurfaceArea() + inheritanceCost;
+    };
+
+    float cost1 = descendCost(node.child1);
+    float cost2 = descendCost(node.child2);
+
+    if (cost < cost1 && cost < cost2)
+    {
+      break;
+    }
+
+    index = cost1 < cost2 ? node.child1 : node.child2;
+  }
+
+  int32_t sibling = index;
+  int32_t oldParent = mNodes[sibling].parent;
+  int32_t newParent = AllocateNode();
+
+  mNodes[newParent].parent = oldParent;
+  mNodes[newParent].box = Aabb::Union(leafBox, mNodes[sibling].box);
+  mNodes[newParent].height = mNodes[sibling].height + 1;
+  mNodes[newParent].child1 = sibling;
+  mNodes[newParent].child2 = leaf;
+  mNodes[sibling].parent = newParent;
+  mNodes[leaf].parent = newParent;
+
+  if (oldParent == NullNode)
+  {
+    mRoot = newParent;
+  }
+  else if (mNodes[oldParent].child1 == sibling)
+  {
+    mNodes[oldParent].child1 = newParent;
+  }
+  else
+  {
+    mNodes[oldParent].child2 = newParent;
+  }
+
+  Refit(mNodes[leaf].parent);
+}
+
+void AabbTree::RemoveLeaf(int32_t leaf)
+{
+  if (leaf == mRoot)
+  {
+    mRoot = NullNode;
+    return;
+  }
+
+  int32_t parent = mNodes[leaf].parent;
+  int32_t grandParent = mNodes[parent].parent;
+  int32_t sibling = mNodes[parent].child1 == leaf ? mNodes[parent].child2 : mNodes[parent].child1;
+
+  // The sibling takes the place of the parent
+  if (grandParent == NullNode)
+  {
+    mRoot = sibling;
+    mNodes[sibling].parent = NullNode;
+    FreeNode(parent);
+    return;
+  }
+
+  if (mNodes[grandParent].child1 == parent)
+  {
+    mNodes[grandParent].child1 = sibling;
+  }
+  else
+  {
+    mNodes[grandParent].child2 = sibling;
+  }
+  mNodes[sibling].parent = grandParent;
+  FreeNode(parent);
+
+  Refit(grandParent);
+}
+
+void AabbTree::Refit(int32_t index)
+{
+  while (index != NullNode)
+  {
+    index = Balance(index);
+
+    Node &node = mNodes[index];
+    const Node &child1 = mNodes[node.child1];
+    const Node &child2 = mNodes[node.child2];
+    node.height = 1 + std::max(child1.height, child2.height);
+    node.box = Aabb::Union(child1.box, child2.box);
+
+    index = node.parent;
+  }
+}
+
+// Rotates the taller grandchild up when the children of A differ in height by more than one,
+// returns the node now in A's place
+int32_t AabbTree::Balance(int32_t iA)
+{
+  Node &A = mNodes[iA];
+  if (A.IsLeaf() || A.height < 2)
+  {
+    return iA;
+  }
+
+  int32_t iB = A.child1;
+  int32_t iC = A.child2;
+  Node &B = mNodes[iB];
+  Node &C = mNodes[iC];
+
+  int32_t balance = C.height - B.height;
+
+  auto rotate = [&](int32_t iUp, Node &up, int32_t iStay, Node &stay, bool upIsChild2)
+  {
+    int32_t iF = up.child1;
+    int32_t iG = up.child2;
+    Node &F = mNodes[iF];
+    Node &G = mNodes[iG];
+
+    // up takes A's place, A becomes its child
+    up.child1 = iA;
+    up.parent = A.parent;
+    A.parent = iUp;
+
+    if (up.parent == NullNode)
+    {
+      mRoot = iUp;
+    }
+    else if (mNodes[up.parent].child1 == iA)
+    {
+      mNodes[up.parent].child1 = iUp;
+    }
+    else
+    {
+      mNodes[up.parent].child2 = iUp;
+    }
+
+    // The taller grandchild stays with up, the other one replaces up under A
+    int32_t iKeep = F.height > G.height ? iF : iG;
+    int32_t iMove = F.height > G.height ? iG : iF;
+    Node &keep = mNodes[iKeep];
+    Node &move = mNodes[iMove];
+
+    up.child2 = iKeep;
+    if (upIsChild2)
+    {
+      A.child2 = iMove;
+    }
+    else
+    {
+      A.child1 = iMove;
+    }
+    move.parent = iA;
+
+    A.box = Aabb::Union(stay.box, move.box);
+    A.height = 1 + std::max(stay.height, move.height);
+    up.box = Aabb::Union(A.box, keep.box);
+    up.height = 1 + std::max(A.height, keep.height);
+  };
+
+  if (balance > 1)
+  {
+    rotate(iC, C, iB, B, true);
+    return iC;
+  }
+
+  if (balance < -1)
+  {
+    rotate(iB, B, iC, C, false);
+    return iB;
+  }
+
+  return iA;
+}
\ No newline at end of file
@@ -0,0 +1,233 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "Frustum.hpp"
+
+struct Aabb
+{
+  glm::vec3 min{0.0f};
+  glm::vec3 max{0.0f};
+
+  bool Contains(const Aabb &other) const
+  {
+    return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+  }
+
+  bool Overlaps(const Aabb &other) const
+  {
+    return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+  }
+
+  float SurfaceArea() const
+  {
+    glm::vec3 d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+  }
+
+  static Aabb Union(const Aabb &a, const Aabb &b)
+  {
+    return {glm::min(a.min, b.min), glm::max(a.max, b.max)};
+  }
+};
+
+// Dynamic bounding volume hierarchy over fat boxes (Box2D's b2DynamicTree in 3D).
+// Leaves store the box grown by a margin, a move only touches the tree once the object
+// leaves its fat box, so small movements are free and large ones reinsert a single leaf.
+// Insertion picks the sibling by surface area cost, rotations keep the tree balanced.
+// Queries report leaves whose fat box passes the test, the caller does any exact test.
+class AabbTree
+{
+public:
+  static constexpr int32_t NullNode = -1;
+
+  explicit AabbTree(float margin = 0.5f)
+      : mMargin(margin)
+  {
+  }
+
+  // Returns the proxy id, stable until the proxy is destroyed
+  int32_t CreateProxy(const Aabb &box, uint32_t userData);
+  void DestroyProxy(int32_t proxy);
+  // Returns true when the leaf had to be reinserted
+  bool MoveProxy(int32_t proxy, const Aabb &box);
+  void Clear();
+
+  uint32_t GetUserData(int32_t proxy) const { return mNodes[proxy].userData; }
+  const Aabb &GetFatBox(int32_t proxy) const { return mNodes[proxy].box; }
+  uint32_t GetProxyCount() const { return mProxyCount; }
+  int32_t GetHeight() const { return mRoot == NullNode ? 0 : mNodes[mRoot].height; }
+
+  // fn(uint32_t userData) for every leaf overlapping the box
+  template <typename Fn>
+  void QueryBox(const Aabb &box, Fn &&fn) const
+  {
+    Traverse([&](const Aabb &nodeBox)
+             { return nodeBox.Overlaps(box) ? Overlap::Partial : Overlap::Outside; }, fn);
+  }
+
+  template <typename Fn>
+  void QueryRadius(const glm::vec3 &center, float radius, Fn &&fn) const
+  {
+    float radiusSq = radius * radius;
+    Traverse([&](const Aabb &nodeBox)
+             {
+               glm::vec3 d = glm::clamp(center, nodeBox.min, nodeBox.max) - center;
+               return glm::dot(d, d) <= radiusSq ? Overlap::Partial : Overlap::Outside; }, fn);
+  }
+
+  // Subtrees fully inside the frustum are reported without testing their nodes
+  template <typename Fn>
+  void QueryFrustum(const Frustum &frustum, Fn &&fn) const
+  {
+    Traverse([&](const Aabb &nodeBox)
+             {
+               glm::vec3 center = (nodeBox.min + nodeBox.max) * 0.5f;
+               glm::vec3 extent = (nodeBox.max - nodeBox.min) * 0.5f;
+               Overlap result = Overlap::Inside;
+               for (const glm::vec4 &plane : frustum.planes)
+               {
+                 float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+                 float reach = glm::dot(glm::abs(glm::vec3(plane)), extent);
+                 if (distance < -reach)
+                 {
+                   return Overlap::Outside;
+                 }
+                 if (distance < reach)
+                 {
+                   result = Overlap::Partial;
+                 }
+               }
+               return result; }, fn);
+  }
+
+  // fn(uint32_t userData, float distance) for every leaf the ray enters before maxDistance,
+  // distance is where the ray enters the fat box. fn returns the new maxDistance:
+  // return distance to only keep closer hits, maxDistance to collect all of them, 0 to stop.
+  // direction must be normalized
+  template <typename Fn>
+  void Raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, Fn &&fn) const
+  {
+    if (mRoot == NullNode)
+    {
+      return;
+    }
+
+    glm::vec3 invDirection = 1.0f / direction;
+
+    int32_t stack[MaxStack];
+    int32_t stackSize = 0;
+    stack[stackSize++] = mRoot;
+
+    while (stackSize != 0)
+    {
+      const Node &node = mNodes[stack[--stackSize]];
+
+      // Slab test, infinities from zero direction components compare correctly
+      glm::vec3 t0 = (node.box.min - origin) * invDirection;
+      glm::vec3 t1 = (node.box.max - origin) * invDirection;
+      glm::vec3 tNear = glm::min(t0, t1);
+      glm::vec3 tFar = glm::max(t0, t1);
+      float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+      float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+      if (enter > exit)
+      {
+        continue;
+      }
+
+      if (node.IsLeaf())
+      {
+        maxDistance = fn(node.userData, enter);
+        if (maxDistance <= 0.0f)
+        {
+          return;
+        }
+      }
+      else
+      {
+        stack[stackSize++] = node.child1;
+        stack[stackSize++] = node.child2;
+      }
+    }
+  }
+
+private:
+  // Rotations keep the height near 1.5 log2(n), far below this for any realistic count
+  static constexpr int32_t MaxStack = 256;
+
+  enum class Overlap
+  {
+    Outside,
+    Partial,
+    Inside,
+  };
+
+  struct Node
+  {
+    Aabb box;
+    // Next free node while the node is on the free list
+    int32_t parent = NullNode;
+    int32_t child1 = NullNode;
+    int32_t child2 = NullNode;
+    // Leaf 0, free -1
+    int32_t height = -1;
+    uint32_t userData = 0;
+
+    bool IsLeaf() const { return child1 == NullNode; }
+  };
+
+  float mMargin;
+  std::vector<Node> mNodes;
+  int32_t mRoot = NullNode;
+  int32_t mFreeList = NullNode;
+  uint32_t mProxyCount = 0;
+
+  int32_t AllocateNode();
+  void FreeNode(int32_t node);
+  void InsertLeaf(int32_t leaf);
+  void RemoveLeaf(int32_t leaf);
+  int32_t Balance(int32_t node);
+  void Refit(int32_t node);
+
+  template <typename Test, typename Fn>
+  void Traverse(Test &&test, Fn &&fn) const
+  {
+    if (mRoot == NullNode)
+    {
+      return;
+    }
+
+    // Negative entries mark subtrees already known to be inside
+    int32_t stack[MaxStack];
+    int32_t stackSize = 0;
+    stack[stackSize++] = mRoot;
+
+    while (stackSize != 0)
+    {
+      int32_t entry = stack[--stackSize];
+      bool inside = entry < 0;
+      const Node &node = mNodes[inside ? ~entry : entry];
+
+      if (!inside)
+      {
+        Overlap overlap = test(node.box);
+        if (overlap == Overlap::Outside)
+        {
+          continue;
+        }
+        inside = overlap == Overlap::Inside;
+      }
+
+      if (node.IsLeaf())
+      {
+        fn(node.userData);
+      }
+      else
+      {
+        stack[stackSize++] = inside ? ~node.child1 : node.child1;
+        stack[stackSize++] = inside ? ~node.child2 : node.child2;
+      }
+    }
+  }
+};
\ No newline at end of file
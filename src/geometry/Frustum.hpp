@@ -0,0 +1,44 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstddef>
+
+// Six inward facing planes, normalized so a plane equation gives the signed distance
+struct Frustum
+{
+  glm::vec4 planes[6];
+
+  // Gribb/Hartmann: planes are sums and differences of the rows of the view-projection matrix
+  static Frustum FromMatrix(const glm::mat4 &viewProj)
+  {
+    glm::vec4 rowX(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+    glm::vec4 rowY(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+    glm::vec4 rowZ(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+    glm::vec4 rowW(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+    Frustum frustum{{rowW + rowX, rowW - rowX, rowW + rowY, rowW - rowY, rowW + rowZ, rowW - rowZ}};
+    for (auto &plane : frustum.planes)
+    {
+      plane /= glm::length(glm::vec3(plane));
+    }
+
+    return frustum;
+  }
+
+  // Tests spheres stored as separate arrays. The loop has no branches and no early out,
+  // so the compiler turns it into SIMD over consecutive spheres.
+  // A negative radius marks an empty entry that is never visible
+  void CullSpheres(const float *x, const float *y, const float *z, const float *radius, uint8_t *visible, size_t count) const
+  {
+    for (size_t i = 0; i != count; ++i)
+    {
+      float r = radius[i];
+      bool inside = r >= 0.0f;
+      for (const glm::vec4 &plane : planes)
+      {
+        inside &= plane.x * x[i] + plane.y * y[i] + plane.z * z[i] + plane.w >= -r;
+      }
+      visible[i] = inside;
+    }
+  }
+};
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+// Uniform grid on the XY plane. Cells are hashed into a power-of-two bucket table and
+// items are counting-sorted by bucket, so a rebuild is O(n) and a query walks contiguous memory.
+// The cell size must be at least the largest interaction distance, then only the 3x3 block
+// of cells around a point can hold candidates.
+class SpatialHashGrid
+{
+public:
+  struct Item
+  {
+    float x;
+    float y;
+    uint32_t index;
+  };
+
+  void Clear()
+  {
+    mItems.clear();
+  }
+
+  void Insert(float x, float y, uint32_t index)
+  {
+    mItems.push_back({x, y, index});
+  }
+
+  void Build(float cellSize)
+  {
+    mInvCellSize = 1.0f / std::max(cellSize, 0.0001f);
+
+    size_t bucketCount = 16;
+    while (bucketCount < mItems.size() * 2)
+    {
+      bucketCount <<= 1;
+    }
+    mMask = static_cast<uint32_t>(bucketCount - 1);
+
+    mBucketStart.assign(bucketCount + 1, 0);
+    mItemBuckets.resize(mItems.size());
+
+    for (size_t i = 0; i != mItems.size(); ++i)
+    {
+      uint32_t bucket = BucketOf(CellOf(mItems[i].x), CellOf(mItems[i].y));
+      mItemBuckets[i] = bucket;
+      ++mBucketStart[bucket + 1];
+    }
+
+    for (size_t i = 1; i != mBucketStart.size(); ++i)
+    {
+      mBucketStart[i] += mBucketStart[i - 1];
+    }
+
+    mCursor.assign(mBucketStart.begin(), mBucketStart.end() - 1);
+    mSorted.resize(mItems.size());
+
+    for (size_t i = 0; i != mItems.size(); ++i)
+    {
+      mSorted[mCursor[mItemBuckets[i]]++] = mItems[i];
+    }
+  }
+
+  // Calls fn(const Item &) for every item in the 3x3 cell block around (x, y).
+  // Hash collisions can add items from unrelated cells, the caller's distance test filters them.
+  template <typename Fn>
+  void Query(float x, float y, Fn &&fn) const
+  {
+    if (mSorted.empty())
+    {
+      return;
+    }
+
+    int32_t cx = CellOf(x);
+    int32_t cy = CellOf(y);
+
+    uint32_t visited[9];
+    uint32_t visitedCount = 0;
+
+    for (int32_t dy = -1; dy <= 1; ++dy)
+    {
+      for (int32_t dx = -1; dx <= 1; ++dx)
+      {
+        uint32_t bucket = BucketOf(cx + dx, cy + dy);
+
+        if (std::find(visited, visited + visitedCount, bucket) != visited + visitedCount)
+        {
+          continue;
+        }
+        visited[visitedCount++] = bucket;
+
+        for (uint32_t i = mBucketStart[bucket]; i != mBucketStart[bucket + 1]; ++i)
+        {
+          fn(mSorted[i]);
+        }
+      }
+    }
+  }
+
+  size_t Size() const { return mItems.size(); }
+
+private:
+  float mInvCellSize = 1.0f;
+  uint32_t mMask = 0;
+
+  std::vector<Item> mItems;
+  std::vector<Item> mSorted;
+  std::vector<uint32_t> mItemBuckets;
+  std::vector<uint32_t> mBucketStart;
+  std::vector<uint32_t> mCursor;
+
+  int32_t CellOf(float v) const
+  {
+    return static_cast<int32_t>(std::floor(v * mInvCellSize));
+  }
+
+  uint32_t BucketOf(int32_t cx, int32_t cy) const
+  {
+    return ((static_cast<uint32_t>(cx) * 73856093u) ^ (static_cast<uint32_t>(cy) * 19349663u)) & mMask;
+  }
+};
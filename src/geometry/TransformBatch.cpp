@@ -0,0 +1,133 @@
+#include "TransformBatch.hpp"
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TRANSFORM_BATCH_SSE2
+#endif
+
+namespace
+{
+  // Rx * Ry * Rz multiplied out, columns scaled: 9 values of the upper 3x3 plus translation
+  void WriteMatrix(float *m, float sa, float ca, float sb, float cb, float sc, float cc,
+                   float px, float py, float pz, float sx, float sy, float sz)
+  {
+    float column[16] = {
+        cb * cc * sx, (ca * sc + sa * sb * cc) * sx, (sa * sc - ca * sb * cc) * sx, 0.0f,
+        -cb * sc * sy, (ca * cc - sa * sb * sc) * sy, (sa * cc + ca * sb * sc) * sy, 0.0f,
+        sb * sz, -sa * cb * sz, ca * cb * sz, 0.0f,
+        px, py, pz, 1.0f};
+    std::memcpy(m, column, sizeof(column));
+  }
+
+  void BuildModelMatrix(const TransformArrays &t, size_t i, float *m)
+  {
+    constexpr float toRadians = std::numbers::pi_v<float> / 180.0f;
+    float a = t.rotationX[i] * toRadians;
+    float b = t.rotationY[i] * toRadians;
+    float c = t.rotationZ[i] * toRadians;
+    WriteMatrix(m, std::sin(a), std::cos(a), std::sin(b), std::cos(b), std::sin(c), std::cos(c),
+                t.positionX[i], t.positionY[i], t.positionZ[i], t.scaleX[i], t.scaleY[i], t.scaleZ[i]);
+  }
+
+#ifdef TRANSFORM_BATCH_SSE2
+  // Sine and cosine of four angles in degrees. Reduced by quarter turns in degrees, where 90 is exact,
+  // then minimax polynomials on [-45, 45] degrees (Cephes sinf/cosf), error around 1e-7
+  void SinCosDegrees(__m128 degrees, __m128 &sine, __m128 &cosine)
+  {
+    __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(degrees, _mm_set1_ps(1.0f / 90.0f)));
+    __m128 reduced = _mm_sub_ps(degrees, _mm_mul_ps(_mm_cvtepi32_ps(quadrant), _mm_set1_ps(90.0f)));
+    __m128 x = _mm_mul_ps(reduced, _mm_set1_ps(std::numbers::pi_v<float> / 180.0f));
+    __m128 x2 = _mm_mul_ps(x, x);
+
+    __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), x2), _mm_set1_ps(8.3321608736e-3f));
+    s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-1.6666654611e-1f));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, x2), x), x);
+
+    __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), x2), _mm_set1_ps(-1.388731625493765e-3f));
+    c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(4.166664568298827e-2f));
+    c = _mm_mul_ps(_mm_mul_ps(c, x2), x2);
+    c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(x2, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+    // Odd quadrants swap sine and cosine, quadrants 2 and 3 negate the sine, 1 and 2 the cosine
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+    __m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+    sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s)), sineSign);
+    cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c)), cosineSign);
+  }
+
+  // Four transforms, the SoA columns are transposed into one matrix column per transform
+  void BuildModelMatrices4(const TransformArrays &t, size_t i, char *out, size_t stride)
+  {
+    __m128 sa, ca, sb, cb, sc, cc;
+    SinCosDegrees(_mm_loadu_ps(t.rotationX + i), sa, ca);
+    SinCosDegrees(_mm_loadu_ps(t.rotationY + i), sb, cb);
+    SinCosDegrees(_mm_loadu_ps(t.rotationZ + i), sc, cc);
+
+    __m128 sx = _mm_loadu_ps(t.scaleX + i);
+    __m128 sy = _mm_loadu_ps(t.scaleY + i);
+    __m128 sz = _mm_loadu_ps(t.scaleZ + i);
+    __m128 sasb = _mm_mul_ps(sa, sb);
+    __m128 casb = _mm_mul_ps(ca, sb);
+
+    __m128 columns[4][4] = {
+        {
+            _mm_mul_ps(_mm_mul_ps(cb, cc), sx),
+            _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ca, sc), _mm_mul_ps(sasb, cc)), sx),
+            _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sa, sc), _mm_mul_ps(casb, cc)), sx),
+            _mm_setzero_ps(),
+        },
+        {
+            _mm_mul_ps(_mm_mul_ps(cb, sc), _mm_sub_ps(_mm_setzero_ps(), sy)),
+            _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(ca, cc), _mm_mul_ps(sasb, sc)), sy),
+            _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sa, cc), _mm_mul_ps(casb, sc)), sy),
+            _mm_setzero_ps(),
+        },
+        {
+            _mm_mul_ps(sb, sz),
+            _mm_mul_ps(_mm_mul_ps(sa, cb), _mm_sub_ps(_mm_setzero_ps(), sz)),
+            _mm_mul_ps(_mm_mul_ps(ca, cb), sz),
+            _mm_setzero_ps(),
+        },
+        {
+            _mm_loadu_ps(t.positionX + i),
+            _mm_loadu_ps(t.positionY + i),
+            _mm_loadu_ps(t.positionZ + i),
+            _mm_set1_ps(1.0f),
+        },
+    };
+
+    for (size_t column = 0; column != 4; ++column)
+    {
+      __m128 *rows = columns[column];
+      _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+      for (size_t k = 0; k != 4; ++k)
+      {
+        _mm_storeu_ps(reinterpret_cast<float *>(out + k * stride) + column * 4, rows[k]);
+      }
+    }
+  }
+#endif
+}
+
+void BuildModelMatrices(const TransformArrays &transforms, size_t count, void *out, size_t stride)
+{
+  char *bytes = static_cast<char *>(out);
+  size_t i = 0;
+
+#ifdef TRANSFORM_BATCH_SSE2
+  for (; i + 4 <= count; i += 4)
+  {
+    BuildModelMatrices4(transforms, i, bytes + i * stride, stride);
+  }
+#endif
+
+  for (; i != count; ++i)
+  {
+    BuildModelMatrix(transforms, i, reinterpret_cast<float *>(bytes + i * stride));
+  }
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+
+// Transforms stored as separate arrays, Euler angles in degrees as in TransformComponent
+struct TransformArrays
+{
+  const float *positionX;
+  const float *positionY;
+  const float *positionZ;
+  const float *rotationX;
+  const float *rotationY;
+  const float *rotationZ;
+  const float *scaleX;
+  const float *scaleY;
+  const float *scaleZ;
+};
+
+// Builds the matrices TransformComponent::GetModelMatrix does, translate * rotateX * rotateY * rotateZ * scale,
+// in closed form four transforms at a time with SSE2 (scalar on other targets and for the tail).
+// Each column-major matrix is written stride bytes after the previous one, so it can land inside a larger struct
+void BuildModelMatrices(const TransformArrays &transforms, size_t count, void *out, size_t stride);
\ No newline at end of file
@@ -1,8 +1,17 @@
 #include "AssetManager.hpp"
+#include "TextureImporter.hpp"
+#include "../core/Logger.hpp"
+#include <algorithm>
 
 void AssetManager::Init(VulkanContext *context)
 {
   mContext = context;
+  mGeometry.Init(context);
+
+  CreateBindlessSet();
+
+  // Slot 0, sampled by every material whose texture is not loaded yet
+  LoadTexture("default", "textures/Image_1.jpg");
 }
 
 VulkanMesh *AssetManager::LoadMesh(const std::string &name, const std::string &filepath)
@@ -12,11 +21,12 @@ VulkanMesh *AssetManager::LoadMesh(const std::string &name, const std::string &f
     return mMeshes[name].get();
   }
 
+  MeshSource source = MeshCache::LoadOrImport(filepath);
+
   auto mesh = std::make_unique<VulkanMesh>();
-  mesh->LoadFromFile(mContext, filepath);
-  mMeshes[name] = std::move(mesh);
+  mesh->Upload(mGeometry, source.View());
 
-  return mMeshes[name].get();
+  return AddMesh(name, std::move(mesh));
 }
 
 VulkanMesh *AssetManager::CreateQuad(const std::string &name, float size)
@@ -27,10 +37,9 @@ VulkanMesh *AssetManager::CreateQuad(const std::string &name, float size)
   }
 
   auto mesh = std::make_unique<VulkanMesh>();
-  mesh->CreateQuad(mContext, size);
-  mMeshes[name] = std::move(mesh);
+  mesh->CreateQuad(mGeometry, size);
 
-  return mMeshes[name].get();
+  return AddMesh(name, std::move(mesh));
 }
 
 VulkanMesh *AssetManager::GetMesh(const std::string &name)
@@ -39,11 +48,361 @@ VulkanMesh *AssetManager::GetMesh(const std::string &name)
   return it != mMeshes.end() ? it->second.get() : nullptr;
 }
 
+VulkanTexture *AssetManager::GetTexture(const std::string &name)
+{
+  auto it = mTextures.find(name);
+  return it != mTextures.end() ? it->second.get() : nullptr;
+}
+
+VulkanTexture *AssetManager::LoadTexture(const std::string &name, const std::string &filepath)
+{
+  if (mTextures.find(name) != mTextures.end())
+  {
+    return mTextures[name].get();
+  }
+
+  auto texture = std::make_unique<VulkanTexture>();
+  texture->Create(mContext, filepath);
+  AllocateBindlessSlot(texture.get());
+  WriteBindlessSlot(texture.get());
+  mTextures[name] = std::move(texture);
+
+  return mTextures[name].get();
+}
+
+MeshHandle AssetManager::LoadMeshAsync(const std::string &name, const std::string &filepath)
+{
+  if (mMeshes.find(name) != mMeshes.end())
+  {
+    return {mMeshes[name].get()};
+  }
+
+  auto mesh = std::make_unique<VulkanMesh>();
+  mPendingMeshes.push_back({mesh.get(), std::async(std::launch::async, &MeshCache::LoadOrImport, filepath)});
+
+  return {AddMesh(name, std::move(mesh))};
+}
+
+TextureHandle AssetManager::LoadTextureAsync(const std::string &name, const std::string &filepath)
+{
+  if (mTextures.find(name) != mTextures.end())
+  {
+    return {mTextures[name].get()};
+  }
+
+  auto texture = std::make_unique<VulkanTexture>();
+  AllocateBindlessSlot(texture.get());
+  mPendingTextures.push_back({texture.get(), std::async(std::launch::async, &TextureImporter::Import, filepath)});
+  mTextures[name] = std::move(texture);
+
+  return {mTextures[name].get()};
+}
+
+template <typename T, typename Data>
+void AssetManager::UpdatePending(std::vector<PendingLoad<T, Data>> &pending)
+{
+  VulkanUploader &uploader = mContext->GetUploader();
+
+  for (auto it = pending.begin(); it != pending.end();)
+  {
+    if (it->uploadValue == 0)
+    {
+      if (it->data.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      {
+        ++it;
+        continue;
+      }
+
+      try
+      {
+        // The source must outlive UploadAsync, the mapped cache is copied into staging memory there
+        Data data = it->data.get();
+        it->uploadValue = StartUpload(it->asset, data);
+      }
+      catch (const std::exception &e)
+      {
+        Logger::Log(LogLevel::Error, std::string("Async asset load failed: ") + e.what());
+        it = pending.erase(it);
+        continue;
+      }
+    }
+
+    if (uploader.IsComplete(it->uploadValue))
+    {
+      OnReady(it->asset);
+      it->asset->SetReady(true);
+      it = pending.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+void AssetManager::Update()
+{
+  ++mFrame;
+
+  // Polled every frame, geometry moves and blocking uploads complete without anything pending here
+  VulkanUploader &uploader = mContext->GetUploader();
+  uploader.Update();
+  mGeometry.Update();
+
+  if (mPendingMeshes.empty() && mPendingTextures.empty() && mRetiredMeshes.empty() && !mDefragmentPending)
+  {
+    return;
+  }
+
+  ReleaseRetiredMeshes();
+
+  UpdatePending(mPendingMeshes);
+  UpdatePending(mPendingTextures);
+
+  uploader.Flush();
+}
+
+void AssetManager::UnloadMesh(const std::string &name)
+{
+  auto it = mMeshes.find(name);
+  if (it == mMeshes.end())
+  {
+    return;
+  }
+
+  VulkanMesh *mesh = it->second.get();
+  uint64_t uploadValue = 0;
+
+  auto pending = std::find_if(mPendingMeshes.begin(), mPendingMeshes.end(), [mesh](const auto &load)
+                              { return load.asset == mesh; });
+  if (pending != mPendingMeshes.end())
+  {
+    // A parse still running is waited for and dropped, an upload already issued must land before the range is reused
+    if (pending->data.valid())
+    {
+      pending->data.wait();
+    }
+    uploadValue = pending->uploadValue;
+    mPendingMeshes.erase(pending);
+  }
+
+  // Snapshots extracted from now on skip the slot, the ones already queued may still draw the mesh
+  mMeshTable[mesh->GetMeshIndex()] = nullptr;
+  mRetiredMeshes.push_back({std::move(it->second), mFrame, uploadValue});
+  mMeshes.erase(it);
+}
+
+void AssetManager::ReleaseRetiredMeshes()
+{
+  VulkanUploader &uploader = mContext->GetUploader();
+
+  for (auto it = mRetiredMeshes.begin(); it != mRetiredMeshes.end();)
+  {
+    if (mFrame - it->frame <= GEOMETRY_RETIRE_FRAMES || !uploader.IsComplete(it->uploadValue))
+    {
+      ++it;
+      continue;
+    }
+
+    it->mesh->Destroy(mGeometry);
+    it = mRetiredMeshes.erase(it);
+    mDefragmentPending = mDefragmentPending || mGeometry.IsFragmented();
+  }
+
+  // Compaction rewrites the ranges of every live mesh, an upload in flight would land in the old buffers
+  bool uploading = std::any_of(mPendingMeshes.begin(), mPendingMeshes.end(), [](const auto &load)
+                               { return load.uploadValue != 0; }) ||
+                   std::any_of(mRetiredMeshes.begin(), mRetiredMeshes.end(), [&uploader](const RetiredMesh &retired)
+                               { return !uploader.IsComplete(retired.uploadValue); });
+  if (mDefragmentPending && !uploading)
+  {
+    DefragmentGeometry();
+    mDefragmentPending = false;
+  }
+}
+
+void AssetManager::DefragmentGeometry()
+{
+  // Meshes still waiting for release are no longer drawn by new snapshots, their data is left behind
+  // in the old buffers and their ranges dropped so the release does not free space it never owned
+  for (auto &retired : mRetiredMeshes)
+  {
+    retired.mesh->geometry = {};
+  }
+
+  std::vector<GeometryRange *> ranges;
+  for (VulkanMesh *mesh : mMeshTable)
+  {
+    if (mesh && mesh->geometry.vertexCount != 0)
+    {
+      ranges.push_back(&mesh->geometry);
+    }
+  }
+
+  // Keeping the current order makes compaction a series of moves towards the start
+  std::sort(ranges.begin(), ranges.end(), [](const GeometryRange *a, const GeometryRange *b)
+            { return a->vertexOffset < b->vertexOffset; });
+  mGeometry.Defragment(ranges);
+
+  Logger::Log(LogLevel::Info, "Geometry pool compacted: " + std::to_string(mGeometry.GetUsedVertices()) + " vertices, " +
+                                  std::to_string(mGeometry.GetUsedIndices()) + " indices in use");
+}
+
+VulkanMesh *AssetManager::AddMesh(const std::string &name, std::unique_ptr<VulkanMesh> mesh)
+{
+  mesh->SetMeshIndex(static_cast<uint32_t>(mMeshTable.size()));
+  mMeshTable.push_back(mesh.get());
+  mMeshes[name] = std::move(mesh);
+
+  return mMeshes[name].get();
+}
+
+uint32_t AssetManager::ResolveMaterial(uint32_t materialIndex) const
+{
+  if (materialIndex < mBindlessTextures.size() && mBindlessTextures[materialIndex]->IsReady())
+  {
+    return materialIndex;
+  }
+
+  return 0;
+}
+
+void AssetManager::CreateBindlessSet()
+{
+  VkDescriptorSetLayoutBinding texturesBinding{
+      .binding = 0,
+      .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      .descriptorCount = MAX_BINDLESS_TEXTURES,
+      .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+  };
+
+  VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                          VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                          VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+  VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+      .bindingCount = 1,
+      .pBindingFlags = &bindingFlags,
+  };
+
+  VkDescriptorSetLayoutCreateInfo layoutInfo{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+      .pNext = &bindingFlagsInfo,
+      .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+      .bindingCount = 1,
+      .pBindings = &texturesBinding,
+  };
+
+  if (vkCreateDescriptorSetLayout(mContext->GetDevice(), &layoutInfo, nullptr, &mBindlessLayout) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to create bindless descriptor set layout");
+  }
+
+  VkDescriptorPoolSize poolSize{
+      .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      .descriptorCount = MAX_BINDLESS_TEXTURES,
+  };
+
+  VkDescriptorPoolCreateInfo poolInfo{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+      .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+      .maxSets = 1,
+      .poolSizeCount = 1,
+      .pPoolSizes = &poolSize,
+  };
+
+  if (vkCreateDescriptorPool(mContext->GetDevice(), &poolInfo, nullptr, &mBindlessPool) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to create bindless descriptor pool");
+  }
+
+  VkDescriptorSetAllocateInfo allocInfo{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      .descriptorPool = mBindlessPool,
+      .descriptorSetCount = 1,
+      .pSetLayouts = &mBindlessLayout,
+  };
+
+  if (vkAllocateDescriptorSets(mContext->GetDevice(), &allocInfo, &mBindlessSet) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to allocate bindless descriptor set");
+  }
+}
+
+uint32_t AssetManager::AllocateBindlessSlot(VulkanTexture *texture)
+{
+  if (mBindlessTextures.size() == MAX_BINDLESS_TEXTURES)
+  {
+    throw std::runtime_error("Bindless texture array is full");
+  }
+
+  uint32_t index = static_cast<uint32_t>(mBindlessTextures.size());
+  mBindlessTextures.push_back(texture);
+  texture->SetMaterialIndex(index);
+
+  return index;
+}
+
+void AssetManager::WriteBindlessSlot(const VulkanTexture *texture)
+{
+  VkDescriptorImageInfo imageInfo{
+      .sampler = texture->GetSampler(),
+      .imageView = texture->GetImageView(),
+      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+  };
+  VkWriteDescriptorSet descriptorWrite{
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = mBindlessSet,
+      .dstBinding = 0,
+      .dstArrayElement = texture->GetMaterialIndex(),
+      .descriptorCount = 1,
+      .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      .pImageInfo = &imageInfo,
+  };
+
+  vkUpdateDescriptorSets(mContext->GetDevice(), 1, &descriptorWrite, 0, nullptr);
+}
+
 void AssetManager::Cleanup()
 {
+  // Let worker threads finish before the assets they write into go away
+  for (auto &pending : mPendingMeshes)
+  {
+    if (pending.data.valid())
+    {
+      pending.data.wait();
+    }
+  }
+  for (auto &pending : mPendingTextures)
+  {
+    if (pending.data.valid())
+    {
+      pending.data.wait();
+    }
+  }
+  mPendingMeshes.clear();
+  mPendingTextures.clear();
+
   for (auto &pair : mMeshes)
   {
-    pair.second->Destroy(mContext);
+    pair.second->Destroy(mGeometry);
   }
   mMeshes.clear();
-}
\ No newline at end of file
+  mMeshTable.clear();
+  mRetiredMeshes.clear();
+  mGeometry.Cleanup();
+
+  for (auto &pair : mTextures)
+  {
+    pair.second->Destroy(mContext);
+  }
+  mTextures.clear();
+  mBindlessTextures.clear();
+
+  vkDestroyDescriptorPool(mContext->GetDevice(), mBindlessPool, nullptr);
+  vkDestroyDescriptorSetLayout(mContext->GetDevice(), mBindlessLayout, nullptr);
+  mBindlessPool = VK_NULL_HANDLE;
+  mBindlessLayout = VK_NULL_HANDLE;
+  mBindlessSet = VK_NULL_HANDLE;
+}
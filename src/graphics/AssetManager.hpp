@@ -2,19 +2,120 @@
 #include <unordered_map>
 #include <string>
 #include <memory>
+#include <vector>
+#include <future>
+#include <span>
 #include "VulkanMesh.hpp"
+#include "GeometryPool.hpp"
+#include "MeshCache.hpp"
+#include "VulkanTexture.hpp"
 #include "VulkanContext.hpp"
 
+// Stable pointer to an asset that may still be streaming in, check IsReady before using its GPU data
+template <typename T>
+struct AssetHandle
+{
+  T *asset = nullptr;
+
+  bool IsReady() const { return asset && asset->IsReady(); }
+};
+
+using MeshHandle = AssetHandle<VulkanMesh>;
+using TextureHandle = AssetHandle<VulkanTexture>;
+
+// Capacity of the bindless texture array, a material index addresses one of its slots
+const uint32_t MAX_BINDLESS_TEXTURES = 1024;
+
 class AssetManager
 {
 public:
   void Init(VulkanContext *context);
+  // Goes through the binary mesh cache, the OBJ is only parsed when the cache is missing or stale
   VulkanMesh *LoadMesh(const std::string &name, const std::string &filepath);
   VulkanMesh *CreateQuad(const std::string &name, float size);
   VulkanMesh *GetMesh(const std::string &name);
+  // No entity may use the mesh anymore. Its table slot is cleared right away, the geometry is released
+  // GEOMETRY_RETIRE_FRAMES later and the pool is compacted when that leaves holes
+  void UnloadMesh(const std::string &name);
+  VulkanTexture *GetTexture(const std::string &name);
+  // Blocking load, the texture is sampleable by its material index right away
+  VulkanTexture *LoadTexture(const std::string &name, const std::string &filepath);
+
+  // Parse on a worker thread, upload on the transfer queue; the handle becomes ready on a later frame
+  MeshHandle LoadMeshAsync(const std::string &name, const std::string &filepath);
+  TextureHandle LoadTextureAsync(const std::string &name, const std::string &filepath);
+  // Once per frame: submits finished parses for upload, marks completed uploads ready and releases unloaded meshes
+  void Update();
+
+  // Set 1 of the material pipelines: one array of every loaded texture, indexed by material index in the shader
+  VkDescriptorSetLayout GetBindlessLayout() const { return mBindlessLayout; }
+  VkDescriptorSet GetBindlessSet() const { return mBindlessSet; }
+  // Material indices of textures still streaming in resolve to the default texture (index 0)
+  uint32_t ResolveMaterial(uint32_t materialIndex) const;
+  // Bumped whenever a streamed texture becomes ready, resolved material indices taken before are stale
+  uint32_t GetMaterialGeneration() const { return mMaterialGeneration; }
+  // Bumped whenever a streamed mesh becomes ready, bounds copied from it before are stale
+  uint32_t GetMeshGeneration() const { return mMeshGeneration; }
+
+  // Every mesh ever created, position is the mesh index. Unloaded meshes leave nullptr behind
+  std::span<VulkanMesh *const> GetMeshTable() const { return mMeshTable; }
+  const GeometryPool &GetGeometryPool() const { return mGeometry; }
+
   void Cleanup();
 
 private:
+  template <typename T, typename Data>
+  struct PendingLoad
+  {
+    T *asset;
+    std::future<Data> data;
+    uint64_t uploadValue = 0;
+  };
+
+  struct RetiredMesh
+  {
+    std::unique_ptr<VulkanMesh> mesh;
+    uint64_t frame;
+    // Upload still writing into its range, 0 when none was issued
+    uint64_t uploadValue;
+  };
+
   VulkanContext *mContext = nullptr;
+  GeometryPool mGeometry;
   std::unordered_map<std::string, std::unique_ptr<VulkanMesh>> mMeshes;
-};
\ No newline at end of file
+  std::unordered_map<std::string, std::unique_ptr<VulkanTexture>> mTextures;
+  std::vector<PendingLoad<VulkanMesh, MeshSource>> mPendingMeshes;
+  std::vector<PendingLoad<VulkanTexture, TextureData>> mPendingTextures;
+
+  // Partially bound and updated after bind: a slot is written once its texture is ready,
+  // frames in flight never sample it before that because ResolveMaterial hands them slot 0
+  VkDescriptorSetLayout mBindlessLayout = VK_NULL_HANDLE;
+  VkDescriptorPool mBindlessPool = VK_NULL_HANDLE;
+  VkDescriptorSet mBindlessSet = VK_NULL_HANDLE;
+  std::vector<VulkanTexture *> mBindlessTextures;
+  uint32_t mMaterialGeneration = 0;
+  uint32_t mMeshGeneration = 0;
+  std::vector<VulkanMesh *> mMeshTable;
+  std::vector<RetiredMesh> mRetiredMeshes;
+  uint64_t mFrame = 0;
+  // Set when a release left holes, the pool is compacted once no mesh upload is in flight
+  bool mDefragmentPending = false;
+
+  template <typename T, typename Data>
+  void UpdatePending(std::vector<PendingLoad<T, Data>> &pending);
+
+  VulkanMesh *AddMesh(const std::string &name, std::unique_ptr<VulkanMesh> mesh);
+  void ReleaseRetiredMeshes();
+  void DefragmentGeometry();
+  uint64_t StartUpload(VulkanMesh *mesh, const MeshSource &source) { return mesh->UploadAsync(mGeometry, source.View()); }
+  uint64_t StartUpload(VulkanTexture *texture, const TextureData &data) { return texture->UploadAsync(mContext, data); }
+  void CreateBindlessSet();
+  uint32_t AllocateBindlessSlot(VulkanTexture *texture);
+  void WriteBindlessSlot(const VulkanTexture *texture);
+  void OnReady(VulkanMesh *) { ++mMeshGeneration; }
+  void OnReady(VulkanTexture *texture)
+  {
+    WriteBindlessSlot(texture);
+    ++mMaterialGeneration;
+  }
+};
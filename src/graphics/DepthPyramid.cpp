@@ -0,0 +1,356 @@
+#include "DepthPyramid.hpp"
+#include <array>
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+void DepthPyramid::Init(VulkanContext *context, PipelineLibrary &pipelines)
+{
+  mContext = context;
+  mPipelines = &pipelines;
+
+  VkSamplerReductionModeCreateInfo reductionInfo{
+      .sType = VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO,
+      .reductionMode = VK_SAMPLER_REDUCTION_MODE_MAX,
+  };
+  // Without the feature the pyramid is still created for binding, but never built or sampled
+  VkSamplerCreateInfo samplerInfo{
+      .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+      .pNext = mContext->SupportsSamplerFilterMinmax() ? &reductionInfo : nullptr,
+      .magFilter = VK_FILTER_LINEAR,
+      .minFilter = VK_FILTER_LINEAR,
+      .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+      .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .minLod = 0.0f,
+      .maxLod = VK_LOD_CLAMP_NONE,
+  };
+  if (vkCreateSampler(mContext->GetDevice(), &samplerInfo, nullptr, &mSampler) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to create depth pyramid sampler");
+  }
+
+  std::array<VkDescriptorSetLayoutBinding, 2> bindings{{
+      {
+          .binding = 0,
+          .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+          .descriptorCount = 1,
+          .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+      },
+      {
+          .binding = 1,
+          .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+          .descriptorCount = 1,
+          .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+      },
+  }};
+  VkDescriptorSetLayoutCreateInfo layoutInfo{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+      .bindingCount = static_cast<uint32_t>(bindings.size()),
+      .pBindings = bindings.data(),
+  };
+  if (vkCreateDescriptorSetLayout(mContext->GetDevice(), &layoutInfo, nullptr, &mSetLayout) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to create depth pyramid descriptor set layout");
+  }
+
+  std::array<VkDescriptorPoolSize, 2> poolSizes{{
+      {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_DEPTH_PYRAMID_LEVELS},
+      {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MAX_DEPTH_PYRAMID_LEVELS},
+  }};
+  VkDescriptorPoolCreateInfo poolInfo{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+      .maxSets = MAX_DEPTH_PYRAMID_LEVELS,
+      .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+      .pPoolSizes = poolSizes.data(),
+  };
+  if (vkCreateDescriptorPool(mContext->GetDevice(), &poolInfo, nullptr, &mDescriptorPool) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to create depth pyramid descriptor pool");
+  }
+
+  // Fetched on the first build, the compile overlaps the rest of renderer setup
+  mPipelineDesc = {
+      .compFile = "shaders/depth_reduce.comp.spv",
+      .descriptorSetLayouts = {mSetLayout},
+      .pushConstantSize = sizeof(float) * 2,
+  };
+  mPipelines->Precompile(mPipelineDesc);
+}
+
+void DepthPyramid::Cleanup()
+{
+  if (!mContext)
+  {
+    return;
+  }
+
+  DestroyImage();
+  vkDestroyDescriptorPool(mContext->GetDevice(), mDescriptorPool, nullptr);
+  vkDestroyDescriptorSetLayout(mContext->GetDevice(), mSetLayout, nullptr);
+  vkDestroySampler(mContext->GetDevice(), mSampler, nullptr);
+  mPipeline = nullptr;
+  mContext = nullptr;
+}
+
+void DepthPyramid::DestroyImage()
+{
+  for (VkImageView view : mLevelViews)
+  {
+    vkDestroyImageView(mContext->GetDevice(), view, nullptr);
+  }
+  mLevelViews.clear();
+  mLevelSets.clear();
+  vkResetDescriptorPool(mContext->GetDevice(), mDescriptorPool, 0);
+
+  if (mImage != VK_NULL_HANDLE)
+  {
+    vkDestroyImageView(mContext->GetDevice(), mView, nullptr);
+    vmaDestroyImage(mContext->GetAllocator(), mImage, mAllocation);
+    mImage = VK_NULL_HANDLE;
+    mView = VK_NULL_HANDLE;
+  }
+}
+
+void DepthPyramid::Resize(VkExtent2D depthExtent, VkImageView depthView)
+{
+  DestroyImage();
+
+  // Powers of two halve exactly, every texel of a level covers 2x2 texels of the one above
+  mExtent = {std::bit_floor(std::max(depthExtent.width, 1u)), std::bit_floor(std::max(depthExtent.height, 1u))};
+  mLevelCount = std::bit_width(std::max(mExtent.width, mExtent.height));
+
+  VkImageCreateInfo imageInfo{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+      .imageType = VK_IMAGE_TYPE_2D,
+      .format = VK_FORMAT_R32_SFLOAT,
+      .extent = {mExtent.width, mExtent.height, 1},
+      .mipLevels = mLevelCount,
+      .arrayLayers = 1,
+      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .tiling = VK_IMAGE_TILING_OPTIMAL,
+      .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+      .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+      .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+  };
+  VmaAllocationCreateInfo allocInfo{
+      .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+  };
+  if (vmaCreateImage(mContext->GetAllocator(), &imageInfo, &allocInfo, &mImage, &mAllocation, nullptr) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to create depth pyramid image");
+  }
+
+  VkImageViewCreateInfo viewInfo{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+      .image = mImage,
+      .viewType = VK_IMAGE_VIEW_TYPE_2D,
+      .format = VK_FORMAT_R32_SFLOAT,
+      .subresourceRange = {
+          .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+          .baseMipLevel = 0,
+          .levelCount = mLevelCount,
+          .baseArrayLayer = 0,
+          .layerCount = 1,
+      },
+  };
+  if (vkCreateImageView(mContext->GetDevice(), &viewInfo, nullptr, &mView) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to create depth pyramid view");
+  }
+
+  mLevelViews.resize(mLevelCount);
+  for (uint32_t level = 0; level != mLevelCount; ++level)
+  {
+    viewInfo.subresourceRange.baseMipLevel = level;
+    viewInfo.subresourceRange.levelCount = 1;
+    if (vkCreateImageView(mContext->GetDevice(), &viewInfo, nullptr, &mLevelViews[level]) != VK_SUCCESS)
+    {
+      throw std::runtime_error("Failed to create depth pyramid level view");
+    }
+  }
+
+  std::vector<VkDescriptorSetLayout> layouts(mLevelCount, mSetLayout);
+  VkDescriptorSetAllocateInfo setInfo{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      .descriptorPool = mDescriptorPool,
+      .descriptorSetCount = mLevelCount,
+      .pSetLayouts = layouts.data(),
+  };
+  mLevelSets.resize(mLevelCount);
+  if (vkAllocateDescriptorSets(mContext->GetDevice(), &setInfo, mLevelSets.data()) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to allocate depth pyramid descriptor sets");
+  }
+
+  for (uint32_t level = 0; level != mLevelCount; ++level)
+  {
+    VkDescriptorImageInfo sourceInfo{
+        .sampler = mSampler,
+        .imageView = level == 0 ? depthView : mLevelViews[level - 1],
+        .imageLayout = level == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL,
+    };
+    VkDescriptorImageInfo destinationInfo{
+        .imageView = mLevelViews[level],
+        .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+    };
+    std::array<VkWriteDescriptorSet, 2> writes{{
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = mLevelSets[level],
+            .dstBinding = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo = &sourceInfo,
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = mLevelSets[level],
+            .dstBinding = 1,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .pImageInfo = &destinationInfo,
+        },
+    }};
+    vkUpdateDescriptorSets(mContext->GetDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+  }
+
+  // Sets that bind the pyramid without sampling it still expect the GENERAL layout
+  VkImageMemoryBarrier2 barrier{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+      .srcStageMask = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
+      .srcAccessMask = VK_ACCESS_2_NONE,
+      .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+      .dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+      .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+      .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+      .image = mImage,
+      .subresourceRange = viewInfo.subresourceRange,
+  };
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = mLevelCount;
+  VkDependencyInfo dependencyInfo{
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .imageMemoryBarrierCount = 1,
+      .pImageMemoryBarriers = &barrier,
+  };
+
+  VkCommandBuffer commandBuffer = mContext->BeginSingleTimeCommands();
+  vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+  mContext->EndSingleTimeCommands(commandBuffer);
+}
+
+void DepthPyramid::Build(VkCommandBuffer commandBuffer, VkImage depthImage)
+{
+  if (!mPipeline)
+  {
+    mPipeline = mPipelines->Get(mPipelineDesc);
+  }
+
+  VkImageSubresourceRange depthRange{
+      .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+      .baseMipLevel = 0,
+      .levelCount = 1,
+      .baseArrayLayer = 0,
+      .layerCount = 1,
+  };
+  VkImageSubresourceRange pyramidRange{
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .baseMipLevel = 0,
+      .levelCount = mLevelCount,
+      .baseArrayLayer = 0,
+      .layerCount = 1,
+  };
+
+  // The last frame's pyramid is discarded once the compute work that read it is done
+  std::array<VkImageMemoryBarrier2, 2> beginBarriers{{
+      {
+          .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+          .srcStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+          .srcAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+          .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+          .dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+          .oldLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+          .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+          .image = depthImage,
+          .subresourceRange = depthRange,
+      },
+      {
+          .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+          .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+          .srcAccessMask = VK_ACCESS_2_NONE,
+          .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+          .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+          .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+          .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+          .image = mImage,
+          .subresourceRange = pyramidRange,
+      },
+  }};
+  VkDependencyInfo beginDependency{
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .imageMemoryBarrierCount = static_cast<uint32_t>(beginBarriers.size()),
+      .pImageMemoryBarriers = beginBarriers.data(),
+  };
+  vkCmdPipelineBarrier2(commandBuffer, &beginDependency);
+
+  mPipeline->Bind(commandBuffer);
+
+  uint32_t width = mExtent.width;
+  uint32_t height = mExtent.height;
+  for (uint32_t level = 0; level != mLevelCount; ++level)
+  {
+    float size[2] = {static_cast<float>(width), static_cast<float>(height)};
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mPipeline->GetPipelineLayout(), 0, 1, &mLevelSets[level], 0, nullptr);
+    vkCmdPushConstants(commandBuffer, mPipeline->GetPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(size), size);
+    vkCmdDispatch(commandBuffer, (width + 7) / 8, (height + 7) / 8, 1);
+
+    // The next level and the cull shader read this one
+    VkImageMemoryBarrier2 levelBarrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .image = mImage,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = level,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    };
+    VkDependencyInfo levelDependency{
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .imageMemoryBarrierCount = 1,
+        .pImageMemoryBarriers = &levelBarrier,
+    };
+    vkCmdPipelineBarrier2(commandBuffer, &levelDependency);
+
+    width = std::max(width / 2, 1u);
+    height = std::max(height / 2, 1u);
+  }
+
+  // Later passes of the frame keep testing and writing depth
+  VkImageMemoryBarrier2 endBarrier{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+      .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+      .srcAccessMask = VK_ACCESS_2_NONE,
+      .dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+      .dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+      .oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+      .newLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+      .image = depthImage,
+      .subresourceRange = depthRange,
+  };
+  VkDependencyInfo endDependency{
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .imageMemoryBarrierCount = 1,
+      .pImageMemoryBarriers = &endBarrier,
+  };
+  vkCmdPipelineBarrier2(commandBuffer, &endDependency);
+}
\ No newline at end of file
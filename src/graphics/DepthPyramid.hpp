@@ -0,0 +1,47 @@
+#pragma once
+#include "VulkanContext.hpp"
+#include "PipelineLibrary.hpp"
+#include <vector>
+
+// Enough levels for a 65536 texel wide target
+const uint32_t MAX_DEPTH_PYRAMID_LEVELS = 16;
+
+// Hierarchical depth for occlusion culling: R32F levels built by compute from the depth buffer, every texel
+// holds the farthest depth below it. Level 0 is the depth extent rounded down to powers of two.
+// Sampled through a max reduction sampler, so one fetch covers a 2x2 footprint. Needs samplerFilterMinmax
+class DepthPyramid
+{
+public:
+  void Init(VulkanContext *context, PipelineLibrary &pipelines);
+  void Cleanup();
+  // Recreates the levels for a new depth buffer, no frame may still use the old ones
+  void Resize(VkExtent2D depthExtent, VkImageView depthView);
+
+  // Reduces the depth buffer into every level. Depth is expected in DEPTH_ATTACHMENT_OPTIMAL after its writes
+  // and left there, the pyramid ends in GENERAL visible to compute shader reads
+  void Build(VkCommandBuffer commandBuffer, VkImage depthImage);
+
+  // All levels, sample with GetSampler in GENERAL layout
+  VkImageView GetView() const { return mView; }
+  VkSampler GetSampler() const { return mSampler; }
+
+private:
+  VulkanContext *mContext = nullptr;
+  PipelineLibrary *mPipelines = nullptr;
+  ComputePipelineDesc mPipelineDesc;
+  VulkanPipeline *mPipeline = nullptr;
+  VkSampler mSampler = VK_NULL_HANDLE;
+  VkDescriptorSetLayout mSetLayout = VK_NULL_HANDLE;
+  VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
+
+  VkImage mImage = VK_NULL_HANDLE;
+  VmaAllocation mAllocation = VK_NULL_HANDLE;
+  VkImageView mView = VK_NULL_HANDLE;
+  VkExtent2D mExtent{};
+  uint32_t mLevelCount = 0;
+  // Per level: its own view to write and the set that reads the level above
+  std::vector<VkImageView> mLevelViews;
+  std::vector<VkDescriptorSet> mLevelSets;
+
+  void DestroyImage();
+};
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "GeometryPool.hpp"
+#include "VulkanContext.hpp"
+#include <stdexcept>
+
+void GeometryPool::Init(VulkanContext *context, uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+  mContext = context;
+  mVertexAllocator.Init(vertexCapacity);
+  mIndexAllocator.Init(indexCapacity);
+
+  CreateBuffers(mVertexBuffer, mIndexBuffer);
+}
+
+void GeometryPool::Cleanup()
+{
+  if (!mContext)
+  {
+    return;
+  }
+
+  for (auto &retired : mRetired)
+  {
+    retired.vertexBuffer.Destroy(mContext->GetAllocator());
+    retired.indexBuffer.Destroy(mContext->GetAllocator());
+  }
+  mRetired.clear();
+
+  mVertexBuffer.Destroy(mContext->GetAllocator());
+  mIndexBuffer.Destroy(mContext->GetAllocator());
+  mContext = nullptr;
+}
+
+void GeometryPool::CreateBuffers(VulkanBuffer &vertexBuffer, VulkanBuffer &indexBuffer)
+{
+  // Transfer source as well, defragmentation copies live ranges out of them
+  vertexBuffer.Create(mContext->GetAllocator(),
+                      sizeof(PackedVertex) * static_cast<VkDeviceSize>(mVertexAllocator.GetCapacity()),
+                      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                      VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+                      0,
+                      mContext->GetSharedQueueFamilies());
+
+  indexBuffer.Create(mContext->GetAllocator(),
+                     sizeof(uint32_t) * static_cast<VkDeviceSize>(mIndexAllocator.GetCapacity()),
+                     VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                     VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+                     0,
+                     mContext->GetSharedQueueFamilies());
+}
+
+GeometryRange GeometryPool::Allocate(uint32_t vertexCount, uint32_t indexCount)
+{
+  uint32_t vertexOffset = mVertexAllocator.Allocate(vertexCount);
+  if (vertexOffset == RangeAllocator::InvalidOffset)
+  {
+    throw std::runtime_error("Geometry pool is out of vertex space");
+  }
+
+  uint32_t firstIndex = mIndexAllocator.Allocate(indexCount);
+  if (firstIndex == RangeAllocator::InvalidOffset)
+  {
+    mVertexAllocator.Free(vertexOffset, vertexCount);
+    throw std::runtime_error("Geometry pool is out of index space");
+  }
+
+  return {vertexOffset, vertexCount, firstIndex, indexCount};
+}
+
+void GeometryPool::Free(const GeometryRange &range)
+{
+  mVertexAllocator.Free(range.vertexOffset, range.vertexCount);
+  mIndexAllocator.Free(range.firstIndex, range.indexCount);
+}
+
+void GeometryPool::Upload(const GeometryRange &range, std::span<const PackedVertex> vertices, std::span<const uint32_t> indices)
+{
+  mReadyValue = UploadAsync(range, vertices, indices);
+  mContext->GetUploader().Flush();
+}
+
+uint64_t GeometryPool::UploadAsync(const GeometryRange &range, std::span<const PackedVertex> vertices, std::span<const uint32_t> indices)
+{
+  VulkanUploader &uploader = mContext->GetUploader();
+  uploader.UploadBuffer(mVertexBuffer.GetBuffer(), sizeof(PackedVertex) * static_cast<VkDeviceSize>(range.vertexOffset),
+                        vertices.data(), sizeof(PackedVertex) * vertices.size());
+  return uploader.UploadBuffer(mIndexBuffer.GetBuffer(), sizeof(uint32_t) * static_cast<VkDeviceSize>(range.firstIndex),
+                               indices.data(), sizeof(uint32_t) * indices.size());
+}
+
+void GeometryPool::Defragment(std::span<GeometryRange *const> ranges)
+{
+  VulkanBuffer vertexBuffer;
+  VulkanBuffer indexBuffer;
+  CreateBuffers(vertexBuffer, indexBuffer);
+
+  mVertexAllocator.Init(mVertexAllocator.GetCapacity());
+  mIndexAllocator.Init(mIndexAllocator.GetCapacity());
+
+  std::vector<VkBufferCopy> vertexCopies;
+  std::vector<VkBufferCopy> indexCopies;
+  vertexCopies.reserve(ranges.size());
+  indexCopies.reserve(ranges.size());
+
+  // Ranges are taken in the order given, an empty allocator hands them out back to back
+  for (GeometryRange *range : ranges)
+  {
+    GeometryRange packed = Allocate(range->vertexCount, range->indexCount);
+
+    if (range->vertexCount != 0)
+    {
+      vertexCopies.push_back({
+          .srcOffset = sizeof(PackedVertex) * static_cast<VkDeviceSize>(range->vertexOffset),
+          .dstOffset = sizeof(PackedVertex) * static_cast<VkDeviceSize>(packed.vertexOffset),
+          .size = sizeof(PackedVertex) * static_cast<VkDeviceSize>(range->vertexCount),
+      });
+    }
+    if (range->indexCount != 0)
+    {
+      indexCopies.push_back({
+          .srcOffset = sizeof(uint32_t) * static_cast<VkDeviceSize>(range->firstIndex),
+          .dstOffset = sizeof(uint32_t) * static_cast<VkDeviceSize>(packed.firstIndex),
+          .size = sizeof(uint32_t) * static_cast<VkDeviceSize>(range->indexCount),
+      });
+    }
+
+    *range = packed;
+  }
+
+  // Reading the old buffers while frames in flight draw from them is fine, nothing writes them anymore
+  VulkanUploader &uploader = mContext->GetUploader();
+  uploader.CopyBuffer(mVertexBuffer.GetBuffer(), vertexBuffer.GetBuffer(), vertexCopies);
+  uint64_t copyValue = uploader.CopyBuffer(mIndexBuffer.GetBuffer(), indexBuffer.GetBuffer(), indexCopies);
+  uploader.Flush();
+  mReadyValue = copyValue;
+
+  mRetired.push_back({std::move(mVertexBuffer), std::move(mIndexBuffer), mFrame, copyValue});
+  mVertexBuffer = std::move(vertexBuffer);
+  mIndexBuffer = std::move(indexBuffer);
+}
+
+void GeometryPool::Update()
+{
+  ++mFrame;
+
+  VulkanUploader &uploader = mContext->GetUploader();
+  while (!mRetired.empty() && mFrame - mRetired.front().frame > GEOMETRY_RETIRE_FRAMES &&
+         uploader.IsComplete(mRetired.front().copyValue))
+  {
+    mRetired.front().vertexBuffer.Destroy(mContext->GetAllocator());
+    mRetired.front().indexBuffer.Destroy(mContext->GetAllocator());
+    mRetired.pop_front();
+  }
+}
\ No newline at end of file
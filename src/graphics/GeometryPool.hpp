@@ -0,0 +1,84 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include <span>
+#include <cstdint>
+#include "VulkanBuffer.hpp"
+#include "RangeAllocator.hpp"
+#include "Vertex.hpp"
+
+class VulkanContext;
+
+// Frames a released range or a replaced buffer stays untouched: every queued render snapshot
+// and every frame in flight may still read it, with some margin
+const uint32_t GEOMETRY_RETIRE_FRAMES = 8;
+
+// Where a mesh lives in the pool, in vertices and indices
+struct GeometryRange
+{
+  uint32_t vertexOffset = 0;
+  uint32_t vertexCount = 0;
+  uint32_t firstIndex = 0;
+  uint32_t indexCount = 0;
+};
+
+// Every mesh is a sub-allocated range of one device-local vertex buffer and one index buffer,
+// so a frame binds geometry once and draws address meshes through firstIndex and vertexOffset.
+class GeometryPool
+{
+public:
+  void Init(VulkanContext *context, uint32_t vertexCapacity = 4u * 1024 * 1024, uint32_t indexCapacity = 16u * 1024 * 1024);
+  void Cleanup();
+
+  // Throws when either buffer has no free block large enough
+  GeometryRange Allocate(uint32_t vertexCount, uint32_t indexCount);
+  // The caller makes sure no frame still reads the range
+  void Free(const GeometryRange &range);
+
+  // Submitted on the transfer queue right away. The host does not wait, frames drawing the range do (GetReadyValue)
+  void Upload(const GeometryRange &range, std::span<const PackedVertex> vertices, std::span<const uint32_t> indices);
+  // Records the copies on the transfer queue, returns the uploader timeline value that signals completion
+  uint64_t UploadAsync(const GeometryRange &range, std::span<const PackedVertex> vertices, std::span<const uint32_t> indices);
+
+  // Free space is split into holes that a large mesh may not fit into
+  bool IsFragmented() const { return mVertexAllocator.GetFragmented() != 0 || mIndexAllocator.GetFragmented() != 0; }
+  // Packs the given ranges to the start of fresh buffers and rewrites their offsets, ranges not listed are dropped.
+  // The moves are submitted on the uploader timeline, frames drawing from the new buffers wait for them on the GPU.
+  // The old buffers are kept for GEOMETRY_RETIRE_FRAMES and until the moves are done, frames recorded before keep
+  // drawing from them. No upload into the pool may be in flight.
+  void Defragment(std::span<GeometryRange *const> ranges);
+  // Once per frame, destroys buffers replaced by a defragmentation long enough ago
+  void Update();
+
+  // Uploader timeline value the current buffers and ranges are complete at, async uploads aside:
+  // their meshes are not drawn before they are ready
+  uint64_t GetReadyValue() const { return mReadyValue; }
+
+  VkBuffer GetVertexBuffer() const { return mVertexBuffer.GetBuffer(); }
+  VkBuffer GetIndexBuffer() const { return mIndexBuffer.GetBuffer(); }
+  uint32_t GetUsedVertices() const { return mVertexAllocator.GetUsed(); }
+  uint32_t GetUsedIndices() const { return mIndexAllocator.GetUsed(); }
+
+private:
+  struct RetiredBuffers
+  {
+    VulkanBuffer vertexBuffer;
+    VulkanBuffer indexBuffer;
+    uint64_t frame;
+    // Moves reading out of these buffers
+    uint64_t copyValue;
+  };
+
+  VulkanContext *mContext = nullptr;
+  VulkanBuffer mVertexBuffer;
+  VulkanBuffer mIndexBuffer;
+  RangeAllocator mVertexAllocator;
+  RangeAllocator mIndexAllocator;
+
+  std::deque<RetiredBuffers> mRetired;
+  uint64_t mFrame = 0;
+  uint64_t mReadyValue = 0;
+
+  void CreateBuffers(VulkanBuffer &vertexBuffer, VulkanBuffer &indexBuffer);
+};
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "MeshCache.hpp"
+#include "MeshImporter.hpp"
+#include "../core/Logger.hpp"
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <cstdio>
+
+static_assert(sizeof(MeshCache::Header) % alignof(PackedVertex) == 0, "Vertex array must stay aligned after the header");
+
+MeshSource MeshCache::LoadOrImport(const std::string &sourcePath)
+{
+  MeshSource source;
+
+  uint64_t stamp = GetSourceStamp(sourcePath);
+  std::string cachePath = GetCachePath(sourcePath);
+
+  if (stamp != 0 && source.mapped.Open(cachePath))
+  {
+    if (auto view = Read(source.mapped, stamp))
+    {
+      source.mappedView = *view;
+      return source;
+    }
+    source.mapped.Close();
+  }
+
+  source.imported = MeshImporter::ImportObj(sourcePath);
+
+  if (stamp != 0 && !Write(cachePath, stamp, source.imported))
+  {
+    Logger::Log(LogLevel::Warning, "Failed to write mesh cache: " + cachePath);
+  }
+
+  return source;
+}
+
+std::string MeshCache::GetCachePath(const std::string &sourcePath)
+{
+  // FNV-1a of the source path keeps files with the same name in different folders apart
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : sourcePath)
+  {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ull;
+  }
+
+  char hashText[17];
+  std::snprintf(hashText, sizeof(hashText), "%016llx", static_cast<unsigned long long>(hash));
+
+  std::filesystem::path stem = std::filesystem::path(sourcePath).stem();
+  return (std::filesystem::path(CacheDirectory) / (stem.string() + "-" + hashText + ".amesh")).string();
+}
+
+uint64_t MeshCache::GetSourceStamp(const std::string &sourcePath)
+{
+  std::error_code error;
+  auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+  if (error)
+  {
+    return 0;
+  }
+
+  return static_cast<uint64_t>(writeTime.time_since_epoch().count());
+}
+
+std::optional<MeshView> MeshCache::Read(const MappedFile &file, uint64_t sourceStamp)
+{
+  if (file.GetSize() < sizeof(Header))
+  {
+    return std::nullopt;
+  }
+
+  const Header *header = reinterpret_cast<const Header *>(file.GetData());
+  if (header->magic != Magic || header->version != Version || header->sourceStamp != sourceStamp)
+  {
+    return std::nullopt;
+  }
+
+  size_t vertexBytes = sizeof(PackedVertex) * header->vertexCount;
+  size_t indexBytes = sizeof(uint32_t) * header->indexCount;
+  size_t lodBytes = sizeof(MeshLod) * header->lodCount;
+  if (file.GetSize() != sizeof(Header) + vertexBytes + indexBytes + lodBytes || header->lodCount > MAX_MESH_LODS)
+  {
+    return std::nullopt;
+  }
+
+  const PackedVertex *vertices = reinterpret_cast<const PackedVertex *>(file.GetData() + sizeof(Header));
+  const uint32_t *indices = reinterpret_cast<const uint32_t *>(file.GetData() + sizeof(Header) + vertexBytes);
+  const MeshLod *lods = reinterpret_cast<const MeshLod *>(file.GetData() + sizeof(Header) + vertexBytes + indexBytes);
+
+  MeshView view;
+  view.vertices = {vertices, header->vertexCount};
+  view.indices = {indices, header->indexCount};
+  view.lods = {lods, header->lodCount};
+  view.boundsMin = {header->boundsMin[0], header->boundsMin[1], header->boundsMin[2]};
+  view.boundsMax = {header->boundsMax[0], header->boundsMax[1], header->boundsMax[2]};
+  view.boundingSphere = {header->boundingSphere[0], header->boundingSphere[1], header->boundingSphere[2], header->boundingSphere[3]};
+
+  return view;
+}
+
+bool MeshCache::Write(const std::string &cachePath, uint64_t sourceStamp, const MeshData &data)
+{
+  std::error_code error;
+  std::filesystem::path path(cachePath);
+  std::filesystem::create_directories(path.parent_path(), error);
+  if (error)
+  {
+    return false;
+  }
+
+  Header header{
+      .magic = Magic,
+      .version = Version,
+      .sourceStamp = sourceStamp,
+      .vertexCount = static_cast<uint32_t>(data.packedVertices.size()),
+      .indexCount = static_cast<uint32_t>(data.indices.size()),
+      .lodCount = static_cast<uint32_t>(data.lods.size()),
+      .boundsMin = {data.boundsMin.x, data.boundsMin.y, data.boundsMin.z},
+      .boundsMax = {data.boundsMax.x, data.boundsMax.y, data.boundsMax.z},
+      .boundingSphere = {data.boundingSphere.x, data.boundingSphere.y, data.boundingSphere.z, data.boundingSphere.w},
+  };
+
+  // Write next to the target and rename, a concurrent reader never maps a half written file
+  std::filesystem::path tempPath = path;
+  tempPath += ".tmp";
+
+  {
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+      return false;
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(data.packedVertices.data()), sizeof(PackedVertex) * data.packedVertices.size());
+    file.write(reinterpret_cast<const char *>(data.indices.data()), sizeof(uint32_t) * data.indices.size());
+    file.write(reinterpret_cast<const char *>(data.lods.data()), sizeof(MeshLod) * data.lods.size());
+
+    if (!file)
+    {
+      return false;
+    }
+  }
+
+  std::filesystem::rename(tempPath, path, error);
+  if (error)
+  {
+    std::filesystem::remove(tempPath, error);
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include <optional>
+#include <cstdint>
+#include "MeshData.hpp"
+#include "../core/MappedFile.hpp"
+
+// Geometry of one mesh file, either freshly imported or mapped straight from the cache
+struct MeshSource
+{
+  MeshData imported;
+  MappedFile mapped;
+  MeshView mappedView;
+
+  MeshView View() const
+  {
+    return mapped.IsOpen() ? mappedView : imported.View();
+  }
+};
+
+// Binary mesh cache: a fixed header followed by the PackedVertex array, the indices of all LODs and the LOD table,
+// laid out so a mapped file is uploaded without any parsing or copying.
+// One file per source path, it is rewritten whenever the source mtime no longer matches the header.
+class MeshCache
+{
+public:
+  static constexpr uint32_t Magic = 0x48534D41; // "AMSH"
+  static constexpr uint32_t Version = 4;
+
+  struct Header
+  {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceStamp;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t lodCount;
+    float boundsMin[3];
+    float boundsMax[3];
+    float boundingSphere[4];
+  };
+
+  // Maps the cache when it is valid for the source, otherwise imports the OBJ and writes a new cache.
+  // Touches no Vulkan state so it can run on any thread
+  static MeshSource LoadOrImport(const std::string &sourcePath);
+
+  static std::string GetCachePath(const std::string &sourcePath);
+  // Source mtime, 0 when the file can not be queried
+  static uint64_t GetSourceStamp(const std::string &sourcePath);
+
+  static std::optional<MeshView> Read(const MappedFile &file, uint64_t sourceStamp);
+  static bool Write(const std::string &cachePath, uint64_t sourceStamp, const MeshData &data);
+
+private:
+  static constexpr const char *CacheDirectory = "cache/meshes";
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "Vertex.hpp"
+
+const uint32_t MAX_MESH_LODS = 4;
+
+// Index range of one detail level, all levels share the vertex array
+struct MeshLod
+{
+  uint32_t firstIndex;
+  uint32_t indexCount;
+  // Object space deviation from the full mesh, picks the level for a projected size
+  float error;
+};
+
+// Non-owning geometry passed to uploads, backed either by MeshData or by a mapped cache file.
+// Positions are quantized to the AABB, so the bounds are needed to draw it
+struct MeshView
+{
+  std::span<const PackedVertex> vertices;
+  // Every LOD back to back, empty lods means one level covering all indices
+  std::span<const uint32_t> indices;
+  std::span<const MeshLod> lods;
+  glm::vec3 boundsMin{0.0f};
+  glm::vec3 boundsMax{0.0f};
+  // Center in xyz, radius in w
+  glm::vec4 boundingSphere{0.0f};
+};
+
+// CPU-side geometry ready for upload, produced by importers off the render thread
+struct MeshData
+{
+  std::vector<Vertex> vertices;
+  // GPU copy of vertices, filled by PackVertices once processing is done
+  std::vector<PackedVertex> packedVertices;
+  std::vector<uint32_t> indices;
+  std::vector<MeshLod> lods;
+  glm::vec3 boundsMin{0.0f};
+  glm::vec3 boundsMax{0.0f};
+  glm::vec4 boundingSphere{0.0f};
+
+  void ComputeBounds()
+  {
+    if (vertices.empty())
+    {
+      boundsMin = boundsMax = glm::vec3(0.0f);
+      boundingSphere = glm::vec4(0.0f);
+      return;
+    }
+
+    boundsMin = boundsMax = vertices[0].pos;
+    for (const Vertex &vertex : vertices)
+    {
+      boundsMin = glm::min(boundsMin, vertex.pos);
+      boundsMax = glm::max(boundsMax, vertex.pos);
+    }
+
+    // Centered on the AABB, the radius reaches the farthest vertex instead of the AABB corner
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    float radiusSq = 0.0f;
+    for (const Vertex &vertex : vertices)
+    {
+      glm::vec3 offset = vertex.pos - center;
+      radiusSq = std::max(radiusSq, glm::dot(offset, offset));
+    }
+    boundingSphere = glm::vec4(center, std::sqrt(radiusSq));
+  }
+
+  // Call after ComputeBounds
+  void PackVertices()
+  {
+    packedVertices.resize(vertices.size());
+    for (size_t i = 0; i != vertices.size(); ++i)
+    {
+      packedVertices[i] = PackedVertex::Pack(vertices[i], boundsMin, boundsMax);
+    }
+  }
+
+  MeshView View() const
+  {
+    return {packedVertices, indices, lods, boundsMin, boundsMax, boundingSphere};
+  }
+};
@@ -0,0 +1,298 @@
+#include "MeshImporter.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshOptimizer.hpp"
+#include "../core/Logger.hpp"
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <stdexcept>
+#include <cstdio>
+
+namespace
+{
+  // Below this many corners thread startup costs more than the dedupe itself
+  constexpr size_t ParallelThreshold = 1 << 16;
+  constexpr uint32_t EmptySlot = UINT32_MAX;
+
+  Vertex MakeVertex(const tinyobj::attrib_t &attrib, const tinyobj::index_t &index)
+  {
+    Vertex vertex{};
+
+    vertex.pos = {
+        attrib.vertices[3 * index.vertex_index + 0],
+        attrib.vertices[3 * index.vertex_index + 1],
+        attrib.vertices[3 * index.vertex_index + 2],
+    };
+
+    if (index.texcoord_index >= 0)
+    {
+      vertex.texCoord = {
+          attrib.texcoords[2 * index.texcoord_index + 0],
+          1.0f - attrib.texcoords[2 * index.texcoord_index + 1],
+      };
+    }
+
+    vertex.color = {1.0f, 1.0f, 1.0f};
+
+    return vertex;
+  }
+
+  bool SameVertex(const tinyobj::attrib_t &attrib, const tinyobj::index_t &a, const tinyobj::index_t &b)
+  {
+    // Same attribute indices is the common case, only distinct indices need the values compared
+    if (a.vertex_index == b.vertex_index && a.texcoord_index == b.texcoord_index)
+    {
+      return true;
+    }
+    return MakeVertex(attrib, a) == MakeVertex(attrib, b);
+  }
+
+  // Calls fn(begin, end, chunk) for chunkCount contiguous ranges of [0, count), the calling thread takes chunk 0
+  template <typename Fn>
+  void ParallelChunks(size_t count, size_t chunkCount, Fn &&fn)
+  {
+    size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    std::vector<std::future<void>> workers;
+    workers.reserve(chunkCount);
+
+    for (size_t chunk = 1; chunk < chunkCount; ++chunk)
+    {
+      workers.push_back(std::async(std::launch::async, [&, chunk]()
+                                   { fn(std::min(count, chunk * chunkSize), std::min(count, (chunk + 1) * chunkSize), chunk); }));
+    }
+
+    fn(0, std::min(count, chunkSize), 0);
+
+    for (auto &worker : workers)
+    {
+      worker.get();
+    }
+  }
+
+  struct Slot
+  {
+    uint32_t corner;
+    uint32_t tag;
+  };
+}
+
+MeshData MeshImporter::LoadObjGeometry(const std::string &filepath, uint32_t requestedThreads)
+{
+  tinyobj::attrib_t attrib;
+  std::vector<tinyobj::shape_t> shapes;
+  std::vector<tinyobj::material_t> materials;
+  std::string warn, err;
+
+  if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str()))
+  {
+    throw std::runtime_error(warn + err);
+  }
+
+  std::vector<tinyobj::index_t> corners;
+  size_t cornerCount = 0;
+  for (const auto &shape : shapes)
+  {
+    cornerCount += shape.mesh.indices.size();
+  }
+  corners.reserve(cornerCount);
+  for (const auto &shape : shapes)
+  {
+    corners.insert(corners.end(), shape.mesh.indices.begin(), shape.mesh.indices.end());
+  }
+
+  MeshData data;
+  if (cornerCount == 0)
+  {
+    return data;
+  }
+
+  if (cornerCount >= EmptySlot)
+  {
+    throw std::runtime_error("Mesh has too many indices: " + filepath);
+  }
+
+  size_t threadCount = requestedThreads;
+  if (threadCount == 0)
+  {
+    threadCount = cornerCount >= ParallelThreshold ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+  }
+  // One hash table shard per thread, a vertex always lands in the shard picked by its hash
+  size_t shardCount = threadCount;
+
+  // 1. Hash every corner and count shard occupancy per chunk
+  std::vector<uint64_t> hashes(cornerCount);
+  std::vector<uint32_t> chunkShardCounts(threadCount * shardCount, 0);
+
+  auto shardOf = [shardCount](uint64_t hash)
+  {
+    return static_cast<size_t>((hash >> 40) % shardCount);
+  };
+
+  ParallelChunks(cornerCount, threadCount, [&](size_t begin, size_t end, size_t chunk)
+                 {
+    uint32_t *counts = &chunkShardCounts[chunk * shardCount];
+    for (size_t i = begin; i != end; ++i)
+    {
+      hashes[i] = Vertex::computeHash(MakeVertex(attrib, corners[i]));
+      ++counts[shardOf(hashes[i])];
+    } });
+
+  // 2. Stable counting sort of corner ids by shard, each shard list stays in ascending corner order
+  std::vector<uint32_t> shardStart(shardCount + 1, 0);
+  std::vector<uint32_t> chunkShardOffsets(threadCount * shardCount);
+  uint32_t offset = 0;
+  for (size_t shard = 0; shard != shardCount; ++shard)
+  {
+    shardStart[shard] = offset;
+    for (size_t chunk = 0; chunk != threadCount; ++chunk)
+    {
+      chunkShardOffsets[chunk * shardCount + shard] = offset;
+      offset += chunkShardCounts[chunk * shardCount + shard];
+    }
+  }
+  shardStart[shardCount] = offset;
+
+  std::vector<uint32_t> shardCorners(cornerCount);
+  ParallelChunks(cornerCount, threadCount, [&](size_t begin, size_t end, size_t chunk)
+                 {
+    uint32_t *offsets = &chunkShardOffsets[chunk * shardCount];
+    for (size_t i = begin; i != end; ++i)
+    {
+      shardCorners[offsets[shardOf(hashes[i])]++] = static_cast<uint32_t>(i);
+    } });
+
+  // 3. Dedupe each shard in its own open-addressing table, first[i] is the first corner equal to corner i
+  std::vector<uint32_t> first(cornerCount);
+  ParallelChunks(shardCount, threadCount, [&](size_t begin, size_t end, size_t)
+                 {
+    std::vector<Slot> table;
+    for (size_t shard = begin; shard != end; ++shard)
+    {
+      // Models reuse vertices heavily, start small and grow at half load instead of sizing for every corner
+      size_t mask = 1023;
+      size_t used = 0;
+      table.assign(mask + 1, Slot{EmptySlot, 0});
+
+      for (uint32_t s = shardStart[shard]; s != shardStart[shard + 1]; ++s)
+      {
+        uint32_t corner = shardCorners[s];
+        uint64_t hash = hashes[corner];
+        uint32_t tag = static_cast<uint32_t>(hash >> 32);
+        const tinyobj::index_t &index = corners[corner];
+
+        size_t slot = hash & mask;
+        while (true)
+        {
+          Slot &entry = table[slot];
+          if (entry.corner == EmptySlot)
+          {
+            entry = {corner, tag};
+            first[corner] = corner;
+            ++used;
+            break;
+          }
+          if (entry.tag == tag && SameVertex(attrib, corners[entry.corner], index))
+          {
+            first[corner] = entry.corner;
+            break;
+          }
+          slot = (slot + 1) & mask;
+        }
+
+        if (used * 2 > mask)
+        {
+          std::vector<Slot> grown((mask + 1) * 2, Slot{EmptySlot, 0});
+          mask = grown.size() - 1;
+          for (const Slot &entry : table)
+          {
+            if (entry.corner == EmptySlot)
+            {
+              continue;
+            }
+            size_t target = hashes[entry.corner] & mask;
+            while (grown[target].corner != EmptySlot)
+            {
+              target = (target + 1) & mask;
+            }
+            grown[target] = entry;
+          }
+          table.swap(grown);
+        }
+      }
+    } });
+
+  // 4. Number unique vertices in corner order: per chunk counts, prefix sum, then assign
+  std::vector<uint32_t> chunkUnique(threadCount + 1, 0);
+  ParallelChunks(cornerCount, threadCount, [&](size_t begin, size_t end, size_t chunk)
+                 {
+    uint32_t unique = 0;
+    for (size_t i = begin; i != end; ++i)
+    {
+      unique += first[i] == i;
+    }
+    chunkUnique[chunk + 1] = unique; });
+
+  for (size_t chunk = 1; chunk <= threadCount; ++chunk)
+  {
+    chunkUnique[chunk] += chunkUnique[chunk - 1];
+  }
+
+  data.vertices.resize(chunkUnique[threadCount]);
+  data.indices.resize(cornerCount);
+
+  // The shard lists are no longer needed, reuse them as the corner -> vertex id map
+  std::vector<uint32_t> &vertexIds = shardCorners;
+  ParallelChunks(cornerCount, threadCount, [&](size_t begin, size_t end, size_t chunk)
+                 {
+    uint32_t next = chunkUnique[chunk];
+    for (size_t i = begin; i != end; ++i)
+    {
+      if (first[i] == i)
+      {
+        vertexIds[i] = next;
+        data.vertices[next] = MakeVertex(attrib, corners[i]);
+        ++next;
+      }
+    } });
+
+  // first[i] <= i, but it can sit in another chunk, so indices are resolved after all ids exist
+  ParallelChunks(cornerCount, threadCount, [&](size_t begin, size_t end, size_t)
+                 {
+    for (size_t i = begin; i != end; ++i)
+    {
+      data.indices[i] = vertexIds[first[i]];
+    } });
+
+  return data;
+}
+
+MeshData MeshImporter::ImportObj(const std::string &filepath)
+{
+  MeshData data = LoadObjGeometry(filepath);
+  if (data.indices.empty())
+  {
+    return data;
+  }
+
+  data.ComputeBounds();
+  MeshSimplifier::BuildLods(data);
+
+  std::span<const uint32_t> fullLod(data.indices.data(), data.lods[0].indexCount);
+  float acmrBefore = MeshOptimizer::ComputeAcmr(fullLod, data.vertices.size());
+  MeshOptimizer::Optimize(data);
+  float acmrAfter = MeshOptimizer::ComputeAcmr(fullLod, data.vertices.size());
+
+  data.PackVertices();
+
+  char stats[256];
+  std::snprintf(stats, sizeof(stats), "%s: %zu vertices, %zu -> %zu KB vertex data, ACMR %.3f -> %.3f (%.0f%% fewer vertex shader invocations)",
+                filepath.c_str(), data.vertices.size(),
+                sizeof(Vertex) * data.vertices.size() / 1024, sizeof(PackedVertex) * data.packedVertices.size() / 1024,
+                acmrBefore, acmrAfter, acmrBefore > 0.0f ? 100.0f * (1.0f - acmrAfter / acmrBefore) : 0.0f);
+  Logger::Log(LogLevel::Info, stats);
+
+  return data;
+}
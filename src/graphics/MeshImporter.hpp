@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+#include "MeshData.hpp"
+
+// Turns source model files into indexed, deduplicated geometry.
+// Large meshes are hashed and deduplicated on all cores, the output is identical to a serial
+// first-occurrence dedupe: vertex order and indices do not depend on the thread count.
+// The LOD chain, cache ordering and vertex packing happen here too, so they are cached along with the geometry.
+class MeshImporter
+{
+public:
+  static MeshData ImportObj(const std::string &filepath);
+  // Only the deduplicated vertices and indices, before LODs and optimization. threadCount 0 uses
+  // every hardware thread for large meshes and the calling thread for small ones
+  static MeshData LoadObjGeometry(const std::string &filepath, uint32_t threadCount = 0);
+};
@@ -0,0 +1,175 @@
+#include "MeshOptimizer.hpp"
+#include <vector>
+#include <algorithm>
+
+void MeshOptimizer::OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+{
+  size_t triangleCount = indices.size() / 3;
+  if (triangleCount == 0)
+  {
+    return;
+  }
+
+  // Triangles of every vertex, CSR layout
+  std::vector<uint32_t> liveTriangles(vertexCount, 0);
+  for (uint32_t index : indices)
+  {
+    ++liveTriangles[index];
+  }
+
+  std::vector<uint32_t> adjacencyStart(vertexCount + 1, 0);
+  for (size_t v = 0; v != vertexCount; ++v)
+  {
+    adjacencyStart[v + 1] = adjacencyStart[v] + liveTriangles[v];
+  }
+
+  std::vector<uint32_t> adjacency(indices.size());
+  std::vector<uint32_t> cursor(adjacencyStart.begin(), adjacencyStart.end() - 1);
+  for (size_t i = 0; i != indices.size(); ++i)
+  {
+    adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+  }
+
+  std::vector<uint32_t> cacheTime(vertexCount, 0);
+  std::vector<bool> emitted(triangleCount, false);
+  std::vector<uint32_t> deadEnd;
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> output;
+  output.reserve(indices.size());
+
+  // Timestamps start past the cache size, so no vertex counts as cached before it is used
+  uint32_t time = cacheSize + 1;
+  size_t scan = 0;
+  int64_t fanning = 0;
+
+  while (fanning >= 0)
+  {
+    candidates.clear();
+
+    for (uint32_t a = adjacencyStart[fanning]; a != adjacencyStart[fanning + 1]; ++a)
+    {
+      uint32_t triangle = adjacency[a];
+      if (emitted[triangle])
+      {
+        continue;
+      }
+
+      for (uint32_t k = 0; k != 3; ++k)
+      {
+        uint32_t v = indices[triangle * 3 + k];
+        output.push_back(v);
+        deadEnd.push_back(v);
+        candidates.push_back(v);
+        --liveTriangles[v];
+
+        if (time - cacheTime[v] > cacheSize)
+        {
+          cacheTime[v] = time++;
+        }
+      }
+      emitted[triangle] = true;
+    }
+
+    // Next fan: the candidate that stays in cache for all of its remaining triangles and entered it earliest
+    fanning = -1;
+    int64_t bestPriority = -1;
+    for (uint32_t v : candidates)
+    {
+      if (liveTriangles[v] == 0)
+      {
+        continue;
+      }
+
+      int64_t priority = 0;
+      if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+      {
+        priority = time - cacheTime[v];
+      }
+      if (priority > bestPriority)
+      {
+        bestPriority = priority;
+        fanning = v;
+      }
+    }
+
+    // Dead end: back up through recently used vertices, then scan for any vertex with triangles left
+    while (fanning < 0 && !deadEnd.empty())
+    {
+      uint32_t v = deadEnd.back();
+      deadEnd.pop_back();
+      if (liveTriangles[v] != 0)
+      {
+        fanning = v;
+      }
+    }
+    while (fanning < 0 && scan < vertexCount)
+    {
+      if (liveTriangles[scan] != 0)
+      {
+        fanning = static_cast<int64_t>(scan);
+      }
+      ++scan;
+    }
+  }
+
+  std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void MeshOptimizer::Optimize(MeshData &data)
+{
+  if (data.lods.empty())
+  {
+    data.lods.push_back({0, static_cast<uint32_t>(data.indices.size()), 0.0f});
+  }
+
+  for (const MeshLod &lod : data.lods)
+  {
+    OptimizeVertexCache(std::span<uint32_t>(data.indices).subspan(lod.firstIndex, lod.indexCount), data.vertices.size());
+  }
+
+  // First use in LOD 0 decides the order, coarser levels only use a subset of its vertices
+  constexpr uint32_t Unassigned = UINT32_MAX;
+  std::vector<uint32_t> remap(data.vertices.size(), Unassigned);
+  uint32_t next = 0;
+  for (uint32_t &index : data.indices)
+  {
+    if (remap[index] == Unassigned)
+    {
+      remap[index] = next++;
+    }
+    index = remap[index];
+  }
+
+  std::vector<Vertex> vertices(next);
+  for (size_t v = 0; v != remap.size(); ++v)
+  {
+    // Vertices no triangle uses are dropped
+    if (remap[v] != Unassigned)
+    {
+      vertices[remap[v]] = data.vertices[v];
+    }
+  }
+  data.vertices.swap(vertices);
+}
+
+float MeshOptimizer::ComputeAcmr(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+{
+  if (indices.size() < 3)
+  {
+    return 0.0f;
+  }
+
+  // FIFO: a vertex is cached while fewer than cacheSize misses happened since its own miss
+  std::vector<uint32_t> missTime(vertexCount, 0);
+  uint32_t misses = 0;
+  for (uint32_t index : indices)
+  {
+    if (missTime[index] == 0 || misses - missTime[index] >= cacheSize)
+    {
+      ++misses;
+      missTime[index] = misses;
+    }
+  }
+
+  return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
\ No newline at end of file
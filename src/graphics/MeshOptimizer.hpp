@@ -0,0 +1,22 @@
+#pragma once
+#include <span>
+#include <cstdint>
+#include "MeshData.hpp"
+
+// Index and vertex ordering for the GPU's post-transform cache and vertex fetch
+class MeshOptimizer
+{
+public:
+  static constexpr uint32_t CacheSize = 16;
+
+  // Tipsify (Sander et al. 2007): fans around recently used vertices, a triangle order that keeps
+  // reused vertices in a FIFO cache of cacheSize. Linear in the triangle count
+  static void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize = CacheSize);
+
+  // Orders every LOD's triangles with OptimizeVertexCache, then renumbers vertices by first use so
+  // vertex fetch walks memory forward
+  static void Optimize(MeshData &data);
+
+  // Average cache miss ratio: transformed vertices per triangle with a FIFO cache, 0.5 is the ideal for large meshes
+  static float ComputeAcmr(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = CacheSize);
+};
\ No newline at end of file
@@ -0,0 +1,321 @@
+#include "MeshSimplifier.hpp"
+#include <unordered_map>
+#include <queue>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  // Each level aims for this fraction of the previous one's triangles
+  constexpr float LodReduction = 0.5f;
+  // A level that could not get below this fraction of the previous one is dropped, the rest is locked
+  constexpr float MinLodReduction = 0.85f;
+  constexpr uint32_t MinLodTriangles = 32;
+
+  // Symmetric 4x4 plane quadric, upper triangle row by row, weighted by triangle area
+  struct Quadric
+  {
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+    double weight = 0;
+
+    static Quadric FromPlane(const glm::dvec3 &n, double d, double weight)
+    {
+      return {
+          n.x * n.x * weight, n.x * n.y * weight, n.x * n.z * weight, n.x * d * weight,
+          n.y * n.y * weight, n.y * n.z * weight, n.y * d * weight,
+          n.z * n.z * weight, n.z * d * weight,
+          d * d * weight,
+          weight};
+    }
+
+    Quadric &operator+=(const Quadric &q)
+    {
+      a00 += q.a00, a01 += q.a01, a02 += q.a02, a03 += q.a03;
+      a11 += q.a11, a12 += q.a12, a13 += q.a13;
+      a22 += q.a22, a23 += q.a23;
+      a33 += q.a33;
+      weight += q.weight;
+      return *this;
+    }
+
+    // Mean squared distance of p to the accumulated planes
+    double Evaluate(const glm::vec3 &point) const
+    {
+      double x = point.x, y = point.y, z = point.z;
+      double error = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x +
+                     a11 * y * y + 2 * a12 * y * z + 2 * a13 * y +
+                     a22 * z * z + 2 * a23 * z +
+                     a33;
+      return weight > 0.0 ? std::max(error, 0.0) / weight : 0.0;
+    }
+  };
+
+  struct Collapse
+  {
+    double cost;
+    uint32_t from;
+    uint32_t to;
+
+    bool operator>(const Collapse &other) const { return cost > other.cost; }
+  };
+
+  glm::vec3 TriangleNormal(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c)
+  {
+    return glm::cross(b - a, c - a);
+  }
+}
+
+void MeshSimplifier::BuildLods(MeshData &data)
+{
+  uint32_t triangleCount = static_cast<uint32_t>(data.indices.size() / 3);
+  data.lods.clear();
+  data.lods.push_back({0, static_cast<uint32_t>(data.indices.size()), 0.0f});
+
+  if (triangleCount < MinLodTriangles * 2)
+  {
+    return;
+  }
+
+  const std::vector<Vertex> &vertices = data.vertices;
+  size_t vertexCount = vertices.size();
+  std::vector<uint32_t> triangles(data.indices.begin(), data.indices.end());
+  std::vector<bool> triangleAlive(triangleCount, true);
+
+  // Vertices with equal positions but different attributes sit on a seam
+  std::unordered_map<glm::vec3, uint32_t> positionIds;
+  std::vector<uint32_t> weld(vertexCount);
+  std::vector<uint32_t> weldCount;
+  for (size_t i = 0; i != vertexCount; ++i)
+  {
+    // Adding +0 folds -0 into 0, equal keys must hash equal
+    auto [it, inserted] = positionIds.try_emplace(vertices[i].pos + glm::vec3(0.0f), static_cast<uint32_t>(weldCount.size()));
+    if (inserted)
+    {
+      weldCount.push_back(0);
+    }
+    weld[i] = it->second;
+    ++weldCount[it->second];
+  }
+
+  std::vector<bool> locked(vertexCount, false);
+  for (size_t i = 0; i != vertexCount; ++i)
+  {
+    locked[i] = weldCount[weld[i]] > 1;
+  }
+
+  // Edges of the welded surface used by one triangle are open borders, more than two is non-manifold
+  std::unordered_map<uint64_t, uint32_t> edgeUses;
+  auto edgeKey = [&](uint32_t a, uint32_t b)
+  {
+    uint64_t wa = weld[a], wb = weld[b];
+    return wa < wb ? (wa << 32) | wb : (wb << 32) | wa;
+  };
+  for (uint32_t t = 0; t != triangleCount; ++t)
+  {
+    for (uint32_t e = 0; e != 3; ++e)
+    {
+      ++edgeUses[edgeKey(triangles[t * 3 + e], triangles[t * 3 + (e + 1) % 3])];
+    }
+  }
+  for (uint32_t t = 0; t != triangleCount; ++t)
+  {
+    for (uint32_t e = 0; e != 3; ++e)
+    {
+      uint32_t a = triangles[t * 3 + e];
+      uint32_t b = triangles[t * 3 + (e + 1) % 3];
+      if (edgeUses[edgeKey(a, b)] != 2)
+      {
+        locked[a] = locked[b] = true;
+      }
+    }
+  }
+
+  std::vector<Quadric> quadrics(vertexCount);
+  std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+  for (uint32_t t = 0; t != triangleCount; ++t)
+  {
+    const uint32_t *tri = &triangles[t * 3];
+    glm::dvec3 p0(vertices[tri[0]].pos), p1(vertices[tri[1]].pos), p2(vertices[tri[2]].pos);
+    glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+    double length = glm::length(normal);
+    if (length > 0.0)
+    {
+      normal /= length;
+      Quadric quadric = Quadric::FromPlane(normal, -glm::dot(normal, p0), length * 0.5);
+      for (uint32_t k = 0; k != 3; ++k)
+      {
+        quadrics[tri[k]] += quadric;
+      }
+    }
+    for (uint32_t k = 0; k != 3; ++k)
+    {
+      vertexTriangles[tri[k]].push_back(t);
+    }
+  }
+
+  std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+  auto pushCollapse = [&](uint32_t from, uint32_t to)
+  {
+    if (locked[from])
+    {
+      return;
+    }
+    Quadric quadric = quadrics[from];
+    quadric += quadrics[to];
+    heap.push({quadric.Evaluate(vertices[to].pos), from, to});
+  };
+
+  for (uint32_t t = 0; t != triangleCount; ++t)
+  {
+    for (uint32_t e = 0; e != 3; ++e)
+    {
+      pushCollapse(triangles[t * 3 + e], triangles[t * 3 + (e + 1) % 3]);
+      pushCollapse(triangles[t * 3 + (e + 1) % 3], triangles[t * 3 + e]);
+    }
+  }
+
+  std::vector<bool> vertexAlive(vertexCount, true);
+  uint32_t aliveTriangles = triangleCount;
+  uint32_t previousLevel = triangleCount;
+  uint32_t target = static_cast<uint32_t>(triangleCount * LodReduction);
+  double maxError = 0.0;
+
+  auto emitLevel = [&]()
+  {
+    uint32_t firstIndex = static_cast<uint32_t>(data.indices.size());
+    for (uint32_t t = 0; t != triangleCount; ++t)
+    {
+      if (triangleAlive[t])
+      {
+        data.indices.insert(data.indices.end(), &triangles[t * 3], &triangles[t * 3] + 3);
+      }
+    }
+    data.lods.push_back({firstIndex, aliveTriangles * 3, static_cast<float>(std::sqrt(maxError))});
+
+    previousLevel = aliveTriangles;
+    target = static_cast<uint32_t>(aliveTriangles * LodReduction);
+  };
+
+  while (!heap.empty() && data.lods.size() < MAX_MESH_LODS && target >= MinLodTriangles)
+  {
+    Collapse collapse = heap.top();
+    heap.pop();
+
+    uint32_t u = collapse.from;
+    uint32_t v = collapse.to;
+    if (!vertexAlive[u] || !vertexAlive[v])
+    {
+      continue;
+    }
+
+    // Collapses into v change its quadric, stale entries go back with their current cost
+    Quadric merged = quadrics[u];
+    merged += quadrics[v];
+    double cost = merged.Evaluate(vertices[v].pos);
+    if (cost > collapse.cost * 1.0001 + 1e-12)
+    {
+      heap.push({cost, u, v});
+      continue;
+    }
+
+    // The edge must still exist and no remaining triangle around u may flip
+    bool connected = false;
+    bool flips = false;
+    for (uint32_t t : vertexTriangles[u])
+    {
+      if (!triangleAlive[t])
+      {
+        continue;
+      }
+
+      const uint32_t *tri = &triangles[t * 3];
+      if (tri[0] == v || tri[1] == v || tri[2] == v)
+      {
+        connected = true;
+        continue;
+      }
+
+      glm::vec3 p[3] = {vertices[tri[0]].pos, vertices[tri[1]].pos, vertices[tri[2]].pos};
+      glm::vec3 before = TriangleNormal(p[0], p[1], p[2]);
+      for (uint32_t k = 0; k != 3; ++k)
+      {
+        if (tri[k] == u)
+        {
+          p[k] = vertices[v].pos;
+        }
+      }
+      glm::vec3 after = TriangleNormal(p[0], p[1], p[2]);
+
+      if (glm::dot(before, after) <= 0.0f)
+      {
+        flips = true;
+        break;
+      }
+    }
+    if (!connected || flips)
+    {
+      continue;
+    }
+
+    for (uint32_t t : vertexTriangles[u])
+    {
+      if (!triangleAlive[t])
+      {
+        continue;
+      }
+
+      uint32_t *tri = &triangles[t * 3];
+      if (tri[0] == v || tri[1] == v || tri[2] == v)
+      {
+        triangleAlive[t] = false;
+        --aliveTriangles;
+        continue;
+      }
+
+      for (uint32_t k = 0; k != 3; ++k)
+      {
+        if (tri[k] == u)
+        {
+          tri[k] = v;
+        }
+      }
+      vertexTriangles[v].push_back(t);
+    }
+
+    vertexAlive[u] = false;
+    quadrics[v] = merged;
+    maxError = std::max(maxError, cost);
+
+    // Edges around v changed cost
+    for (uint32_t t : vertexTriangles[v])
+    {
+      if (!triangleAlive[t])
+      {
+        continue;
+      }
+      for (uint32_t k = 0; k != 3; ++k)
+      {
+        uint32_t w = triangles[t * 3 + k];
+        if (w != v)
+        {
+          pushCollapse(v, w);
+          pushCollapse(w, v);
+        }
+      }
+    }
+
+    if (aliveTriangles <= target)
+    {
+      emitLevel();
+    }
+  }
+
+  // Ran out of collapses on the way to the target, keep the level if it still saves enough
+  if (data.lods.size() < MAX_MESH_LODS && aliveTriangles < previousLevel * MinLodReduction)
+  {
+    emitLevel();
+  }
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+#include "MeshData.hpp"
+
+// Quadric error edge collapse (Garland/Heckbert). A collapse moves one vertex onto a neighbour,
+// so every level indexes the original vertex array and all LODs share one vertex buffer.
+// Vertices on open borders and UV seams never move, outlines and texture mapping survive.
+class MeshSimplifier
+{
+public:
+  // data.indices must hold the full mesh. Appends every coarser level behind it, each about
+  // half the triangles of the previous one, and fills data.lods starting with the full mesh
+  static void BuildLods(MeshData &data);
+};
\ No newline at end of file
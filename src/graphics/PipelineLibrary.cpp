@@ -0,0 +1,280 @@
+#include "PipelineLibrary.hpp"
+#include "VulkanContext.hpp"
+#include "Vertex.hpp"
+#include "../core/Logger.hpp"
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <cstring>
+
+// FNV-1a, continued from a previous hash
+static uint64_t HashBytes(uint64_t hash, const void *data, size_t size)
+{
+  const auto *bytes = static_cast<const uint8_t *>(data);
+  for (size_t i = 0; i != size; ++i)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+template <typename T>
+static uint64_t HashValue(uint64_t hash, const T &value)
+{
+  return HashBytes(hash, &value, sizeof(T));
+}
+
+void PipelineLibrary::Init(VulkanContext *context)
+{
+  mContext = context;
+  vkGetPhysicalDeviceProperties(mContext->GetPhysicalDevice(), &mDeviceProperties);
+
+  std::vector<char> initialData = LoadCacheData();
+
+  VkPipelineCacheCreateInfo cacheInfo{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+      .initialDataSize = initialData.size(),
+      .pInitialData = initialData.empty() ? nullptr : initialData.data(),
+  };
+
+  if (vkCreatePipelineCache(mContext->GetDevice(), &cacheInfo, nullptr, &mCache) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to create pipeline cache");
+  }
+
+  Logger::Log(LogLevel::Info, initialData.empty() ? "Pipeline cache: starting empty"
+                                                  : "Pipeline cache: loaded " + std::to_string(initialData.size() / 1024) + " KB");
+}
+
+void PipelineLibrary::Cleanup()
+{
+  if (!mContext)
+  {
+    return;
+  }
+
+  for (auto &pair : mPipelines)
+  {
+    if (pair.second.compiled.valid())
+    {
+      pair.second.compiled.wait();
+    }
+  }
+
+  if (!SaveCacheData())
+  {
+    Logger::Log(LogLevel::Warning, std::string("Failed to write pipeline cache: ") + CachePath);
+  }
+
+  for (auto &pair : mPipelines)
+  {
+    pair.second.pipeline->Destroy(mContext);
+  }
+  mPipelines.clear();
+
+  vkDestroyPipelineCache(mContext->GetDevice(), mCache, nullptr);
+  mCache = VK_NULL_HANDLE;
+  mContext = nullptr;
+}
+
+void PipelineLibrary::Precompile(const GraphicsPipelineDesc &desc)
+{
+  GetOrCompile(desc, true);
+}
+
+void PipelineLibrary::Precompile(const ComputePipelineDesc &desc)
+{
+  GetOrCompile(desc, true);
+}
+
+VulkanPipeline *PipelineLibrary::Get(const GraphicsPipelineDesc &desc)
+{
+  return GetOrCompile(desc, false);
+}
+
+VulkanPipeline *PipelineLibrary::Get(const ComputePipelineDesc &desc)
+{
+  return GetOrCompile(desc, false);
+}
+
+template <typename Desc>
+VulkanPipeline *PipelineLibrary::GetOrCompile(const Desc &desc, bool async)
+{
+  uint64_t key = HashDesc(desc);
+
+  VulkanPipeline *pipeline = nullptr;
+  std::shared_future<void> compiled;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto [it, inserted] = mPipelines.try_emplace(key);
+    Entry &entry = it->second;
+    if (inserted)
+    {
+      // The pipeline cache is internally synchronized, compiles on several threads share it safely.
+      // A deferred compile runs on the first thread that waits for it
+      entry.pipeline = std::make_unique<VulkanPipeline>();
+      entry.compiled = std::async(async ? std::launch::async : std::launch::deferred,
+                                  [this, target = entry.pipeline.get(), desc]()
+                                  { Compile(*target, desc); })
+                           .share();
+    }
+    pipeline = entry.pipeline.get();
+    compiled = entry.compiled;
+  }
+
+  if (!async)
+  {
+    // Rethrows a failed compile
+    compiled.get();
+  }
+
+  return pipeline;
+}
+
+void PipelineLibrary::Compile(VulkanPipeline &pipeline, const GraphicsPipelineDesc &desc)
+{
+  pipeline.Create(mContext, desc.vertFile, desc.fragFile, desc.descriptorSetLayouts,
+                  desc.colorAttachmentFormat, desc.depthAttachmentFormat, desc.depthCompareOp, desc.depthWrite, mCache);
+}
+
+void PipelineLibrary::Compile(VulkanPipeline &pipeline, const ComputePipelineDesc &desc)
+{
+  pipeline.CreateCompute(mContext, desc.compFile, desc.descriptorSetLayouts, desc.pushConstantSize, mCache);
+}
+
+uint64_t PipelineLibrary::HashDesc(const GraphicsPipelineDesc &desc) const
+{
+  uint64_t hash = HashValue(14695981039346656037ull, VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+  // Depth-only variants have no fragment shader
+  std::vector<char> vertCode = VulkanPipeline::ReadFile(desc.vertFile);
+  std::vector<char> fragCode = desc.fragFile.empty() ? std::vector<char>() : VulkanPipeline::ReadFile(desc.fragFile);
+  hash = HashBytes(hash, vertCode.data(), vertCode.size());
+  hash = HashValue(hash, fragCode.size());
+  hash = HashBytes(hash, fragCode.data(), fragCode.size());
+
+  // The vertex layout VulkanPipeline::Create builds the input state from
+  auto bindingDescription = PackedVertex::getBindingDescription();
+  auto attributeDescriptions = PackedVertex::getAttributeDescriptions();
+  hash = HashValue(hash, bindingDescription);
+  hash = HashBytes(hash, attributeDescriptions.data(), sizeof(attributeDescriptions[0]) * attributeDescriptions.size());
+
+  hash = HashBytes(hash, desc.descriptorSetLayouts.data(), sizeof(VkDescriptorSetLayout) * desc.descriptorSetLayouts.size());
+  hash = HashValue(hash, desc.colorAttachmentFormat);
+  hash = HashValue(hash, desc.depthAttachmentFormat);
+  hash = HashValue(hash, desc.depthCompareOp);
+  return HashValue(hash, desc.depthWrite);
+}
+
+uint64_t PipelineLibrary::HashDesc(const ComputePipelineDesc &desc) const
+{
+  uint64_t hash = HashValue(14695981039346656037ull, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+  std::vector<char> compCode = VulkanPipeline::ReadFile(desc.compFile);
+  hash = HashBytes(hash, compCode.data(), compCode.size());
+
+  hash = HashBytes(hash, desc.descriptorSetLayouts.data(), sizeof(VkDescriptorSetLayout) * desc.descriptorSetLayouts.size());
+  return HashValue(hash, desc.pushConstantSize);
+}
+
+std::vector<char> PipelineLibrary::LoadCacheData() const
+{
+  std::ifstream file(CachePath, std::ios::ate | std::ios::binary);
+  if (!file.is_open())
+  {
+    return {};
+  }
+
+  size_t fileSize = static_cast<size_t>(file.tellg());
+  if (fileSize < sizeof(Header))
+  {
+    return {};
+  }
+
+  Header header{};
+  file.seekg(0);
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+  // A cache from another GPU or driver is at best useless, some drivers crash on it
+  if (!file || header.magic != Magic || header.version != Version ||
+      header.vendorID != mDeviceProperties.vendorID || header.deviceID != mDeviceProperties.deviceID ||
+      header.driverVersion != mDeviceProperties.driverVersion ||
+      std::memcmp(header.pipelineCacheUUID, mDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0 ||
+      header.dataSize != fileSize - sizeof(Header))
+  {
+    Logger::Log(LogLevel::Info, "Pipeline cache does not match the device or driver, rebuilding it");
+    return {};
+  }
+
+  std::vector<char> data(header.dataSize);
+  file.read(data.data(), data.size());
+  if (!file)
+  {
+    return {};
+  }
+
+  return data;
+}
+
+bool PipelineLibrary::SaveCacheData() const
+{
+  size_t dataSize = 0;
+  if (vkGetPipelineCacheData(mContext->GetDevice(), mCache, &dataSize, nullptr) != VK_SUCCESS)
+  {
+    return false;
+  }
+
+  std::vector<char> data(dataSize);
+  if (vkGetPipelineCacheData(mContext->GetDevice(), mCache, &dataSize, data.data()) != VK_SUCCESS)
+  {
+    return false;
+  }
+
+  Header header{
+      .magic = Magic,
+      .version = Version,
+      .vendorID = mDeviceProperties.vendorID,
+      .deviceID = mDeviceProperties.deviceID,
+      .driverVersion = mDeviceProperties.driverVersion,
+      .dataSize = dataSize,
+  };
+  std::memcpy(header.pipelineCacheUUID, mDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+
+  std::error_code error;
+  std::filesystem::path path(CachePath);
+  std::filesystem::create_directories(path.parent_path(), error);
+  if (error)
+  {
+    return false;
+  }
+
+  // Write next to the target and rename, a crash never leaves a truncated cache behind
+  std::filesystem::path tempPath = path;
+  tempPath += ".tmp";
+
+  {
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+      return false;
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(data.data(), dataSize);
+
+    if (!file)
+    {
+      return false;
+    }
+  }
+
+  std::filesystem::rename(tempPath, path, error);
+  if (error)
+  {
+    std::filesystem::remove(tempPath, error);
+    return false;
+  }
+
+  return true;
+}
\ No newline at end of file
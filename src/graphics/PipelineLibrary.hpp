@@ -0,0 +1,92 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <unordered_map>
+#include <cstdint>
+#include "VulkanPipeline.hpp"
+
+class VulkanContext;
+
+// Everything that tells two graphics pipeline variants apart
+struct GraphicsPipelineDesc
+{
+  std::string vertFile;
+  std::string fragFile;
+  std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
+  VkFormat colorAttachmentFormat = VK_FORMAT_UNDEFINED;
+  VkFormat depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+  // Passes after a depth pre-pass test against its depth without writing it
+  VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+  bool depthWrite = true;
+};
+
+struct ComputePipelineDesc
+{
+  std::string compFile;
+  std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
+  uint32_t pushConstantSize = 0;
+};
+
+// Owns every pipeline and one VkPipelineCache that persists between runs.
+// Variants are keyed by a hash of the SPIR-V, the vertex layout, the attachment formats and depth state,
+// so each is compiled once. The cache file is only reused by the same device and driver version.
+class PipelineLibrary
+{
+public:
+  void Init(VulkanContext *context);
+  // Waits for background compiles, writes the cache to disk and destroys every pipeline
+  void Cleanup();
+
+  // Compiles on a background thread, a later Get of the same variant waits for it
+  void Precompile(const GraphicsPipelineDesc &desc);
+  void Precompile(const ComputePipelineDesc &desc);
+  // Compiles on first use, the same variant always returns the same pipeline. Throws when compilation failed
+  VulkanPipeline *Get(const GraphicsPipelineDesc &desc);
+  VulkanPipeline *Get(const ComputePipelineDesc &desc);
+
+  VkPipelineCache GetCache() const { return mCache; }
+
+private:
+  static constexpr uint32_t Magic = 0x4F535041; // "APSO"
+  static constexpr uint32_t Version = 1;
+  static constexpr const char *CachePath = "cache/pipelines.bin";
+
+  struct Header
+  {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    uint64_t dataSize;
+  };
+
+  struct Entry
+  {
+    std::unique_ptr<VulkanPipeline> pipeline;
+    // Valid while or after compiling on a background thread
+    std::shared_future<void> compiled;
+  };
+
+  VulkanContext *mContext = nullptr;
+  VkPipelineCache mCache = VK_NULL_HANDLE;
+  VkPhysicalDeviceProperties mDeviceProperties{};
+
+  std::mutex mMutex;
+  std::unordered_map<uint64_t, Entry> mPipelines;
+
+  template <typename Desc>
+  VulkanPipeline *GetOrCompile(const Desc &desc, bool async);
+  void Compile(VulkanPipeline &pipeline, const GraphicsPipelineDesc &desc);
+  void Compile(VulkanPipeline &pipeline, const ComputePipelineDesc &desc);
+  uint64_t HashDesc(const GraphicsPipelineDesc &desc) const;
+  uint64_t HashDesc(const ComputePipelineDesc &desc) const;
+
+  std::vector<char> LoadCacheData() const;
+  bool SaveCacheData() const;
+};
\ No newline at end of file
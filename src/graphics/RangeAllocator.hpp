@@ -0,0 +1,116 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Free list over [0, capacity) in abstract units (vertices, indices).
+// Free blocks are kept sorted by offset so a release merges with both neighbours in place,
+// allocation takes the smallest block that fits to keep large holes intact.
+class RangeAllocator
+{
+public:
+  static constexpr uint32_t InvalidOffset = UINT32_MAX;
+
+  void Init(uint32_t capacity)
+  {
+    mCapacity = capacity;
+    mUsed = 0;
+    mFree.clear();
+    if (capacity != 0)
+    {
+      mFree.push_back({0, capacity});
+    }
+  }
+
+  // InvalidOffset when no single free block is large enough
+  uint32_t Allocate(uint32_t size)
+  {
+    if (size == 0)
+    {
+      return 0;
+    }
+
+    size_t best = mFree.size();
+    for (size_t i = 0; i != mFree.size(); ++i)
+    {
+      if (mFree[i].size >= size && (best == mFree.size() || mFree[i].size < mFree[best].size))
+      {
+        best = i;
+      }
+    }
+
+    if (best == mFree.size())
+    {
+      return InvalidOffset;
+    }
+
+    uint32_t offset = mFree[best].offset;
+    mFree[best].offset += size;
+    mFree[best].size -= size;
+    if (mFree[best].size == 0)
+    {
+      mFree.erase(mFree.begin() + best);
+    }
+
+    mUsed += size;
+    return offset;
+  }
+
+  void Free(uint32_t offset, uint32_t size)
+  {
+    if (size == 0)
+    {
+      return;
+    }
+
+    auto next = std::lower_bound(mFree.begin(), mFree.end(), offset, [](const Block &block, uint32_t value)
+                                 { return block.offset < value; });
+    bool mergePrev = next != mFree.begin() && (next - 1)->offset + (next - 1)->size == offset;
+    bool mergeNext = next != mFree.end() && offset + size == next->offset;
+
+    if (mergePrev && mergeNext)
+    {
+      (next - 1)->size += size + next->size;
+      mFree.erase(next);
+    }
+    else if (mergePrev)
+    {
+      (next - 1)->size += size;
+    }
+    else if (mergeNext)
+    {
+      next->offset = offset;
+      next->size += size;
+    }
+    else
+    {
+      mFree.insert(next, {offset, size});
+    }
+
+    mUsed -= size;
+  }
+
+  uint32_t GetCapacity() const { return mCapacity; }
+  uint32_t GetUsed() const { return mUsed; }
+  // Free space that lies in holes below the last allocation, only compaction gets it back as one block
+  uint32_t GetFragmented() const
+  {
+    if (mFree.empty())
+    {
+      return 0;
+    }
+    uint32_t tail = mFree.back().offset + mFree.back().size == mCapacity ? mFree.back().size : 0;
+    return mCapacity - mUsed - tail;
+  }
+
+private:
+  struct Block
+  {
+    uint32_t offset;
+    uint32_t size;
+  };
+
+  std::vector<Block> mFree;
+  uint32_t mCapacity = 0;
+  uint32_t mUsed = 0;
+};
\ No newline at end of file
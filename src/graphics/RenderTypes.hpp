@@ -1,16 +1,63 @@
 #pragma once
+#include <vulkan/vulkan.h>
 #include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
 
 class VulkanMesh;
 
-struct RenderObject
+// Slot marker for objects that must not be drawn (freed slots)
+const uint32_t INVALID_MESH_INDEX = UINT32_MAX;
+
+// One element of the persistent object buffer (std430), read by the cull and vertex shaders
+struct ObjectData
+{
+  glm::mat4 model;
+  // Object space center in xyz, radius in w
+  glm::vec4 boundingSphere;
+  uint32_t meshIndex;
+  uint32_t materialIndex;
+  uint32_t padding[2];
+};
+
+// New contents of one slot of the object buffer
+struct ObjectUpdate
+{
+  uint32_t slot;
+  ObjectData data;
+};
+
+// Entry of the mesh table, indexed by ObjectData::meshIndex
+struct MeshDraw
 {
+  // nullptr while the mesh is still streaming in, its objects are culled but not drawn
   VulkanMesh *mesh;
-  glm::mat4 transform;
+  uint32_t objectCount;
+  // Objects inside the frustum by the CPU pass, the cull shader still tests each instance
+  uint32_t visibleCount;
+  // Range of the mesh in the geometry pool buffers of the snapshot, copied since compaction moves it
+  uint32_t firstIndex;
+  int32_t vertexOffset;
 };
 
 struct CameraRenderData
 {
   glm::mat4 view;
   glm::mat4 projection;
+};
+
+// Everything the renderer needs for one frame, handed from the simulation to the renderer.
+// Object data is persistent on the GPU, a snapshot only carries the slots that changed
+struct RenderSnapshot
+{
+  std::vector<ObjectUpdate> objectUpdates;
+  std::vector<MeshDraw> meshes;
+  // Geometry pool buffers the ranges above refer to, kept alive while the snapshot can be drawn
+  VkBuffer vertexBuffer = VK_NULL_HANDLE;
+  VkBuffer indexBuffer = VK_NULL_HANDLE;
+  // Uploader timeline value the frame waits for on the GPU before reading them
+  uint64_t geometryReadyValue = 0;
+  // Slots in use are below this, freed ones hold INVALID_MESH_INDEX
+  uint32_t objectCount = 0;
+  CameraRenderData camera;
 };
\ No newline at end of file
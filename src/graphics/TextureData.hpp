@@ -0,0 +1,23 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+
+// One mip level inside TextureData::pixels
+struct TextureMip
+{
+  VkDeviceSize offset;
+  VkDeviceSize size;
+  uint32_t width;
+  uint32_t height;
+};
+
+// Every mip level packed back to back, level 0 first. Produced by importers off the render thread
+struct TextureData
+{
+  uint32_t width = 0;
+  uint32_t height = 0;
+  VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+  std::vector<TextureMip> mips;
+  std::vector<uint8_t> pixels;
+};
@@ -0,0 +1,287 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "TextureImporter.hpp"
+#include "../core/MappedFile.hpp"
+#include <filesystem>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+  struct Ktx2Header
+  {
+    uint8_t identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+  };
+
+  struct Ktx2Level
+  {
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+  };
+
+  constexpr uint8_t Ktx2Identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+  bool IsSrgb(VkFormat format)
+  {
+    return format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_BC1_RGB_SRGB_BLOCK ||
+           format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK || format == VK_FORMAT_BC7_SRGB_BLOCK;
+  }
+
+  bool IsSupportedFormat(VkFormat format)
+  {
+    switch (format)
+    {
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  float SrgbToLinear(float value)
+  {
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+  }
+
+  float LinearToSrgb(float value)
+  {
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+  }
+
+  uint8_t ToByte(float value)
+  {
+    return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+  }
+}
+
+TextureData TextureImporter::Import(const std::string &filepath)
+{
+  std::string extension = std::filesystem::path(filepath).extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+                 { return static_cast<char>(std::tolower(c)); });
+
+  if (extension == ".ktx2")
+  {
+    return LoadKtx2(filepath);
+  }
+
+  return DecodeImage(filepath);
+}
+
+TextureData TextureImporter::DecodeImage(const std::string &filepath)
+{
+  int width = 0;
+  int height = 0;
+  int channels = 0;
+  stbi_uc *pixels = stbi_load(filepath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+
+  if (!pixels)
+  {
+    throw std::runtime_error("Failed to load texture image by path: " + filepath);
+  }
+
+  TextureData data{
+      .width = static_cast<uint32_t>(width),
+      .height = static_cast<uint32_t>(height),
+      .format = VK_FORMAT_R8G8B8A8_SRGB,
+  };
+
+  VkDeviceSize levelSize = GetLevelSize(data.format, data.width, data.height);
+  data.pixels.assign(pixels, pixels + levelSize); // RGBA
+  data.mips.push_back({0, levelSize, data.width, data.height});
+
+  stbi_image_free(pixels);
+
+  GenerateMips(data);
+
+  return data;
+}
+
+TextureData TextureImporter::LoadKtx2(const std::string &filepath)
+{
+  MappedFile file;
+  if (!file.Open(filepath))
+  {
+    throw std::runtime_error("Failed to open KTX2 texture: " + filepath);
+  }
+
+  Ktx2Header header;
+  if (file.GetSize() < sizeof(header))
+  {
+    throw std::runtime_error("Truncated KTX2 texture: " + filepath);
+  }
+  std::memcpy(&header, file.GetData(), sizeof(header));
+
+  if (std::memcmp(header.identifier, Ktx2Identifier, sizeof(Ktx2Identifier)) != 0)
+  {
+    throw std::runtime_error("Not a KTX2 file: " + filepath);
+  }
+  if (header.supercompressionScheme != 0)
+  {
+    throw std::runtime_error("Supercompressed KTX2 is not supported: " + filepath);
+  }
+  if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1 || header.pixelHeight == 0)
+  {
+    throw std::runtime_error("Only single 2D KTX2 images are supported: " + filepath);
+  }
+
+  VkFormat format = static_cast<VkFormat>(header.vkFormat);
+  if (!IsSupportedFormat(format))
+  {
+    throw std::runtime_error("Unsupported KTX2 format " + std::to_string(header.vkFormat) + ": " + filepath);
+  }
+
+  uint32_t levelCount = std::max(header.levelCount, 1u);
+  if (file.GetSize() < sizeof(header) + sizeof(Ktx2Level) * levelCount)
+  {
+    throw std::runtime_error("Truncated KTX2 level index: " + filepath);
+  }
+
+  TextureData data{
+      .width = header.pixelWidth,
+      .height = header.pixelHeight,
+      .format = format,
+  };
+
+  for (uint32_t level = 0; level != levelCount; ++level)
+  {
+    Ktx2Level levelInfo;
+    std::memcpy(&levelInfo, file.GetData() + sizeof(header) + sizeof(Ktx2Level) * level, sizeof(levelInfo));
+
+    uint32_t width = std::max(header.pixelWidth >> level, 1u);
+    uint32_t height = std::max(header.pixelHeight >> level, 1u);
+    VkDeviceSize expectedSize = GetLevelSize(format, width, height);
+
+    if (levelInfo.byteLength != expectedSize || levelInfo.byteOffset + levelInfo.byteLength > file.GetSize())
+    {
+      throw std::runtime_error("Malformed KTX2 level " + std::to_string(level) + ": " + filepath);
+    }
+
+    data.mips.push_back({data.pixels.size(), expectedSize, width, height});
+    data.pixels.insert(data.pixels.end(), file.GetData() + levelInfo.byteOffset, file.GetData() + levelInfo.byteOffset + levelInfo.byteLength);
+  }
+
+  // Uncompressed KTX2 without stored levels still gets a mip chain
+  if (levelCount == 1 && !IsBlockCompressed(format))
+  {
+    GenerateMips(data);
+  }
+
+  return data;
+}
+
+void TextureImporter::GenerateMips(TextureData &data)
+{
+  if (IsBlockCompressed(data.format) || data.mips.empty())
+  {
+    return;
+  }
+
+  bool srgb = IsSrgb(data.format);
+
+  std::array<float, 256> toLinear;
+  for (uint32_t i = 0; i != 256; ++i)
+  {
+    toLinear[i] = srgb ? SrgbToLinear(i / 255.0f) : i / 255.0f;
+  }
+
+  data.mips.resize(1);
+  data.pixels.resize(data.mips[0].size);
+
+  uint32_t levelCount = static_cast<uint32_t>(std::floor(std::log2(std::max(data.width, data.height)))) + 1;
+  data.mips.reserve(levelCount);
+
+  for (uint32_t level = 1; level != levelCount; ++level)
+  {
+    const TextureMip src = data.mips[level - 1];
+    TextureMip dst{
+        .offset = data.pixels.size(),
+        .width = std::max(src.width / 2, 1u),
+        .height = std::max(src.height / 2, 1u),
+    };
+    dst.size = GetLevelSize(data.format, dst.width, dst.height);
+
+    data.pixels.resize(data.pixels.size() + dst.size);
+    const uint8_t *srcPixels = data.pixels.data() + src.offset;
+    uint8_t *dstPixels = data.pixels.data() + dst.offset;
+
+    for (uint32_t y = 0; y != dst.height; ++y)
+    {
+      // Odd sizes: the last row or column is reused instead of reading past the edge
+      uint32_t y0 = std::min(y * 2, src.height - 1);
+      uint32_t y1 = std::min(y * 2 + 1, src.height - 1);
+
+      for (uint32_t x = 0; x != dst.width; ++x)
+      {
+        uint32_t x0 = std::min(x * 2, src.width - 1);
+        uint32_t x1 = std::min(x * 2 + 1, src.width - 1);
+
+        const uint8_t *texels[4] = {
+            srcPixels + (static_cast<size_t>(y0) * src.width + x0) * 4,
+            srcPixels + (static_cast<size_t>(y0) * src.width + x1) * 4,
+            srcPixels + (static_cast<size_t>(y1) * src.width + x0) * 4,
+            srcPixels + (static_cast<size_t>(y1) * src.width + x1) * 4,
+        };
+
+        uint8_t *out = dstPixels + (static_cast<size_t>(y) * dst.width + x) * 4;
+
+        for (uint32_t channel = 0; channel != 3; ++channel)
+        {
+          float sum = toLinear[texels[0][channel]] + toLinear[texels[1][channel]] + toLinear[texels[2][channel]] + toLinear[texels[3][channel]];
+          float average = sum * 0.25f;
+          out[channel] = ToByte(srgb ? LinearToSrgb(average) : average);
+        }
+
+        // Alpha is always linear
+        uint32_t alpha = texels[0][3] + texels[1][3] + texels[2][3] + texels[3][3];
+        out[3] = static_cast<uint8_t>((alpha + 2) / 4);
+      }
+    }
+
+    data.mips.push_back(dst);
+  }
+}
+
+bool TextureImporter::IsBlockCompressed(VkFormat format)
+{
+  return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+}
+
+VkDeviceSize TextureImporter::GetLevelSize(VkFormat format, uint32_t width, uint32_t height)
+{
+  if (!IsBlockCompressed(format))
+  {
+    return static_cast<VkDeviceSize>(width) * height * 4;
+  }
+
+  bool eightByteBlocks = format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+  VkDeviceSize blockSize = eightByteBlocks ? 8 : 16;
+
+  return static_cast<VkDeviceSize>((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+#include "TextureData.hpp"
+
+// Turns image files into upload-ready mip chains, touches no Vulkan state so it can run on any thread.
+// Shipped assets should be KTX2 with BC1/BC7 levels, those are used exactly as stored.
+// Any other image goes through stb_image and gets a full mip chain built on the CPU.
+class TextureImporter
+{
+public:
+  // Picks the loader by extension
+  static TextureData Import(const std::string &filepath);
+
+  static TextureData DecodeImage(const std::string &filepath);
+  // KTX2 without supercompression holding BC1, BC7 or RGBA8 levels of a single 2D image
+  static TextureData LoadKtx2(const std::string &filepath);
+
+  // Appends box filtered RGBA8 levels down to 1x1, sRGB formats are averaged in linear space
+  static void GenerateMips(TextureData &data);
+
+  static bool IsBlockCompressed(VkFormat format);
+  // Byte size of one level of the given format
+  static VkDeviceSize GetLevelSize(VkFormat format, uint32_t width, uint32_t height);
+};
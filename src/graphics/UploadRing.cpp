@@ -0,0 +1,127 @@
+#include "UploadRing.hpp"
+#include "VulkanContext.hpp"
+#include <algorithm>
+
+void UploadRing::Init(VulkanContext *context, uint32_t frameCount, VkDeviceSize frameSize)
+{
+  mContext = context;
+  mFrameCount = frameCount;
+  mRetired.resize(frameCount);
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(mContext->GetPhysicalDevice(), &properties);
+  mMinAlignment = std::max({properties.limits.minUniformBufferOffsetAlignment,
+                            properties.limits.minStorageBufferOffsetAlignment,
+                            properties.limits.nonCoherentAtomSize});
+
+  Grow(frameSize);
+  BeginFrame(0);
+}
+
+void UploadRing::Cleanup()
+{
+  if (!mContext)
+  {
+    return;
+  }
+
+  for (auto &buffers : mRetired)
+  {
+    for (VulkanBuffer &buffer : buffers)
+    {
+      buffer.Unmap(mContext->GetAllocator());
+      buffer.Destroy(mContext->GetAllocator());
+    }
+  }
+  mRetired.clear();
+
+  mBuffer.Unmap(mContext->GetAllocator());
+  mBuffer.Destroy(mContext->GetAllocator());
+  mMapped = nullptr;
+  mContext = nullptr;
+}
+
+void UploadRing::CreateBuffer(VulkanBuffer &buffer, VkDeviceSize size)
+{
+  // Device local and host visible where the device has it (ReBAR), system memory otherwise
+  buffer.Create(
+      mContext->GetAllocator(),
+      size,
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+          VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+      VMA_MEMORY_USAGE_AUTO,
+      VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+}
+
+void UploadRing::Grow(VkDeviceSize frameSize)
+{
+  // Frames in flight still read the old buffer, it goes once this frame comes around again
+  if (mMapped)
+  {
+    mRetired[mFrame].push_back(std::move(mBuffer));
+  }
+
+  mFrameSize = (frameSize + mMinAlignment - 1) & ~(mMinAlignment - 1);
+  CreateBuffer(mBuffer, mFrameSize * mFrameCount);
+  mMapped = static_cast<std::byte *>(mBuffer.Map(mContext->GetAllocator()));
+  mAddress = mBuffer.GetDeviceAddress(mContext->GetDevice());
+}
+
+void UploadRing::BeginFrame(uint32_t frame)
+{
+  mFrame = frame;
+
+  for (VulkanBuffer &buffer : mRetired[frame])
+  {
+    buffer.Unmap(mContext->GetAllocator());
+    buffer.Destroy(mContext->GetAllocator());
+  }
+  mRetired[frame].clear();
+
+  if (mHighWater > mFrameSize)
+  {
+    Grow(std::max(mHighWater, mFrameSize * 2));
+  }
+
+  mHead = mFrameSize * frame;
+  mFirstSpill = mRetired[frame].size();
+  mSpilledBytes = 0;
+  mHighWater = 0;
+}
+
+UploadAllocation UploadRing::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+  alignment = std::max(alignment, mMinAlignment);
+  VkDeviceSize offset = (mHead + alignment - 1) & ~(alignment - 1);
+  VkDeviceSize frameEnd = mFrameSize * (mFrame + 1);
+
+  if (offset + size <= frameEnd)
+  {
+    mHead = offset + size;
+    mHighWater = std::max(mHighWater, GetUsed());
+    return {mMapped + offset, mBuffer.GetBuffer(), offset, mAddress + offset};
+  }
+
+  // Partition full, this frame gets a buffer of its own and the next one a larger ring
+  VulkanBuffer spill;
+  CreateBuffer(spill, size);
+  UploadAllocation allocation{spill.Map(mContext->GetAllocator()), spill.GetBuffer(), 0, spill.GetDeviceAddress(mContext->GetDevice())};
+  mRetired[mFrame].push_back(std::move(spill));
+
+  mSpilledBytes += size + alignment;
+  mHighWater = std::max(mHighWater, GetUsed());
+  return allocation;
+}
+
+void UploadRing::Flush()
+{
+  VkDeviceSize begin = mFrameSize * mFrame;
+  if (mHead != begin)
+  {
+    mBuffer.Flush(mContext->GetAllocator(), begin, mHead - begin);
+  }
+  for (size_t i = mFirstSpill; i != mRetired[mFrame].size(); ++i)
+  {
+    mRetired[mFrame][i].Flush(mContext->GetAllocator(), 0, VK_WHOLE_SIZE);
+  }
+}
\ No newline at end of file
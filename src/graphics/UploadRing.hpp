@@ -0,0 +1,72 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "VulkanBuffer.hpp"
+
+class VulkanContext;
+
+// Per-frame GPU data written by the CPU, valid until the frame's fence signals
+struct UploadAllocation
+{
+  void *data = nullptr;
+  VkBuffer buffer = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceAddress address = 0;
+};
+
+// Linear allocator over one persistently mapped host-visible buffer split into a partition per frame in flight.
+// A frame's partition is handed out from the start again once its fence was waited on, so streamed data
+// (uniforms, object updates, instance data) costs a pointer bump and a memcpy. Allocations can be bound
+// through their buffer and a dynamic offset, or read through their device address.
+// A frame that outgrows its partition spills into dedicated buffers, the next BeginFrame grows the ring
+// to the high-water mark. Replaced buffers live until every frame in flight moved past them.
+class UploadRing
+{
+public:
+  void Init(VulkanContext *context, uint32_t frameCount, VkDeviceSize frameSize = 1024 * 1024);
+  void Cleanup();
+
+  // After the fence of the frame was waited on, earlier allocations of the same frame become invalid
+  void BeginFrame(uint32_t frame);
+  // Aligned to at least the device's uniform and storage buffer offset alignment
+  UploadAllocation Allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+  // Makes the frame's writes visible to the device when the memory is not host coherent, before submitting
+  void Flush();
+
+  template <typename T>
+  UploadAllocation Push(const T &value)
+  {
+    UploadAllocation allocation = Allocate(sizeof(T), alignof(T));
+    memcpy(allocation.data, &value, sizeof(T));
+    return allocation;
+  }
+
+  // Changes when the ring grows, descriptors that point into it must be written again
+  VkBuffer GetBuffer() const { return mBuffer.GetBuffer(); }
+  VkDeviceSize GetFrameSize() const { return mFrameSize; }
+  // Bytes handed out by the current frame, spills included
+  VkDeviceSize GetUsed() const { return mHead - mFrame * mFrameSize + mSpilledBytes; }
+
+private:
+  VulkanContext *mContext = nullptr;
+  VulkanBuffer mBuffer;
+  std::byte *mMapped = nullptr;
+  VkDeviceAddress mAddress = 0;
+  VkDeviceSize mFrameSize = 0;
+  VkDeviceSize mMinAlignment = 1;
+  uint32_t mFrameCount = 0;
+
+  uint32_t mFrame = 0;
+  VkDeviceSize mHead = 0;
+  VkDeviceSize mSpilledBytes = 0;
+  VkDeviceSize mHighWater = 0;
+
+  // Per frame: replaced ring buffers, then spill buffers from mFirstSpill on, destroyed when the frame begins again
+  std::vector<std::vector<VulkanBuffer>> mRetired;
+  size_t mFirstSpill = 0;
+
+  void CreateBuffer(VulkanBuffer &buffer, VkDeviceSize size);
+  void Grow(VkDeviceSize frameSize);
+};
\ No newline at end of file
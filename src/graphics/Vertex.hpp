@@ -3,63 +3,106 @@
 #include <vulkan/vulkan.h>
 #include <glm/glm.hpp>
 #include <glm/gtx/hash.hpp>
+#include <glm/gtc/packing.hpp>
 #include <array>
+#include <bit>
+#include <cstdint>
+#include <algorithm>
 
+// Full precision vertex used by importers and mesh processing, the GPU gets PackedVertex
 struct Vertex
 {
   glm::vec3 pos;
   glm::vec3 color;
   glm::vec2 texCoord;
 
+  bool operator==(const Vertex &other) const
+  {
+    return pos == other.pos && color == other.color && texCoord == other.texCoord;
+  }
+
+  // Mixes the bits of every attribute, -0.0 is folded into 0.0 so equal vertices always hash equal
+  static uint64_t computeHash(const Vertex &vertex)
+  {
+    const float values[] = {
+        vertex.pos.x, vertex.pos.y, vertex.pos.z,
+        vertex.color.x, vertex.color.y, vertex.color.z,
+        vertex.texCoord.x, vertex.texCoord.y};
+
+    uint64_t hash = 0x9E3779B97F4A7C15ull;
+    for (float value : values)
+    {
+      uint32_t bits = std::bit_cast<uint32_t>(value == 0.0f ? 0.0f : value);
+      hash = (hash ^ bits) * 0xFF51AFD7ED558CCDull;
+      hash ^= hash >> 32;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+
+    return hash;
+  }
+};
+
+// 12 byte GPU vertex. Position is unorm16 inside the mesh AABB, the vertex shader scales it back
+// with the mesh's quantization offset and scale; w is padding. UV is two half floats
+struct PackedVertex
+{
+  uint16_t pos[4];
+  uint32_t texCoord;
+
+  static PackedVertex Pack(const Vertex &vertex, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+  {
+    glm::vec3 extent = boundsMax - boundsMin;
+    PackedVertex packed{};
+    for (int i = 0; i != 3; ++i)
+    {
+      float t = extent[i] > 0.0f ? (vertex.pos[i] - boundsMin[i]) / extent[i] : 0.0f;
+      packed.pos[i] = static_cast<uint16_t>(std::clamp(t, 0.0f, 1.0f) * 65535.0f + 0.5f);
+    }
+    packed.texCoord = glm::packHalf2x16(vertex.texCoord);
+    return packed;
+  }
+
   static VkVertexInputBindingDescription getBindingDescription()
   {
     VkVertexInputBindingDescription bindingDescription{
         .binding = 0,
-        .stride = sizeof(Vertex),
+        .stride = sizeof(PackedVertex),
         .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
     };
 
     return bindingDescription;
   }
 
-  static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions()
+  static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions()
   {
     VkVertexInputAttributeDescription posAttr{
         .location = 0,
         .binding = 0,
-        .format = VK_FORMAT_R32G32B32_SFLOAT,
-        .offset = offsetof(Vertex, pos),
-    };
-
-    VkVertexInputAttributeDescription colorAttr{
-        .location = 1,
-        .binding = 0,
-        .format = VK_FORMAT_R32G32B32_SFLOAT,
-        .offset = offsetof(Vertex, color),
+        .format = VK_FORMAT_R16G16B16A16_UNORM,
+        .offset = offsetof(PackedVertex, pos),
     };
 
     VkVertexInputAttributeDescription texCoordAttr{
-        .location = 2,
+        .location = 1,
         .binding = 0,
-        .format = VK_FORMAT_R32G32_SFLOAT,
-        .offset = offsetof(Vertex, texCoord),
+        .format = VK_FORMAT_R16G16_SFLOAT,
+        .offset = offsetof(PackedVertex, texCoord),
     };
 
-    std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{
+    std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{
         posAttr,
-        colorAttr,
         texCoordAttr,
     };
 
     return attributeDescriptions;
   }
-
-  bool operator==(const Vertex &other) const
-  {
-    return pos == other.pos && color == other.color && texCoord == other.texCoord;
-  }
 };
 
+static_assert(sizeof(PackedVertex) == 12);
+
 namespace std
 {
   template <>
@@ -67,7 +110,7 @@ namespace std
   {
     size_t operator()(Vertex const &vertex) const
     {
-      return ((hash<glm::vec3>()(vertex.pos) ^ (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ (hash<glm::vec2>()(vertex.texCoord) << 1);
+      return static_cast<size_t>(Vertex::computeHash(vertex));
     }
   };
 }
\ No newline at end of file
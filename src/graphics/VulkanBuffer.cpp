@@ -26,7 +26,7 @@ VulkanBuffer &VulkanBuffer::operator=(VulkanBuffer &&other) noexcept
   return *this;
 }
 
-void VulkanBuffer::Create(VmaAllocator allocator, VkDeviceSize size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage, VmaAllocationCreateFlags vmaFlags)
+void VulkanBuffer::Create(VmaAllocator allocator, VkDeviceSize size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage, VmaAllocationCreateFlags vmaFlags, std::span<const uint32_t> queueFamilies)
 {
   mSize = size;
 
@@ -34,7 +34,15 @@ void VulkanBuffer::Create(VmaAllocator allocator, VkDeviceSize size, VkBufferUsa
       .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
       .size = size,
       .usage = bufferUsage,
+      .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
   };
+
+  if (queueFamilies.size() > 1)
+  {
+    bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+    bufferInfo.pQueueFamilyIndices = queueFamilies.data();
+  }
   VmaAllocationCreateInfo allocInfo{
       .flags = vmaFlags,
       .usage = memoryUsage,
@@ -95,4 +103,14 @@ void *VulkanBuffer::Map(VmaAllocator allocator)
 void VulkanBuffer::Unmap(VmaAllocator allocator)
 {
   vmaUnmapMemory(allocator, mAllocation);
+}
+
+void VulkanBuffer::Invalidate(VmaAllocator allocator)
+{
+  vmaInvalidateAllocation(allocator, mAllocation, 0, VK_WHOLE_SIZE);
+}
+
+void VulkanBuffer::Flush(VmaAllocator allocator, VkDeviceSize offset, VkDeviceSize size)
+{
+  vmaFlushAllocation(allocator, mAllocation, offset, size);
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <vk_mem_alloc.h>
 #include <cstring>
 #include <stdexcept>
+#include <span>
 
 class VulkanBuffer
 {
@@ -14,11 +15,14 @@ public:
   VulkanBuffer(VulkanBuffer &&other) noexcept;
   VulkanBuffer &operator=(VulkanBuffer &&other) noexcept;
 
-  void Create(VmaAllocator allocator, VkDeviceSize size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage, VmaAllocationCreateFlags vmaFlags = 0);
+  // queueFamilies: when it holds more than one family the buffer is created with concurrent sharing
+  void Create(VmaAllocator allocator, VkDeviceSize size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage, VmaAllocationCreateFlags vmaFlags = 0, std::span<const uint32_t> queueFamilies = {});
   void Destroy(VmaAllocator allocator);
   void Upload(VmaAllocator allocator, const void *data, size_t size);
   void *Map(VmaAllocator allocator);
   void Unmap(VmaAllocator allocator);
+  void Invalidate(VmaAllocator allocator);
+  void Flush(VmaAllocator allocator, VkDeviceSize offset, VkDeviceSize size);
 
   VkBuffer GetBuffer() const
   {
@@ -6,19 +6,33 @@ void VulkanContext::Init(Window *window, const char *appName, const char *engine
   mWindow = window;
 
   CreateInstance(appName, engineName);
-  CreateSurface();
+  if (!mWindow->IsHeadless())
+  {
+    CreateSurface();
+  }
   PickPhysicalDevice();
   CreateLogicalDevice();
   CreateAllocator();
   CreateCommandPool();
+
+  mUploader.Init(this);
 }
 
 void VulkanContext::Cleanup()
 {
+  mUploader.Cleanup();
   vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
+  for (auto &[threadId, pool] : mSingleTimePools)
+  {
+    vkDestroyCommandPool(mDevice, pool, nullptr);
+  }
+  mSingleTimePools.clear();
   vmaDestroyAllocator(mAllocator);
   vkDestroyDevice(mDevice, nullptr);
-  vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
+  if (mSurface != VK_NULL_HANDLE)
+  {
+    vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
+  }
   vkDestroyInstance(mInstance, nullptr);
 }
 
@@ -54,6 +68,11 @@ bool VulkanContext::CheckValidationLayerSupport()
 
 std::vector<const char *> VulkanContext::GetSdlExtensions()
 {
+  if (mWindow->IsHeadless())
+  {
+    return {};
+  }
+
   uint32_t glfwExtensionCount = 0;
   auto glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
@@ -218,6 +237,28 @@ uint32_t VulkanContext::RateDeviceSuitability(VkPhysicalDevice device)
     std::cout << "Device (" << deviceProperties.properties.deviceName << ") missing Synchronization2 support" << std::endl;
     return 0;
   }
+  if (!features12.timelineSemaphore)
+  {
+    std::cout << "Device (" << deviceProperties.properties.deviceName << ") missing Timeline Semaphore support" << std::endl;
+    return 0;
+  }
+  if (!features12.drawIndirectCount)
+  {
+    std::cout << "Device (" << deviceProperties.properties.deviceName << ") missing Draw Indirect Count support" << std::endl;
+    return 0;
+  }
+  if (!features12.runtimeDescriptorArray || !features12.descriptorBindingPartiallyBound ||
+      !features12.descriptorBindingSampledImageUpdateAfterBind || !features12.descriptorBindingUpdateUnusedWhilePending ||
+      !features12.shaderSampledImageArrayNonUniformIndexing)
+  {
+    std::cout << "Device (" << deviceProperties.properties.deviceName << ") missing Descriptor Indexing support" << std::endl;
+    return 0;
+  }
+  if (!features2.features.multiDrawIndirect)
+  {
+    std::cout << "Device (" << deviceProperties.properties.deviceName << ") missing Multi Draw Indirect support" << std::endl;
+    return 0;
+  }
   if (!features2.features.geometryShader)
   {
     std::cout << "Device (" << deviceProperties.properties.deviceName << ") missing Geometry Shader support" << std::endl;
@@ -245,28 +286,66 @@ QueueFamilyIndices VulkanContext::FindQueueFamilies(VkPhysicalDevice device)
 
   for (size_t i = 0; i != queueFamilies.size(); ++i)
   {
-    if (queueFamilies[i].queueFamilyProperties.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+    VkQueueFlags queueFlags = queueFamilies[i].queueFamilyProperties.queueFlags;
+
+    // Prefer a transfer-only family (DMA engine), then any family without graphics
+    if ((queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFlags & VK_QUEUE_GRAPHICS_BIT))
+    {
+      if (!indices.transferFamily.has_value() || !(queueFlags & VK_QUEUE_COMPUTE_BIT))
+      {
+        indices.transferFamily = static_cast<uint32_t>(i);
+      }
+    }
+
+    if (indices.isComplete())
+    {
+      continue;
+    }
+
+    if (queueFlags & VK_QUEUE_GRAPHICS_BIT)
     {
       indices.graphicsFamily = static_cast<uint32_t>(i);
     }
 
     VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, static_cast<uint32_t>(i), mSurface, &presentSupport);
+    if (mSurface != VK_NULL_HANDLE)
+    {
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, static_cast<uint32_t>(i), mSurface, &presentSupport);
+    }
+    else
+    {
+      // Headless: nothing is presented, the present family mirrors the graphics one
+      presentSupport = (queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+    }
 
     if (presentSupport)
     {
       indices.presentFamily = static_cast<uint32_t>(i);
     }
+  }
 
-    if (indices.isComplete())
-    {
-      break;
-    }
+  if (!indices.transferFamily.has_value())
+  {
+    indices.transferFamily = indices.graphicsFamily;
   }
 
   return indices;
 }
 
+std::vector<const char *> VulkanContext::GetDeviceExtensions() const
+{
+  std::vector<const char *> extensions = {
+      VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME,
+  };
+
+  if (!mWindow->IsHeadless())
+  {
+    extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+  }
+
+  return extensions;
+}
+
 void VulkanContext::CreateLogicalDevice()
 {
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
@@ -287,6 +366,15 @@ void VulkanContext::CreateLogicalDevice()
   // Vulkan 1.2
   VkPhysicalDeviceVulkan12Features features12{
       .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+      // GPU-driven draws
+      .drawIndirectCount = VK_TRUE,
+      // Bindless textures
+      .shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
+      .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+      .descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
+      .descriptorBindingPartiallyBound = VK_TRUE,
+      .runtimeDescriptorArray = VK_TRUE,
+      .timelineSemaphore = VK_TRUE,
       .bufferDeviceAddress = VK_TRUE,
 
   };
@@ -302,17 +390,42 @@ void VulkanContext::CreateLogicalDevice()
       .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_4_FEATURES,
       .pNext = &features13,
   };
+  // Optional features are enabled only when the device has them
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(mPhysicalDevice, &supportedFeatures);
+  mSupportsTextureCompressionBC = supportedFeatures.textureCompressionBC == VK_TRUE;
+
+  VkPhysicalDeviceVulkan12Features supportedFeatures12{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+  };
+  VkPhysicalDeviceFeatures2 supportedFeatures2{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+      .pNext = &supportedFeatures12,
+  };
+  vkGetPhysicalDeviceFeatures2(mPhysicalDevice, &supportedFeatures2);
+  mSupportsSamplerFilterMinmax = supportedFeatures12.samplerFilterMinmax == VK_TRUE;
+  features12.samplerFilterMinmax = mSupportsSamplerFilterMinmax ? VK_TRUE : VK_FALSE;
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(mPhysicalDevice, &properties);
+  mMaxSamplerAnisotropy = properties.limits.maxSamplerAnisotropy;
+
   // Vulkan 1.0
   VkPhysicalDeviceFeatures2 features2{
       .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
       .pNext = &features14,
       .features = {
           .geometryShader = VK_TRUE,
+          // Indirect draws over every LOD command of a mesh
+          .multiDrawIndirect = VK_TRUE,
           .fillModeNonSolid = VK_TRUE,
           .samplerAnisotropy = VK_TRUE,
+          .textureCompressionBC = mSupportsTextureCompressionBC ? VK_TRUE : VK_FALSE,
       },
   };
 
+  auto deviceExtensions = GetDeviceExtensions();
+
   // enabledLayerCount и ppEnabledLayerNames устарели
   VkDeviceCreateInfo createInfo{
       .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
@@ -348,6 +461,21 @@ void VulkanContext::CreateLogicalDevice()
     mPresentQueue = mGraphicsQueue;
   }
 
+  if (mQueueFamilyIndices.transferFamily != mQueueFamilyIndices.graphicsFamily)
+  {
+    queueInfo.queueFamilyIndex = mQueueFamilyIndices.transferFamily.value();
+    vkGetDeviceQueue2(mDevice, &queueInfo, &mTransferQueue);
+
+    mSharedQueueFamilies = {mQueueFamilyIndices.graphicsFamily.value(), mQueueFamilyIndices.transferFamily.value()};
+    mSharedQueueFamilyCount = 2;
+
+    std::cout << "Using dedicated transfer queue family " << mQueueFamilyIndices.transferFamily.value() << std::endl;
+  }
+  else
+  {
+    mTransferQueue = mGraphicsQueue;
+  }
+
   std::cout << "Logical Device created with Vulkan 1.4 chain" << std::endl;
 }
 
@@ -389,11 +517,30 @@ void VulkanContext::CreateAllocator()
   }
 }
 
+VkCommandPool VulkanContext::GetSingleTimeCommandPool()
+{
+  std::lock_guard<std::mutex> lock(mSingleTimePoolMutex);
+  VkCommandPool &pool = mSingleTimePools[std::this_thread::get_id()];
+  if (pool == VK_NULL_HANDLE)
+  {
+    VkCommandPoolCreateInfo poolInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = mQueueFamilyIndices.graphicsFamily.value(),
+    };
+    if (vkCreateCommandPool(mDevice, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+    {
+      throw std::runtime_error("Failed to create single time command pool");
+    }
+  }
+  return pool;
+}
+
 VkCommandBuffer VulkanContext::BeginSingleTimeCommands()
 {
   VkCommandBufferAllocateInfo allocInfo{
       .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-      .commandPool = mCommandPool,
+      .commandPool = GetSingleTimeCommandPool(),
       .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
       .commandBufferCount = 1,
   };
@@ -426,24 +573,38 @@ void VulkanContext::EndSingleTimeCommands(VkCommandBuffer commandBuffer)
       .pCommandBufferInfos = &cmdBufInfo,
   };
 
-  vkQueueSubmit2(mGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-
-  vkQueueWaitIdle(mGraphicsQueue);
+  {
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    vkQueueSubmit2(mGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+    vkQueueWaitIdle(mGraphicsQueue);
+  }
 
-  vkFreeCommandBuffers(mDevice, mCommandPool, 1, &commandBuffer);
+  // Begin ran on this thread, so this is the pool the buffer came from
+  vkFreeCommandBuffers(mDevice, GetSingleTimeCommandPool(), 1, &commandBuffer);
 }
 
-void VulkanContext::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+void VulkanContext::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset)
 {
   VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
 
   VkBufferCopy copyRegion{
       .srcOffset = 0,
-      .dstOffset = 0,
+      .dstOffset = dstOffset,
       .size = size,
   };
 
   vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
   EndSingleTimeCommands(commandBuffer);
+}
+
+void VulkanContext::WaitIdle()
+{
+  if (mDevice == VK_NULL_HANDLE)
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mQueueMutex);
+  vkDeviceWaitIdle(mDevice);
 }
\ No newline at end of file
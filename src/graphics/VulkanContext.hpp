@@ -11,12 +11,18 @@
 #include <iostream>
 #include <map>
 #include <set>
+#include <span>
+#include <mutex>
+#include <thread>
+#include "VulkanUploader.hpp"
 #include "../core/Window.hpp"
 
 struct QueueFamilyIndices
 {
   std::optional<uint32_t> graphicsFamily;
   std::optional<uint32_t> presentFamily;
+  // Falls back to the graphics family when the device has no separate transfer queue
+  std::optional<uint32_t> transferFamily;
 
   bool isComplete()
   {
@@ -28,6 +34,7 @@ struct QueueFamilyIndices
     std::set<uint32_t> uniqueQueueFamilies = {
         graphicsFamily.value(),
         presentFamily.value(),
+        transferFamily.value(),
     };
 
     return uniqueQueueFamilies;
@@ -48,31 +55,53 @@ public:
   VmaAllocator GetAllocator() const { return mAllocator; }
   VkQueue GetGraphicsQueue() const { return mGraphicsQueue; }
   VkQueue GetPresentQueue() const { return mPresentQueue; }
+  VkQueue GetTransferQueue() const { return mTransferQueue; }
+  // Frame command buffers, only the render thread records from it
   VkCommandPool GetCommandPool() const { return mCommandPool; }
   uint32_t GetGraphicsFamily() const { return mQueueFamilyIndices.graphicsFamily.value(); }
   uint32_t GetPresentFamily() const { return mQueueFamilyIndices.presentFamily.value(); }
+  uint32_t GetTransferFamily() const { return mQueueFamilyIndices.transferFamily.value(); }
+  // Families that touch streamed resources, empty when graphics and transfer share a family (exclusive sharing is enough)
+  std::span<const uint32_t> GetSharedQueueFamilies() const { return {mSharedQueueFamilies.data(), mSharedQueueFamilyCount}; }
+  VulkanUploader &GetUploader() { return mUploader; }
+  bool SupportsTextureCompressionBC() const { return mSupportsTextureCompressionBC; }
+  // Min/max sampler reduction, the depth pyramid for occlusion culling needs it
+  bool SupportsSamplerFilterMinmax() const { return mSupportsSamplerFilterMinmax; }
+  float GetMaxSamplerAnisotropy() const { return mMaxSamplerAnisotropy; }
+  // Queues are shared between the simulation and render threads, hold this around every submit, present and wait idle
+  std::mutex &GetQueueMutex() { return mQueueMutex; }
+  void WaitIdle();
 
+  // Safe from any thread: each thread allocates from its own pool, the submit itself holds the queue mutex
   VkCommandBuffer BeginSingleTimeCommands();
   void EndSingleTimeCommands(VkCommandBuffer commandBuffer);
-  void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+  void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0);
 
 private:
   Window *mWindow = nullptr;
   VkInstance mInstance;
   VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
   VkDevice mDevice;
-  VkSurfaceKHR mSurface;
+  VkSurfaceKHR mSurface = VK_NULL_HANDLE;
   VkQueue mGraphicsQueue;
   VkQueue mPresentQueue;
+  VkQueue mTransferQueue;
   VmaAllocator mAllocator;
   VkCommandPool mCommandPool;
   QueueFamilyIndices mQueueFamilyIndices;
+  std::array<uint32_t, 2> mSharedQueueFamilies{};
+  uint32_t mSharedQueueFamilyCount = 0;
+  VulkanUploader mUploader;
+  std::mutex mQueueMutex;
+  // Command pools are externally synchronized, single-time commands get one per calling thread
+  std::map<std::thread::id, VkCommandPool> mSingleTimePools;
+  std::mutex mSingleTimePoolMutex;
+  bool mSupportsTextureCompressionBC = false;
+  bool mSupportsSamplerFilterMinmax = false;
+  float mMaxSamplerAnisotropy = 1.0f;
 
   const std::array<const char *, 1> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-  const std::array<const char *, 2> deviceExtensions = {
-      VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-      VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME,
-  };
+  std::vector<const char *> GetDeviceExtensions() const;
 
 #ifdef NDEBUG
   const bool enableValidationLayers = false;
@@ -90,4 +119,5 @@ private:
   void CreateSurface();
   void CreateAllocator();
   void CreateCommandPool();
+  VkCommandPool GetSingleTimeCommandPool();
 };
\ No newline at end of file
@@ -1,21 +1,44 @@
 #pragma once
-#include "VulkanContext.hpp"
-#include "VulkanBuffer.hpp"
+#include "GeometryPool.hpp"
+#include "MeshData.hpp"
 #include "Vertex.hpp"
 #include <vector>
+#include <span>
 #include <string>
 
 class VulkanMesh
 {
 public:
-  VulkanBuffer vertexBuffer;
-  VulkanBuffer indexBuffer;
-  uint32_t indexCount = 0;
+  // Range in the geometry pool, holds all LODs
+  GeometryRange geometry;
+  // Finest first, at least one level once loaded. Index ranges are relative to geometry.firstIndex
+  std::vector<MeshLod> lods;
+  // Object space AABB
+  glm::vec3 boundsMin{0.0f};
+  glm::vec3 boundsMax{0.0f};
+  // Object space bounding sphere, center in xyz, radius in w
+  glm::vec4 boundingSphere{0.0f};
 
-  void LoadFromFile(VulkanContext *context, const std::string &filepath);
-  void CreateQuad(VulkanContext *context, float size = 1.0f);
-  void Destroy(VulkanContext *context);
+  void LoadFromFile(GeometryPool &pool, const std::string &filepath);
+  void CreateQuad(GeometryPool &pool, float size = 1.0f);
+  // Returns the range to the pool, no frame may still draw the mesh
+  void Destroy(GeometryPool &pool);
+
+  // Blocking upload through the graphics queue
+  void Upload(GeometryPool &pool, const MeshView &data);
+  // Records the copies on the transfer queue, returns the uploader timeline value that makes the mesh ready
+  uint64_t UploadAsync(GeometryPool &pool, const MeshView &data);
+
+  bool IsReady() const { return mReady; }
+  void SetReady(bool ready) { mReady = ready; }
+
+  // Index in the asset manager's mesh table, objects refer to their mesh by it on the GPU
+  uint32_t GetMeshIndex() const { return mMeshIndex; }
+  void SetMeshIndex(uint32_t index) { mMeshIndex = index; }
 
 private:
-  void UploadBuffers(VulkanContext *context, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices);
-};
\ No newline at end of file
+  bool mReady = false;
+  uint32_t mMeshIndex = 0;
+
+  void SetMeshInfo(const MeshView &data);
+};
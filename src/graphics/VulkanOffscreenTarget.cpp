@@ -0,0 +1,155 @@
+#include "VulkanOffscreenTarget.hpp"
+#include "VulkanBuffer.hpp"
+#include <fstream>
+
+void VulkanOffscreenTarget::Create(VulkanContext *context, VkExtent2D extent, VkFormat format)
+{
+  mExtent = extent;
+  mImageFormat = format;
+
+  VkImageCreateInfo imageInfo{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+      .imageType = VK_IMAGE_TYPE_2D,
+      .format = mImageFormat,
+      .extent = {
+          .width = mExtent.width,
+          .height = mExtent.height,
+          .depth = 1,
+      },
+      .mipLevels = 1,
+      .arrayLayers = 1,
+      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .tiling = VK_IMAGE_TILING_OPTIMAL,
+      .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+      .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+      .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+  };
+
+  VmaAllocationCreateInfo allocInfo{
+      .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+  };
+
+  if (vmaCreateImage(context->GetAllocator(), &imageInfo, &allocInfo, &mImage, &mAllocation, nullptr) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to create offscreen image");
+  }
+
+  VkImageViewCreateInfo viewInfo{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+      .image = mImage,
+      .viewType = VK_IMAGE_VIEW_TYPE_2D,
+      .format = mImageFormat,
+      .subresourceRange = {
+          .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+          .baseMipLevel = 0,
+          .levelCount = 1,
+          .baseArrayLayer = 0,
+          .layerCount = 1,
+      },
+  };
+
+  if (vkCreateImageView(context->GetDevice(), &viewInfo, nullptr, &mImageView) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to create offscreen image view");
+  }
+
+  std::cout << "Offscreen target created. Resolution: " << mExtent.width << "x" << mExtent.height << std::endl;
+}
+
+void VulkanOffscreenTarget::Destroy(const VulkanContext *context)
+{
+  if (mImageView != VK_NULL_HANDLE)
+  {
+    vkDestroyImageView(context->GetDevice(), mImageView, nullptr);
+    mImageView = VK_NULL_HANDLE;
+  }
+  if (mImage != VK_NULL_HANDLE)
+  {
+    vmaDestroyImage(context->GetAllocator(), mImage, mAllocation);
+    mImage = VK_NULL_HANDLE;
+    mAllocation = VK_NULL_HANDLE;
+  }
+}
+
+void VulkanOffscreenTarget::SaveToFile(VulkanContext *context, const std::string &filepath)
+{
+  VkDeviceSize imageSize = static_cast<VkDeviceSize>(mExtent.width) * mExtent.height * 4;
+
+  VulkanBuffer readbackBuffer;
+  readbackBuffer.Create(
+      context->GetAllocator(),
+      imageSize,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VMA_MEMORY_USAGE_AUTO,
+      VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+
+  VkCommandBuffer commandBuffer = context->BeginSingleTimeCommands();
+
+  VkBufferImageCopy2 region{
+      .sType = VK_STRUCTURE_TYPE_BUFFER_IMAGE_COPY_2,
+      .bufferOffset = 0,
+      .bufferRowLength = 0,
+      .bufferImageHeight = 0,
+      .imageSubresource = {
+          .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+          .mipLevel = 0,
+          .baseArrayLayer = 0,
+          .layerCount = 1,
+      },
+      .imageOffset = {0, 0, 0},
+      .imageExtent = {mExtent.width, mExtent.height, 1},
+  };
+
+  VkCopyImageToBufferInfo2 copyInfo{
+      .sType = VK_STRUCTURE_TYPE_COPY_IMAGE_TO_BUFFER_INFO_2,
+      .srcImage = mImage,
+      .srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      .dstBuffer = readbackBuffer.GetBuffer(),
+      .regionCount = 1,
+      .pRegions = &region,
+  };
+
+  vkCmdCopyImageToBuffer2(commandBuffer, &copyInfo);
+
+  VkMemoryBarrier2 hostBarrier{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+      .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+      .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+      .dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+      .dstAccessMask = VK_ACCESS_2_HOST_READ_BIT,
+  };
+
+  VkDependencyInfo dependencyInfo{
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .memoryBarrierCount = 1,
+      .pMemoryBarriers = &hostBarrier,
+  };
+
+  vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+  context->EndSingleTimeCommands(commandBuffer);
+
+  auto *pixels = static_cast<const uint8_t *>(readbackBuffer.Map(context->GetAllocator()));
+  readbackBuffer.Invalidate(context->GetAllocator());
+
+  std::ofstream file(filepath, std::ios::binary);
+  if (!file.is_open())
+  {
+    readbackBuffer.Unmap(context->GetAllocator());
+    readbackBuffer.Destroy(context->GetAllocator());
+    throw std::runtime_error("Failed to open file: " + filepath);
+  }
+
+  file << "P6\n"
+       << mExtent.width << " " << mExtent.height << "\n255\n";
+
+  for (VkDeviceSize i = 0; i != imageSize; i += 4)
+  {
+    file.write(reinterpret_cast<const char *>(pixels + i), 3);
+  }
+
+  readbackBuffer.Unmap(context->GetAllocator());
+  readbackBuffer.Destroy(context->GetAllocator());
+
+  std::cout << "Frame saved to " << filepath << std::endl;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "VulkanContext.hpp"
+#include <string>
+
+// Color image that stands in for the swapchain when there is no surface (headless runs)
+class VulkanOffscreenTarget
+{
+public:
+  void Create(VulkanContext *context, VkExtent2D extent, VkFormat format);
+  void Destroy(const VulkanContext *context);
+  // Copies the image (expected in TRANSFER_SRC_OPTIMAL) to host memory and writes it as binary PPM
+  void SaveToFile(VulkanContext *context, const std::string &filepath);
+
+  VkImage GetImage() const { return mImage; }
+  VkImageView GetImageView() const { return mImageView; }
+  VkFormat GetImageFormat() const { return mImageFormat; }
+  VkExtent2D GetExtent() const { return mExtent; }
+
+private:
+  VkImage mImage = VK_NULL_HANDLE;
+  VmaAllocation mAllocation = VK_NULL_HANDLE;
+  VkImageView mImageView = VK_NULL_HANDLE;
+  VkFormat mImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+  VkExtent2D mExtent{};
+};
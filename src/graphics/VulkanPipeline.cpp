@@ -38,13 +38,17 @@ VkShaderModule VulkanPipeline::CreateShaderModule(const VulkanContext *context,
     return shaderModule;
 }
 
-void VulkanPipeline::Create(VulkanContext *context, const std::string &vertFile, const std::string &fragFile, VkDescriptorSetLayout descriptorSetLayout, VkFormat colorAttachmentFormat, VkFormat depthAttachmentFormat)
+void VulkanPipeline::Create(VulkanContext *context, const std::string &vertFile, const std::string &fragFile, std::span<const VkDescriptorSetLayout> descriptorSetLayouts, VkFormat colorAttachmentFormat, VkFormat depthAttachmentFormat, VkCompareOp depthCompareOp, bool depthWrite, VkPipelineCache pipelineCache)
 {
-    auto vertShaderCode = ReadFile(vertFile);
-    auto fragShaderCode = ReadFile(fragFile);
+    bool depthOnly = fragFile.empty();
 
+    auto vertShaderCode = ReadFile(vertFile);
     VkShaderModule vertShaderModule = CreateShaderModule(context, vertShaderCode);
-    VkShaderModule fragShaderModule = CreateShaderModule(context, fragShaderCode);
+    VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+    if (!depthOnly)
+    {
+        fragShaderModule = CreateShaderModule(context, ReadFile(fragFile));
+    }
 
     VkPipelineShaderStageCreateInfo vertShaderStageInfo{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -65,8 +69,8 @@ void VulkanPipeline::Create(VulkanContext *context, const std::string &vertFile,
     };
 
     // 1. Vertex Input
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+    auto bindingDescription = PackedVertex::getBindingDescription();
+    auto attributeDescriptions = PackedVertex::getAttributeDescriptions();
 
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
@@ -123,8 +127,8 @@ void VulkanPipeline::Create(VulkanContext *context, const std::string &vertFile,
     VkPipelineDepthStencilStateCreateInfo depthStencil{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
         .depthTestEnable = VK_TRUE,
-        .depthWriteEnable = VK_TRUE,
-        .depthCompareOp = VK_COMPARE_OP_LESS,
+        .depthWriteEnable = depthWrite ? VK_TRUE : VK_FALSE,
+        .depthCompareOp = depthCompareOp,
         .depthBoundsTestEnable = VK_FALSE,
         .stencilTestEnable = VK_FALSE,
     };
@@ -137,24 +141,15 @@ void VulkanPipeline::Create(VulkanContext *context, const std::string &vertFile,
     VkPipelineColorBlendStateCreateInfo colorBlending{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
         .logicOpEnable = VK_FALSE,
-        .attachmentCount = 1,
+        .attachmentCount = depthOnly ? 0u : 1u,
         .pAttachments = &colorBlendAttachment,
     };
 
-    // 8. Push Constant
-    VkPushConstantRange pushConstantRange{
-        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
-        .offset = 0,
-        .size = sizeof(MeshPushConstants),
-    };
-
-    // 9. Pipeline Layout
+    // 8. Pipeline Layout (model matrices come from the instance storage buffer, textures from the bindless set)
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .setLayoutCount = 1,
-        .pSetLayouts = &descriptorSetLayout,
-        .pushConstantRangeCount = 1,
-        .pPushConstantRanges = &pushConstantRange,
+        .setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size()),
+        .pSetLayouts = descriptorSetLayouts.data(),
     };
 
     if (vkCreatePipelineLayout(context->GetDevice(), &pipelineLayoutInfo, nullptr, &mPipelineLayout) != VK_SUCCESS)
@@ -162,19 +157,19 @@ void VulkanPipeline::Create(VulkanContext *context, const std::string &vertFile,
         throw std::runtime_error("Failed to create pipeline layout");
     }
 
-    // 10. Dynamic Rendering Info
+    // 9. Dynamic Rendering Info
     VkPipelineRenderingCreateInfo pipelineRenderingInfo{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
-        .colorAttachmentCount = 1,
+        .colorAttachmentCount = depthOnly ? 0u : 1u,
         .pColorAttachmentFormats = &colorAttachmentFormat,
         .depthAttachmentFormat = depthAttachmentFormat,
     };
 
-    // 11. Build
+    // 10. Build
     VkGraphicsPipelineCreateInfo pipelineInfo{
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
         .pNext = &pipelineRenderingInfo,
-        .stageCount = 2,
+        .stageCount = depthOnly ? 1u : 2u,
         .pStages = shaderStages.data(),
         .pVertexInputState = &vertexInputInfo,
         .pInputAssemblyState = &inputAssembly,
@@ -189,18 +184,66 @@ void VulkanPipeline::Create(VulkanContext *context, const std::string &vertFile,
         .subpass = 0,
     };
 
-    if (vkCreateGraphicsPipelines(context->GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &mPipeline) != VK_SUCCESS)
+    if (vkCreateGraphicsPipelines(context->GetDevice(), pipelineCache, 1, &pipelineInfo, nullptr, &mPipeline) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to create graphics pipeline");
     }
 
     std::cout << "Vulkan Graphics Pipeline created successfully" << std::endl;
 
-    // 12. Delete Shader modules
-    vkDestroyShaderModule(context->GetDevice(), fragShaderModule, nullptr);
+    // 11. Delete Shader modules
+    if (fragShaderModule != VK_NULL_HANDLE)
+    {
+        vkDestroyShaderModule(context->GetDevice(), fragShaderModule, nullptr);
+    }
     vkDestroyShaderModule(context->GetDevice(), vertShaderModule, nullptr);
 }
 
+void VulkanPipeline::CreateCompute(VulkanContext *context, const std::string &compFile, std::span<const VkDescriptorSetLayout> descriptorSetLayouts, uint32_t pushConstantSize, VkPipelineCache pipelineCache)
+{
+    mBindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+
+    auto compShaderCode = ReadFile(compFile);
+    VkShaderModule compShaderModule = CreateShaderModule(context, compShaderCode);
+
+    VkPushConstantRange pushConstantRange{
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = pushConstantSize,
+    };
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size()),
+        .pSetLayouts = descriptorSetLayouts.data(),
+        .pushConstantRangeCount = pushConstantSize > 0 ? 1u : 0u,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+
+    if (vkCreatePipelineLayout(context->GetDevice(), &pipelineLayoutInfo, nullptr, &mPipelineLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create compute pipeline layout");
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo{
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = compShaderModule,
+            .pName = "main",
+        },
+        .layout = mPipelineLayout,
+    };
+
+    if (vkCreateComputePipelines(context->GetDevice(), pipelineCache, 1, &pipelineInfo, nullptr, &mPipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create compute pipeline");
+    }
+
+    vkDestroyShaderModule(context->GetDevice(), compShaderModule, nullptr);
+}
+
 void VulkanPipeline::Destroy(const VulkanContext *context)
 {
     if (mPipeline != VK_NULL_HANDLE)
@@ -217,5 +260,5 @@ void VulkanPipeline::Destroy(const VulkanContext *context)
 
 void VulkanPipeline::Bind(VkCommandBuffer commandBuffer)
 {
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipeline);
+    vkCmdBindPipeline(commandBuffer, mBindPoint, mPipeline);
 }
\ No newline at end of file
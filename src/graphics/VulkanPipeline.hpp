@@ -3,22 +3,28 @@
 #include "Vertex.hpp"
 #include <string>
 #include <vector>
-
-struct MeshPushConstants
-{
-  glm::mat4 model;
-};
+#include <span>
 
 class VulkanPipeline
 {
 public:
+  // An empty fragFile builds a depth-only pipeline without color attachments
   void Create(
       VulkanContext *context,
       const std::string &vertFile,
       const std::string &fragFile,
-      VkDescriptorSetLayout descriptorSetLayout,
+      std::span<const VkDescriptorSetLayout> descriptorSetLayouts,
       VkFormat colorAttachmentFormat,
-      VkFormat depthAttachmentFormat);
+      VkFormat depthAttachmentFormat,
+      VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS,
+      bool depthWrite = true,
+      VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+  void CreateCompute(
+      VulkanContext *context,
+      const std::string &compFile,
+      std::span<const VkDescriptorSetLayout> descriptorSetLayouts,
+      uint32_t pushConstantSize,
+      VkPipelineCache pipelineCache = VK_NULL_HANDLE);
   void Destroy(const VulkanContext *context);
   void Bind(VkCommandBuffer commandBuffer);
 
@@ -28,10 +34,12 @@ public:
   }
   VkPipelineLayout GetPipelineLayout() const { return mPipelineLayout; }
 
+  static std::vector<char> ReadFile(const std::string &filename);
+
 private:
   VkPipeline mPipeline = VK_NULL_HANDLE;
   VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;
+  VkPipelineBindPoint mBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 
   VkShaderModule CreateShaderModule(const VulkanContext *context, const std::vector<char> &code);
-  static std::vector<char> ReadFile(const std::string &filename);
 };
\ No newline at end of file
@@ -1,34 +1,97 @@
 #include "VulkanRenderer.hpp"
+#include "../core/Logger.hpp"
 
-void VulkanRenderer::Init(VulkanContext *context)
+void VulkanRenderer::Init(VulkanContext *context, AssetManager *assets, JobSystem *jobs, const RendererSettings &settings)
 {
   mContext = context;
-  SetFramebufferSizeCallback();
+  mAssets = assets;
+  mJobs = jobs;
+  mHeadless = mContext->GetWindow()->IsHeadless();
+  mFramesInFlight = std::clamp(settings.framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT);
+  mFrameArenas = std::make_unique<FrameArena[]>(mFramesInFlight);
+  mDepthPrepass = settings.depthPrepass;
+  mOcclusionCulling = settings.occlusionCulling;
+  if (mOcclusionCulling && !mContext->SupportsSamplerFilterMinmax())
+  {
+    Logger::Log(LogLevel::Warning, "Device has no samplerFilterMinmax, occlusion culling is disabled");
+    mOcclusionCulling = false;
+  }
 
-  mSwapchain.Create(mContext);
+  if (mHeadless)
+  {
+    VkExtent2D extent{
+        static_cast<uint32_t>(mContext->GetWindow()->GetFramebufferWidth()),
+        static_cast<uint32_t>(mContext->GetWindow()->GetFramebufferHeight()),
+    };
+    mOffscreenTarget.Create(mContext, extent, VK_FORMAT_R8G8B8A8_UNORM);
+  }
+  else
+  {
+    SetFramebufferSizeCallback();
+    mSwapchain.Create(mContext, settings.presentMode);
+  }
 
   CreateDepthResources();
 
   CreateDescriptorSetLayout();
 
-  mPipeline.Create(mContext, "shaders/vert.spv", "shaders/frag.spv", mDescriptorSetLayout, mSwapchain.GetImageFormat(), mDepthFormat);
+  // Pipelines compile in the background while the rest of the renderer is set up.
+  // After a pre-pass depth is final, shading only tests against it
+  GraphicsPipelineDesc pipelineDesc{
+      .vertFile = "shaders/shader.vert.spv",
+      .fragFile = "shaders/shader.frag.spv",
+      .descriptorSetLayouts = {mDescriptorSetLayout, mAssets->GetBindlessLayout()},
+      .colorAttachmentFormat = GetTargetFormat(),
+      .depthAttachmentFormat = mDepthFormat,
+      .depthCompareOp = mDepthPrepass ? VK_COMPARE_OP_LESS_OR_EQUAL : VK_COMPARE_OP_LESS,
+      .depthWrite = !mDepthPrepass,
+  };
+  GraphicsPipelineDesc depthPipelineDesc{
+      .vertFile = "shaders/shader.vert.spv",
+      .descriptorSetLayouts = {mDescriptorSetLayout, mAssets->GetBindlessLayout()},
+      .colorAttachmentFormat = GetTargetFormat(),
+      .depthAttachmentFormat = mDepthFormat,
+  };
+  ComputePipelineDesc cullPipelineDesc{
+      .compFile = "shaders/cull.comp.spv",
+      .descriptorSetLayouts = {mDescriptorSetLayout},
+      .pushConstantSize = sizeof(CullConstants),
+  };
+  mPipelines.Init(mContext);
+  mPipelines.Precompile(pipelineDesc);
+  mPipelines.Precompile(cullPipelineDesc);
+  if (mDepthPrepass)
+  {
+    mPipelines.Precompile(depthPipelineDesc);
+  }
 
-  CreateUniformBuffers();
+  // Always created, the cull shader binds the pyramid even when it never samples it
+  mDepthPyramid.Init(mContext, mPipelines);
+  mDepthPyramid.Resize(GetTargetExtent(), mDepthImageView);
 
-  mTexture.Create(mContext, "textures/Image_1.jpg");
+  mUploadRing.Init(mContext, mFramesInFlight);
+  CreateFrameBuffers();
 
   CreateDescriptorPool();
   CreateDescriptorSets();
 
   CreateCommandBuffers();
   CreateSyncObjects();
+  CreateTimestampQueries();
+
+  mPipeline = mPipelines.Get(pipelineDesc);
+  mCullPipeline = mPipelines.Get(cullPipelineDesc);
+  if (mDepthPrepass)
+  {
+    mDepthPipeline = mPipelines.Get(depthPipelineDesc);
+  }
 }
 
 void VulkanRenderer::Cleanup()
 {
   WaitIdle();
 
-  for (size_t i = 0; i != MAX_FRAMES_IN_FLIGHT; ++i)
+  for (size_t i = 0; i != mFramesInFlight; ++i)
   {
     vkDestroySemaphore(mContext->GetDevice(), mImageAvailableSemaphores[i], nullptr);
     vkDestroyFence(mContext->GetDevice(), mInFlightFences[i], nullptr);
@@ -40,13 +103,41 @@ void VulkanRenderer::Cleanup()
 
   vkDestroyDescriptorPool(mContext->GetDevice(), mDescriptorPool, nullptr);
 
-  for (size_t i = 0; i != MAX_FRAMES_IN_FLIGHT; ++i)
+  if (mTimestampPool != VK_NULL_HANDLE)
+  {
+    vkDestroyQueryPool(mContext->GetDevice(), mTimestampPool, nullptr);
+    mTimestampPool = VK_NULL_HANDLE;
+  }
+
+  for (size_t i = 0; i != mFramesInFlight; ++i)
   {
-    mUniformBuffers[i].Unmap(mContext->GetAllocator());
-    mUniformBuffers[i].Destroy(mContext->GetAllocator());
+    mVisibleBuffers[i].Destroy(mContext->GetAllocator());
+
+    mDrawCommandBuffers[i].Unmap(mContext->GetAllocator());
+    mDrawCommandBuffers[i].Destroy(mContext->GetAllocator());
+    mDrawCountBuffers[i].Unmap(mContext->GetAllocator());
+    mDrawCountBuffers[i].Destroy(mContext->GetAllocator());
+    mMeshInfoBuffers[i].Unmap(mContext->GetAllocator());
+    mMeshInfoBuffers[i].Destroy(mContext->GetAllocator());
+    mCullStatsBuffers[i].Unmap(mContext->GetAllocator());
+    mCullStatsBuffers[i].Destroy(mContext->GetAllocator());
   }
+  mObjectBuffer.Destroy(mContext->GetAllocator());
+  mVisibilityBuffer.Destroy(mContext->GetAllocator());
+  mUploadRing.Cleanup();
 
-  mPipeline.Destroy(mContext);
+  for (VkCommandPool pool : mRecordingPools)
+  {
+    vkDestroyCommandPool(mContext->GetDevice(), pool, nullptr);
+  }
+  mRecordingPools.clear();
+  mRecordingBuffers.clear();
+
+  mDepthPyramid.Cleanup();
+  mPipelines.Cleanup();
+  mPipeline = nullptr;
+  mDepthPipeline = nullptr;
+  mCullPipeline = nullptr;
 
   vkDestroyDescriptorSetLayout(mContext->GetDevice(), mDescriptorSetLayout, nullptr);
 
@@ -54,22 +145,76 @@ void VulkanRenderer::Cleanup()
   vmaDestroyImage(mContext->GetAllocator(), mDepthImage, mDepthAllocation);
 
   mSwapchain.Destroy(mContext);
-  mTexture.Destroy(mContext);
+  mOffscreenTarget.Destroy(mContext);
 
   mContext = nullptr;
 }
 
 void VulkanRenderer::WaitIdle()
 {
-  if (mContext && mContext->GetDevice() != VK_NULL_HANDLE)
+  if (mContext)
+  {
+    mContext->WaitIdle();
+  }
+}
+
+void VulkanRenderer::WaitForQueuedFrames(uint32_t maxQueuedFrames)
+{
+  // DrawFrame's own fence wait already leaves at most mFramesInFlight - 1 frames queued
+  if (maxQueuedFrames + 1 >= mFramesInFlight)
+  {
+    return;
+  }
+
+  // Fences signal in submission order: once the (maxQueuedFrames + 1)-th most recent frame is done, only maxQueuedFrames remain.
+  // Fences of frames never submitted are created signaled
+  uint32_t frame = (mCurrentFrame + mFramesInFlight - maxQueuedFrames - 1) % mFramesInFlight;
+
+  PROFILE_SCOPE("Latency Wait");
+  auto waitBegin = Profiler::Clock::now();
+  vkWaitForFences(mContext->GetDevice(), 1, &mInFlightFences[frame], VK_TRUE, UINT64_MAX);
+  Profiler::RecordCounter("Latency Wait ms", std::chrono::duration<double, std::milli>(Profiler::Clock::now() - waitBegin).count());
+}
+
+void VulkanRenderer::SaveFrame(const std::string &filepath)
+{
+  if (!mHeadless)
   {
-    vkDeviceWaitIdle(mContext->GetDevice());
+    throw std::runtime_error("SaveFrame is only supported in headless mode");
   }
+
+  WaitIdle();
+  mOffscreenTarget.SaveToFile(mContext, filepath);
+}
+
+VkExtent2D VulkanRenderer::GetTargetExtent() const
+{
+  return mHeadless ? mOffscreenTarget.GetExtent() : mSwapchain.GetExtent();
+}
+
+VkFormat VulkanRenderer::GetTargetFormat() const
+{
+  return mHeadless ? mOffscreenTarget.GetImageFormat() : mSwapchain.GetImageFormat();
+}
+
+VkImage VulkanRenderer::GetTargetImage(uint32_t imageIndex) const
+{
+  return mHeadless ? mOffscreenTarget.GetImage() : mSwapchain.GetImage(imageIndex);
+}
+
+VkImageView VulkanRenderer::GetTargetImageView(uint32_t imageIndex) const
+{
+  return mHeadless ? mOffscreenTarget.GetImageView() : mSwapchain.GetImageView(imageIndex);
+}
+
+uint32_t VulkanRenderer::GetTargetImageCount() const
+{
+  return mHeadless ? 1 : static_cast<uint32_t>(mSwapchain.GetImages().size());
 }
 
 void VulkanRenderer::CreateCommandBuffers()
 {
-  mCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+  mCommandBuffers.resize(mFramesInFlight);
 
   VkCommandBufferAllocateInfo allocInfo{
       .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
@@ -81,13 +226,44 @@ void VulkanRenderer::CreateCommandBuffers()
   {
     throw std::runtime_error("Failed to allocate command buffers");
   }
+
+  // One pool per recording chunk, draw pass and frame in flight: a chunk is recorded by exactly one job, so no pool is
+  // ever touched by two threads, and a frame resets its pools only after its fence
+  mRecordingChunkCapacity = mJobs ? mJobs->GetThreadCount() : 1;
+  mRecordingPools.resize(mFramesInFlight * MAX_DRAW_PASSES * mRecordingChunkCapacity);
+  mRecordingBuffers.resize(mRecordingPools.size());
+
+  VkCommandPoolCreateInfo poolInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+      .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+      .queueFamilyIndex = mContext->GetGraphicsFamily(),
+  };
+
+  for (size_t i = 0; i != mRecordingPools.size(); ++i)
+  {
+    if (vkCreateCommandPool(mContext->GetDevice(), &poolInfo, nullptr, &mRecordingPools[i]) != VK_SUCCESS)
+    {
+      throw std::runtime_error("Failed to create recording command pool");
+    }
+
+    VkCommandBufferAllocateInfo secondaryInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = mRecordingPools[i],
+        .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+        .commandBufferCount = 1,
+    };
+    if (vkAllocateCommandBuffers(mContext->GetDevice(), &secondaryInfo, &mRecordingBuffers[i]) != VK_SUCCESS)
+    {
+      throw std::runtime_error("Failed to allocate secondary command buffers");
+    }
+  }
 }
 
 void VulkanRenderer::CreateSyncObjects()
 {
-  mImageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-  mRenderFinishedSemaphores.resize(mSwapchain.GetImages().size());
-  mInFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+  mImageAvailableSemaphores.resize(mFramesInFlight);
+  mRenderFinishedSemaphores.resize(GetTargetImageCount());
+  mInFlightFences.resize(mFramesInFlight);
 
   VkSemaphoreCreateInfo semaphoreInfo{
       .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
@@ -97,7 +273,7 @@ void VulkanRenderer::CreateSyncObjects()
       .flags = VK_FENCE_CREATE_SIGNALED_BIT,
   };
 
-  for (size_t i = 0; i != MAX_FRAMES_IN_FLIGHT; ++i)
+  for (size_t i = 0; i != mFramesInFlight; ++i)
   {
     if (vkCreateSemaphore(mContext->GetDevice(), &semaphoreInfo, nullptr, &mImageAvailableSemaphores[i]) != VK_SUCCESS ||
         vkCreateFence(mContext->GetDevice(), &fenceInfo, nullptr, &mInFlightFences[i]) != VK_SUCCESS)
@@ -106,7 +282,7 @@ void VulkanRenderer::CreateSyncObjects()
     }
   }
 
-  for (size_t i = 0; i != mSwapchain.GetImages().size(); ++i)
+  for (size_t i = 0; i != GetTargetImageCount(); ++i)
   {
     if (vkCreateSemaphore(mContext->GetDevice(), &semaphoreInfo, nullptr, &mRenderFinishedSemaphores[i]) != VK_SUCCESS)
     {
@@ -115,6 +291,84 @@ void VulkanRenderer::CreateSyncObjects()
   }
 }
 
+void VulkanRenderer::CreateTimestampQueries()
+{
+  mTimestampsPending.assign(mFramesInFlight, false);
+  mFrameSubmitTimes.resize(mFramesInFlight);
+
+  uint32_t queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(mContext->GetPhysicalDevice(), &queueFamilyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(mContext->GetPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+  uint32_t validBits = queueFamilies[mContext->GetGraphicsFamily()].timestampValidBits;
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(mContext->GetPhysicalDevice(), &properties);
+
+  if (validBits == 0 || properties.limits.timestampPeriod == 0.0f)
+  {
+    Logger::Log(LogLevel::Warning, "Graphics queue has no timestamp support, GPU timings are disabled");
+    return;
+  }
+
+  mTimestampPeriod = properties.limits.timestampPeriod;
+  mTimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+  VkQueryPoolCreateInfo queryPoolInfo{
+      .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+      .queryType = VK_QUERY_TYPE_TIMESTAMP,
+      .queryCount = 2 * mFramesInFlight,
+  };
+
+  if (vkCreateQueryPool(mContext->GetDevice(), &queryPoolInfo, nullptr, &mTimestampPool) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to create timestamp query pool");
+  }
+}
+
+void VulkanRenderer::ReadTimestamps(uint32_t frame)
+{
+  if (mTimestampPool == VK_NULL_HANDLE || !mTimestampsPending[frame])
+  {
+    return;
+  }
+
+  // Called after the frame's fence, the results are available without waiting
+  std::array<uint64_t, 2> timestamps{};
+  VkResult result = vkGetQueryPoolResults(mContext->GetDevice(), mTimestampPool, frame * 2, 2,
+                                          sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+  mTimestampsPending[frame] = false;
+
+  if (result != VK_SUCCESS)
+  {
+    return;
+  }
+
+  uint64_t ticks = (timestamps[1] - timestamps[0]) & mTimestampMask;
+  double durationMs = static_cast<double>(ticks) * mTimestampPeriod / 1000000.0;
+
+  Profiler::RecordGpu("GPU Render Pass", mFrameSubmitTimes[frame], durationMs);
+}
+
+void VulkanRenderer::ReadCullStats(uint32_t frame)
+{
+  if (!mOcclusionCulling)
+  {
+    return;
+  }
+
+  // Called after the frame's fence, then cleared for the next use of the buffer
+  auto *stats = static_cast<CullStats *>(mCullStatsBuffersMapped[frame]);
+  mCullStatsBuffers[frame].Invalidate(mContext->GetAllocator());
+  mCullStats = *stats;
+  *stats = {};
+  mCullStatsBuffers[frame].Flush(mContext->GetAllocator(), 0, sizeof(CullStats));
+
+  Profiler::RecordCounter("Occlusion Culled", static_cast<double>(mCullStats.occlusionCulled));
+  Profiler::RecordCounter("Late Pass Objects", static_cast<double>(mCullStats.lateDrawn));
+}
+
 void VulkanRenderer::CreatePipelineBarrierEntry(VkCommandBuffer commandBuffer, uint32_t imageIndex)
 {
   VkImageMemoryBarrier2 barrier{
@@ -125,7 +379,7 @@ void VulkanRenderer::CreatePipelineBarrierEntry(VkCommandBuffer commandBuffer, u
       .dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
       .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
       .newLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL,
-      .image = mSwapchain.GetImage(imageIndex),
+      .image = GetTargetImage(imageIndex),
       .subresourceRange = {
           .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
           .baseMipLevel = 0,
@@ -154,7 +408,7 @@ void VulkanRenderer::CreatePipelineBarrierOut(VkCommandBuffer commandBuffer, uin
       .dstAccessMask = 0,
       .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
       .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-      .image = mSwapchain.GetImage(imageIndex),
+      .image = GetTargetImage(imageIndex),
       .subresourceRange = {
           .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
           .baseMipLevel = 0,
@@ -164,6 +418,14 @@ void VulkanRenderer::CreatePipelineBarrierOut(VkCommandBuffer commandBuffer, uin
       },
   };
 
+  // Headless: keep the image ready for readback instead of present
+  if (mHeadless)
+  {
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  }
+
   VkDependencyInfo dependencyInfo{
       .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
       .imageMemoryBarrierCount = 1,
@@ -172,8 +434,278 @@ void VulkanRenderer::CreatePipelineBarrierOut(VkCommandBuffer commandBuffer, uin
   vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
 };
 
-void VulkanRenderer::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const std::vector<RenderObject> &renderQueue)
+void VulkanRenderer::QueueObjectUpdates(const std::vector<ObjectUpdate> &updates)
+{
+  for (const auto &update : updates)
+  {
+    if (update.slot >= mPendingSlots.size())
+    {
+      mPendingSlots.resize(update.slot + 1, 0);
+    }
+
+    uint32_t &pending = mPendingSlots[update.slot];
+    if (pending != 0)
+    {
+      mPendingUpdates[pending - 1].data = update.data;
+    }
+    else
+    {
+      mPendingUpdates.push_back(update);
+      pending = static_cast<uint32_t>(mPendingUpdates.size());
+    }
+  }
+}
+
+void VulkanRenderer::PrepareDraws(const RenderSnapshot &snapshot)
+{
+  mObjectCount = snapshot.objectCount;
+  mMeshDraws.assign(snapshot.meshes.begin(), snapshot.meshes.end());
+  mVertexBuffer = snapshot.vertexBuffer;
+  mIndexBuffer = snapshot.indexBuffer;
+  mGeometryReadyValue = snapshot.geometryReadyValue;
+
+  if (mObjectCount > mObjectCapacity)
+  {
+    GrowObjectBuffer(std::max(mObjectCount, mObjectCapacity * 2));
+  }
+
+  // The fence of this frame is already waited, so its buffers and descriptor set can be replaced.
+  // The late cull pass gets a second command set and visible range after the first
+  uint32_t commandSetCount = mOcclusionCulling ? 2 : 1;
+  bool resized = false;
+  uint32_t visibleCount = mObjectCount * MAX_MESH_LODS * commandSetCount;
+  if (visibleCount > mVisibleCapacities[mCurrentFrame])
+  {
+    CreateVisibleBuffer(mCurrentFrame, std::max(visibleCount, mVisibleCapacities[mCurrentFrame] * 2));
+    resized = true;
+  }
+  uint32_t meshCount = static_cast<uint32_t>(mMeshDraws.size());
+  if (meshCount * commandSetCount > mDrawCapacities[mCurrentFrame])
+  {
+    CreateDrawBuffers(mCurrentFrame, std::max(meshCount * commandSetCount, mDrawCapacities[mCurrentFrame] * 2));
+    resized = true;
+  }
+  if (resized)
+  {
+    WriteFrameDescriptors(mCurrentFrame);
+  }
+
+  // Every LOD of a mesh reserves room for all of its objects in the visible index buffer,
+  // its command starts with no instances and the cull shader counts them up. A mesh still streaming in
+  // has no LODs but the shader appends its objects at LOD0 all the same, so that one range is always
+  // reserved; its command keeps indexCount 0 and draws nothing
+  auto *commands = static_cast<VkDrawIndexedIndirectCommand *>(mDrawCommandBuffersMapped[mCurrentFrame]);
+  auto *drawCounts = static_cast<uint32_t *>(mDrawCountBuffersMapped[mCurrentFrame]);
+  auto *meshInfos = static_cast<MeshInfo *>(mMeshInfoBuffersMapped[mCurrentFrame]);
+  uint32_t firstInstance = 0;
+  for (uint32_t i = 0; i != meshCount; ++i)
+  {
+    const VulkanMesh *mesh = mMeshDraws[i].mesh;
+    uint32_t lodCount = mesh ? static_cast<uint32_t>(mesh->lods.size()) : 0;
+    uint32_t reservedLods = std::max(lodCount, 1u);
+
+    // Missing levels can never be picked
+    MeshInfo &info = meshInfos[i];
+    info.lodErrors = glm::vec4(FLT_MAX);
+    info.positionOffset = mesh ? glm::vec4(mesh->boundsMin, 0.0f) : glm::vec4(0.0f);
+    info.positionScale = mesh ? glm::vec4(mesh->boundsMax - mesh->boundsMin, 0.0f) : glm::vec4(0.0f);
+    for (uint32_t lod = 0; lod != MAX_MESH_LODS; ++lod)
+    {
+      VkDrawIndexedIndirectCommand &command = commands[i * MAX_MESH_LODS + lod];
+      command = {
+          .indexCount = 0,
+          .instanceCount = 0,
+          .firstIndex = 0,
+          .vertexOffset = 0,
+          .firstInstance = firstInstance,
+      };
+
+      if (lod < lodCount)
+      {
+        command.indexCount = mesh->lods[lod].indexCount;
+        command.firstIndex = mMeshDraws[i].firstIndex + mesh->lods[lod].firstIndex;
+        command.vertexOffset = mMeshDraws[i].vertexOffset;
+        info.lodErrors[lod] = mesh->lods[lod].error;
+      }
+      if (lod < reservedLods)
+      {
+        firstInstance += mMeshDraws[i].objectCount;
+      }
+    }
+    drawCounts[i] = 0;
+  }
+
+  // The late set repeats the early one over its own visible range
+  if (mOcclusionCulling)
+  {
+    uint32_t earlyCommandCount = meshCount * MAX_MESH_LODS;
+    for (uint32_t i = 0; i != earlyCommandCount; ++i)
+    {
+      commands[earlyCommandCount + i] = commands[i];
+      commands[earlyCommandCount + i].firstInstance += firstInstance;
+    }
+    std::fill_n(drawCounts + meshCount, meshCount, 0u);
+  }
+}
+
+void VulkanRenderer::GrowObjectBuffer(uint32_t capacity)
+{
+  // Every frame in flight reads the object buffer, a rare stall keeps the swap simple
+  WaitIdle();
+
+  VulkanBuffer objectBuffer;
+  objectBuffer.Create(
+      mContext->GetAllocator(),
+      sizeof(ObjectData) * capacity,
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+
+  if (mObjectCapacity > 0)
+  {
+    mContext->CopyBuffer(mObjectBuffer.GetBuffer(), objectBuffer.GetBuffer(), sizeof(ObjectData) * mObjectCapacity);
+  }
+
+  mObjectBuffer.Destroy(mContext->GetAllocator());
+  mObjectBuffer = std::move(objectBuffer);
+  mObjectCapacity = capacity;
+
+  // Everything counts as hidden for one frame: the late pass of the next frame draws and marks it
+  mVisibilityBuffer.Destroy(mContext->GetAllocator());
+  mVisibilityBuffer.Create(mContext->GetAllocator(), sizeof(uint32_t) * capacity,
+                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+  VkCommandBuffer commandBuffer = mContext->BeginSingleTimeCommands();
+  vkCmdFillBuffer(commandBuffer, mVisibilityBuffer.GetBuffer(), 0, VK_WHOLE_SIZE, 0);
+  mContext->EndSingleTimeCommands(commandBuffer);
+
+  // Descriptor sets do not exist yet on the first call from Init
+  for (uint32_t i = 0; i != mDescriptorSets.size(); ++i)
+  {
+    WriteFrameDescriptors(i);
+  }
+}
+
+void VulkanRenderer::RecordObjectUpdates(VkCommandBuffer commandBuffer)
+{
+  if (mPendingUpdates.empty())
+  {
+    return;
+  }
+
+  UploadAllocation stagingAllocation = mUploadRing.Allocate(sizeof(ObjectData) * mPendingUpdates.size(), alignof(ObjectData));
+  auto *staging = static_cast<ObjectData *>(stagingAllocation.data);
+  std::pmr::vector<VkBufferCopy> copies(&mFrameArenas[mCurrentFrame]);
+  copies.reserve(mPendingUpdates.size());
+
+  for (uint32_t i = 0; i != mPendingUpdates.size(); ++i)
+  {
+    const ObjectUpdate &update = mPendingUpdates[i];
+    staging[i] = update.data;
+    copies.push_back({
+        .srcOffset = stagingAllocation.offset + sizeof(ObjectData) * i,
+        .dstOffset = sizeof(ObjectData) * update.slot,
+        .size = sizeof(ObjectData),
+    });
+    mPendingSlots[update.slot] = 0;
+  }
+  mPendingUpdates.clear();
+
+  // Earlier frames may still read the slots being overwritten
+  VkMemoryBarrier2 beforeCopy{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+      .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+      .srcAccessMask = VK_ACCESS_2_NONE,
+      .dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+      .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+  };
+  VkDependencyInfo beforeDependency{
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .memoryBarrierCount = 1,
+      .pMemoryBarriers = &beforeCopy,
+  };
+  vkCmdPipelineBarrier2(commandBuffer, &beforeDependency);
+
+  vkCmdCopyBuffer(commandBuffer, stagingAllocation.buffer, mObjectBuffer.GetBuffer(),
+                  static_cast<uint32_t>(copies.size()), copies.data());
+
+  VkMemoryBarrier2 afterCopy{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+      .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+      .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+      .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+      .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+  };
+  VkDependencyInfo afterDependency{
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .memoryBarrierCount = 1,
+      .pMemoryBarriers = &afterCopy,
+  };
+  vkCmdPipelineBarrier2(commandBuffer, &afterDependency);
+}
+
+void VulkanRenderer::RecordCulling(VkCommandBuffer commandBuffer, const CameraRenderData &cameraData, uint32_t pass)
+{
+  if (mObjectCount == 0)
+  {
+    return;
+  }
+
+  // Vulkan projections may flip y, the focal length is the magnitude
+  float pixelsPerError = GetTargetExtent().height * 0.5f * std::abs(cameraData.projection[1][1]) / LOD_PIXEL_ERROR;
+
+  CullConstants constants{
+      .cameraPosition = glm::vec4(glm::vec3(glm::inverse(cameraData.view)[3]), pixelsPerError),
+      .objectCount = mObjectCount,
+      .meshCount = static_cast<uint32_t>(mMeshDraws.size()),
+      .pass = pass,
+  };
+
+  // The early pass reads the visibility the previous frame's late pass wrote
+  if (pass == CULL_EARLY)
+  {
+    VkMemoryBarrier2 visibilityBarrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+    };
+    VkDependencyInfo visibilityDependency{
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = &visibilityBarrier,
+    };
+    vkCmdPipelineBarrier2(commandBuffer, &visibilityDependency);
+  }
+
+  Frustum frustum = Frustum::FromMatrix(cameraData.projection * cameraData.view);
+  std::copy(std::begin(frustum.planes), std::end(frustum.planes), constants.frustumPlanes);
+
+  mCullPipeline->Bind(commandBuffer);
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mCullPipeline->GetPipelineLayout(), 0, 1, &mDescriptorSets[mCurrentFrame], 1, &mUniformOffset);
+  vkCmdPushConstants(commandBuffer, mCullPipeline->GetPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+  vkCmdDispatch(commandBuffer, (mObjectCount + 63) / 64, 1, 1);
+
+  // Commands and counts feed the indirect draws, visible indices the vertex shader.
+  // The late pass also waits for the early pass's writes
+  VkMemoryBarrier2 barrier{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+      .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+      .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+      .dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+      .dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+  };
+  VkDependencyInfo dependencyInfo{
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .memoryBarrierCount = 1,
+      .pMemoryBarriers = &barrier,
+  };
+  vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+
+void VulkanRenderer::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const CameraRenderData &cameraData)
 {
+  PROFILE_SCOPE("RecordCommandBuffer");
+
   VkCommandBufferBeginInfo beginInfo{
       .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
   };
@@ -185,20 +717,89 @@ void VulkanRenderer::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t
 
   CreatePipelineBarrierEntry(commandBuffer, imageIndex);
 
-  // Переводим изображение из формата "Непонятно что" в "Куда можно рисовать цвет"
-  // Для простоты пока опустим явные барьеры ImageMemoryBarrier,
-  // так как Subpass Dependencies в RenderPass делали это за нас,
-  // но в Dynamic Rendering Swapchain обычно сам справляется при правильной настройке,
-  // однако правильнее будет сделать Transition Layout.
-  // ДЛЯ ПЕРВОГО ТРЕУГОЛЬНИКА Vulkan часто прощает отсутствие явного барьера здесь,
-  // потом понадобится PipelineBarrier для перехода layout.
+  if (mTimestampPool != VK_NULL_HANDLE)
+  {
+    vkCmdResetQueryPool(commandBuffer, mTimestampPool, mCurrentFrame * 2, 2);
+    vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, mTimestampPool, mCurrentFrame * 2);
+  }
+
+  RecordObjectUpdates(commandBuffer);
+
+  // Meshes the CPU pass found fully off screen are skipped
+  std::pmr::vector<uint32_t> drawList(&mFrameArenas[mCurrentFrame]);
+  drawList.reserve(mMeshDraws.size());
+  for (uint32_t i = 0; i != mMeshDraws.size(); ++i)
+  {
+    if (mMeshDraws[i].mesh && mMeshDraws[i].visibleCount != 0)
+    {
+      drawList.push_back(i);
+    }
+  }
+
+  // Render start
+  if (!mOcclusionCulling)
+  {
+    RecordCulling(commandBuffer, cameraData, CULL_SINGLE);
+    if (mDepthPrepass)
+    {
+      RecordDrawPass(commandBuffer, imageIndex, {mDepthPipeline, 0, 1, true, false, true, true}, 0, drawList);
+      RecordDrawPass(commandBuffer, imageIndex, {mPipeline, 0, 1, false, true, false, false}, 1, drawList);
+    }
+    else
+    {
+      RecordDrawPass(commandBuffer, imageIndex, {mPipeline, 0, 1, false, true, true, false}, 0, drawList);
+    }
+  }
+  else
+  {
+    // Early: what was visible last frame, its depth builds the pyramid the late pass tests everything else against
+    RecordCulling(commandBuffer, cameraData, CULL_EARLY);
+    if (mDepthPrepass)
+    {
+      RecordDrawPass(commandBuffer, imageIndex, {mDepthPipeline, 0, 1, true, false, true, true}, 0, drawList);
+    }
+    else
+    {
+      RecordDrawPass(commandBuffer, imageIndex, {mPipeline, 0, 1, false, true, true, true}, 0, drawList);
+    }
+
+    mDepthPyramid.Build(commandBuffer, mDepthImage);
+    RecordCulling(commandBuffer, cameraData, CULL_LATE);
 
+    // Late: objects the early pass missed, newly visible ones appear in this frame already
+    if (mDepthPrepass)
+    {
+      RecordDrawPass(commandBuffer, imageIndex, {mDepthPipeline, 1, 1, true, false, false, true}, 1, drawList);
+      RecordDrawPass(commandBuffer, imageIndex, {mPipeline, 0, 2, false, true, false, false}, 2, drawList);
+    }
+    else
+    {
+      RecordDrawPass(commandBuffer, imageIndex, {mPipeline, 1, 1, false, false, false, false}, 1, drawList);
+    }
+  }
+
+  if (mTimestampPool != VK_NULL_HANDLE)
+  {
+    vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT, mTimestampPool, mCurrentFrame * 2 + 1);
+  }
+
+  // Pipeline Barrier
+  CreatePipelineBarrierOut(commandBuffer, imageIndex);
+
+  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to record command buffer");
+  }
+}
+
+void VulkanRenderer::RecordDrawPass(VkCommandBuffer commandBuffer, uint32_t imageIndex, const DrawPass &pass, uint32_t passIndex, std::span<const uint32_t> drawList)
+{
   // Настройка Dynamic Rendering
   VkRenderingAttachmentInfo colorAttachment{
       .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
-      .imageView = mSwapchain.GetImageView(imageIndex),
+      .imageView = GetTargetImageView(imageIndex),
       .imageLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL,
-      .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+      .loadOp = pass.clearColor ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD,
       .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
       .clearValue = {
           {{
@@ -213,8 +814,8 @@ void VulkanRenderer::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t
       .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
       .imageView = mDepthImageView,
       .imageLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
-      .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-      .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      .loadOp = pass.clearDepth ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD,
+      .storeOp = pass.storeDepth ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE,
       .clearValue = {
           .depthStencil = {1.0f, 0},
       },
@@ -227,23 +828,39 @@ void VulkanRenderer::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t
               0,
               0,
           },
-          .extent = mSwapchain.GetExtent(),
+          .extent = GetTargetExtent(),
       },
       .layerCount = 1,
-      .colorAttachmentCount = 1,
+      .colorAttachmentCount = pass.depthOnly ? 0u : 1u,
       .pColorAttachments = &colorAttachment,
       .pDepthAttachment = &depthAttachment,
   };
 
-  // Render start
-  vkCmdBeginRendering(commandBuffer, &renderingInfo);
-  mPipeline.Bind(commandBuffer);
+  uint32_t chunkCount = std::min(mRecordingChunkCapacity, static_cast<uint32_t>(drawList.size()) / MIN_DRAWS_PER_RECORDING_CHUNK);
+  if (chunkCount <= 1)
+  {
+    vkCmdBeginRendering(commandBuffer, &renderingInfo);
+    RecordDraws(commandBuffer, pass, drawList);
+  }
+  else
+  {
+    renderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+    vkCmdBeginRendering(commandBuffer, &renderingInfo);
+    RecordDrawChunks(commandBuffer, pass, passIndex, drawList, chunkCount);
+  }
+
+  vkCmdEndRendering(commandBuffer);
+}
+
+void VulkanRenderer::RecordDraws(VkCommandBuffer commandBuffer, const DrawPass &pass, std::span<const uint32_t> meshIndices)
+{
+  pass.pipeline->Bind(commandBuffer);
 
   VkViewport viewport{
       .x = 0.0f,
       .y = 0.0f,
-      .width = static_cast<float>(mSwapchain.GetExtent().width),
-      .height = static_cast<float>(mSwapchain.GetExtent().height),
+      .width = static_cast<float>(GetTargetExtent().width),
+      .height = static_cast<float>(GetTargetExtent().height),
       .minDepth = 0.0f,
       .maxDepth = 1.0f,
   };
@@ -254,71 +871,134 @@ void VulkanRenderer::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t
           0,
           0,
       },
-      .extent = mSwapchain.GetExtent(),
+      .extent = GetTargetExtent(),
   };
   vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-  // Bind buffer
-  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipeline.GetPipelineLayout(), 0, 1, &mDescriptorSets[mCurrentFrame], 0, nullptr);
+  // Bind buffers and the bindless textures once, draws never rebind descriptors
+  std::array<VkDescriptorSet, 2> descriptorSets{mDescriptorSets[mCurrentFrame], mAssets->GetBindlessSet()};
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pass.pipeline->GetPipelineLayout(), 0, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), 1, &mUniformOffset);
+
+  // Every mesh is a range of the geometry pool, the commands carry firstIndex and vertexOffset
+  std::array<VkBuffer, 1> vertexBuffers = {mVertexBuffer};
+  std::array<VkDeviceSize, 1> offsets = {0};
+  vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers.data(), offsets.data());
+  vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
 
-  for (const auto &obj : renderQueue)
+  // Draw: one indirect call per mesh and command set over its LOD commands, the cull shader raises the count to the coarsest level in use
+  uint32_t meshCount = static_cast<uint32_t>(mMeshDraws.size());
+  for (uint32_t i : meshIndices)
   {
-    if (!obj.mesh)
+    for (uint32_t set = pass.firstCommandSet; set != pass.firstCommandSet + pass.commandSetCount; ++set)
     {
-      continue;
-    };
-
-    std::array<VkBuffer, 1> vertexBuffers = {obj.mesh->vertexBuffer.GetBuffer()};
-    std::array<VkDeviceSize, 1> offsets = {0};
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers.data(), offsets.data());
-    vkCmdBindIndexBuffer(commandBuffer, obj.mesh->indexBuffer.GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
-
-    MeshPushConstants constants{
-        .model = obj.transform,
-    };
-
-    vkCmdPushConstants(
-        commandBuffer,
-        mPipeline.GetPipelineLayout(),
-        VK_SHADER_STAGE_VERTEX_BIT,
-        0,
-        sizeof(MeshPushConstants),
-        &constants);
-
-    vkCmdDrawIndexed(commandBuffer, obj.mesh->indexCount, 1, 0, 0, 0);
+      uint32_t mesh = set * meshCount + i;
+      vkCmdDrawIndexedIndirectCount(commandBuffer,
+                                    mDrawCommandBuffers[mCurrentFrame].GetBuffer(), sizeof(VkDrawIndexedIndirectCommand) * mesh * MAX_MESH_LODS,
+                                    mDrawCountBuffers[mCurrentFrame].GetBuffer(), sizeof(uint32_t) * mesh,
+                                    MAX_MESH_LODS, sizeof(VkDrawIndexedIndirectCommand));
+    }
   }
+}
 
-  // Draw
-  vkCmdDraw(commandBuffer, 3, 1, 0, 0);
-
-  vkCmdEndRendering(commandBuffer);
-
-  // Pipeline Barrier
-  CreatePipelineBarrierOut(commandBuffer, imageIndex);
+void VulkanRenderer::RecordDrawChunks(VkCommandBuffer commandBuffer, const DrawPass &pass, uint32_t passIndex, std::span<const uint32_t> drawList, uint32_t chunkCount)
+{
+  PROFILE_SCOPE("RecordDrawChunks");
+
+  // Secondary buffers do not inherit state, every chunk binds everything again
+  VkFormat colorFormat = GetTargetFormat();
+  VkCommandBufferInheritanceRenderingInfo inheritanceRendering{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+      .colorAttachmentCount = pass.depthOnly ? 0u : 1u,
+      .pColorAttachmentFormats = &colorFormat,
+      .depthAttachmentFormat = mDepthFormat,
+      .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+  };
+  VkCommandBufferInheritanceInfo inheritance{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+      .pNext = &inheritanceRendering,
+  };
+  VkCommandBufferBeginInfo beginInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+      .pInheritanceInfo = &inheritance,
+  };
 
-  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+  uint32_t firstPool = (mCurrentFrame * MAX_DRAW_PASSES + passIndex) * mRecordingChunkCapacity;
+  VkCommandPool *pools = &mRecordingPools[firstPool];
+  VkCommandBuffer *buffers = &mRecordingBuffers[firstPool];
+  uint32_t drawCount = static_cast<uint32_t>(drawList.size());
+
+  // Jobs must not throw, a failure is reported after all chunks are done
+  std::atomic<bool> failed{false};
+  mJobs->ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end)
+                     {
+                       for (uint32_t chunk = begin; chunk != end; ++chunk)
+                       {
+                         uint32_t first = static_cast<uint32_t>(uint64_t(drawCount) * chunk / chunkCount);
+                         uint32_t last = static_cast<uint32_t>(uint64_t(drawCount) * (chunk + 1) / chunkCount);
+
+                         vkResetCommandPool(mContext->GetDevice(), pools[chunk], 0);
+                         if (vkBeginCommandBuffer(buffers[chunk], &beginInfo) != VK_SUCCESS)
+                         {
+                           failed.store(true, std::memory_order_relaxed);
+                           continue;
+                         }
+                         RecordDraws(buffers[chunk], pass, drawList.subspan(first, last - first));
+                         if (vkEndCommandBuffer(buffers[chunk]) != VK_SUCCESS)
+                         {
+                           failed.store(true, std::memory_order_relaxed);
+                         }
+                       } });
+
+  if (failed.load())
   {
-    throw std::runtime_error("Failed to record command buffer");
+    throw std::runtime_error("Failed to record secondary command buffer");
   }
+
+  // Chunks are executed in draw list order, the result matches recording inline
+  vkCmdExecuteCommands(commandBuffer, chunkCount, buffers);
 }
 
-void VulkanRenderer::DrawFrame(const std::vector<RenderObject> &renderQueue, const CameraRenderData &cameraData)
+void VulkanRenderer::DrawFrame(const RenderSnapshot &snapshot)
 {
+  const CameraRenderData &cameraData = snapshot.camera;
+  QueueObjectUpdates(snapshot.objectUpdates);
+
   // Ждем завершения предыдущего кадра
-  vkWaitForFences(mContext->GetDevice(), 1, &mInFlightFences[mCurrentFrame], VK_TRUE, UINT64_MAX);
+  {
+    PROFILE_SCOPE("Fence Wait");
+    auto waitBegin = Profiler::Clock::now();
+    vkWaitForFences(mContext->GetDevice(), 1, &mInFlightFences[mCurrentFrame], VK_TRUE, UINT64_MAX);
+    Profiler::RecordCounter("Fence Wait ms", std::chrono::duration<double, std::milli>(Profiler::Clock::now() - waitBegin).count());
+  }
+
+  // Nothing recorded for this frame is alive past the fence
+  mFrameArenas[mCurrentFrame].Reset();
+  mUploadRing.BeginFrame(mCurrentFrame);
+  UpdateUniformBuffer(mCurrentFrame, cameraData);
+
+  ReadTimestamps(mCurrentFrame);
+  ReadCullStats(mCurrentFrame);
 
   // Индекс картинки из Swapchain
-  uint32_t imageIndex;
-  VkResult acquireNextImageResult = vkAcquireNextImageKHR(mContext->GetDevice(), mSwapchain.GetSwapchain(), UINT64_MAX, mImageAvailableSemaphores[mCurrentFrame], VK_NULL_HANDLE, &imageIndex);
+  uint32_t imageIndex = 0;
 
-  if (acquireNextImageResult == VK_ERROR_OUT_OF_DATE_KHR)
+  if (!mHeadless)
   {
-    RecreateSwapchain();
-    return;
-  }
-  else if (acquireNextImageResult != VK_SUCCESS && acquireNextImageResult != VK_SUBOPTIMAL_KHR)
-  {
-    throw std::runtime_error("Failed to acquire swapchain image");
+    PROFILE_SCOPE("Acquire");
+    auto acquireBegin = Profiler::Clock::now();
+    VkResult acquireNextImageResult = vkAcquireNextImageKHR(mContext->GetDevice(), mSwapchain.GetSwapchain(), UINT64_MAX, mImageAvailableSemaphores[mCurrentFrame], VK_NULL_HANDLE, &imageIndex);
+    Profiler::RecordCounter("Acquire Wait ms", std::chrono::duration<double, std::milli>(Profiler::Clock::now() - acquireBegin).count());
+
+    if (acquireNextImageResult == VK_ERROR_OUT_OF_DATE_KHR)
+    {
+      RecreateSwapchain();
+      return;
+    }
+    else if (acquireNextImageResult != VK_SUCCESS && acquireNextImageResult != VK_SUBOPTIMAL_KHR)
+    {
+      throw std::runtime_error("Failed to acquire swapchain image");
+    }
   }
 
   // Сброс fances
@@ -326,7 +1006,8 @@ void VulkanRenderer::DrawFrame(const std::vector<RenderObject> &renderQueue, con
 
   // Записываем команды
   vkResetCommandBuffer(mCommandBuffers[mCurrentFrame], 0);
-  RecordCommandBuffer(mCommandBuffers[mCurrentFrame], imageIndex, renderQueue);
+  PrepareDraws(snapshot);
+  RecordCommandBuffer(mCommandBuffers[mCurrentFrame], imageIndex, cameraData);
 
   // Инфо Semaphore ожидания
   VkSemaphoreSubmitInfo waitSemaphoreInfo{
@@ -337,6 +1018,19 @@ void VulkanRenderer::DrawFrame(const std::vector<RenderObject> &renderQueue, con
       .deviceIndex = 0,
   };
 
+  // Streamed assets: wait for the upload batches the host already saw complete, so this never stalls.
+  // Geometry moved or uploaded without the host waiting may still be in flight, the GPU waits for that
+  VulkanUploader &uploader = mContext->GetUploader();
+  VkSemaphoreSubmitInfo uploadSemaphoreInfo{
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+      .semaphore = uploader.GetTimelineSemaphore(),
+      .value = std::max(uploader.GetCompletedValue(), mGeometryReadyValue),
+      .stageMask = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
+      .deviceIndex = 0,
+  };
+
+  std::array<VkSemaphoreSubmitInfo, 2> waitSemaphoreInfos{uploadSemaphoreInfo, waitSemaphoreInfo};
+
   // Инфо Semaphore сигнала
   VkSemaphoreSubmitInfo signalSemaphoreInfo{
       .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
@@ -353,36 +1047,55 @@ void VulkanRenderer::DrawFrame(const std::vector<RenderObject> &renderQueue, con
       .deviceMask = 0,
   };
 
-  // Submit Info
+  // Submit Info (headless: no acquire or present to synchronize with)
   VkSubmitInfo2 submitInfo{
       .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
-      .waitSemaphoreInfoCount = 1,
-      .pWaitSemaphoreInfos = &waitSemaphoreInfo,
+      .waitSemaphoreInfoCount = mHeadless ? 1u : 2u,
+      .pWaitSemaphoreInfos = waitSemaphoreInfos.data(),
       .commandBufferInfoCount = 1,
       .pCommandBufferInfos = &commandBufferInfo,
-      .signalSemaphoreInfoCount = 1,
+      .signalSemaphoreInfoCount = mHeadless ? 0u : 1u,
       .pSignalSemaphoreInfos = &signalSemaphoreInfo,
   };
 
-  UpdateUniformBuffer(mCurrentFrame, cameraData);
+  Profiler::RecordCounter("Upload Ring KB", static_cast<double>(mUploadRing.GetUsed()) / 1024.0);
+  mUploadRing.Flush();
+
+  {
+    PROFILE_SCOPE("Submit");
+    std::lock_guard<std::mutex> lock(mContext->GetQueueMutex());
+    if (vkQueueSubmit2(mContext->GetGraphicsQueue(), 1, &submitInfo, mInFlightFences[mCurrentFrame]) != VK_SUCCESS)
+    {
+      throw std::runtime_error("Failed to submit draw command biffer");
+    }
+  }
+
+  mTimestampsPending[mCurrentFrame] = mTimestampPool != VK_NULL_HANDLE;
+  mFrameSubmitTimes[mCurrentFrame] = Profiler::Clock::now();
 
-  if (vkQueueSubmit2(mContext->GetGraphicsQueue(), 1, &submitInfo, mInFlightFences[mCurrentFrame]) != VK_SUCCESS)
+  if (mHeadless)
   {
-    throw std::runtime_error("Failed to submit draw command biffer");
+    mCurrentFrame = (mCurrentFrame + 1) % mFramesInFlight;
+    return;
   }
 
   // Present
-  std::vector<VkSwapchainKHR> swapchains = {mSwapchain.GetSwapchain()};
+  VkSwapchainKHR swapchain = mSwapchain.GetSwapchain();
   VkPresentInfoKHR presentInfo{
       .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
       .waitSemaphoreCount = 1,
       .pWaitSemaphores = &mRenderFinishedSemaphores[imageIndex],
       .swapchainCount = 1,
-      .pSwapchains = swapchains.data(),
+      .pSwapchains = &swapchain,
       .pImageIndices = &imageIndex,
   };
 
-  VkResult queuePresentResult = vkQueuePresentKHR(mContext->GetPresentQueue(), &presentInfo);
+  VkResult queuePresentResult = VK_SUCCESS;
+  {
+    PROFILE_SCOPE("Present");
+    std::lock_guard<std::mutex> lock(mContext->GetQueueMutex());
+    queuePresentResult = vkQueuePresentKHR(mContext->GetPresentQueue(), &presentInfo);
+  }
 
   if (queuePresentResult == VK_ERROR_OUT_OF_DATE_KHR || queuePresentResult == VK_SUBOPTIMAL_KHR || mFramebufferResized)
   {
@@ -394,27 +1107,76 @@ void VulkanRenderer::DrawFrame(const std::vector<RenderObject> &renderQueue, con
     throw std::runtime_error("Failed to present swap chain image");
   }
 
-  mCurrentFrame = (mCurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+  mCurrentFrame = (mCurrentFrame + 1) % mFramesInFlight;
 }
 
 void VulkanRenderer::CreateDescriptorSetLayout()
 {
   VkDescriptorSetLayoutBinding uboLayoutBinding{
       .binding = 0,
-      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
       .descriptorCount = 1,
-      .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+      .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
   };
 
-  VkDescriptorSetLayoutBinding samplerLayoutBinding{
+  VkDescriptorSetLayoutBinding objectLayoutBinding{
       .binding = 1,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = 1,
+      .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
+  };
+
+  VkDescriptorSetLayoutBinding visibleLayoutBinding{
+      .binding = 2,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = 1,
+      .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
+  };
+
+  VkDescriptorSetLayoutBinding drawCommandLayoutBinding{
+      .binding = 3,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = 1,
+      .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+  };
+
+  VkDescriptorSetLayoutBinding drawCountLayoutBinding{
+      .binding = 4,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = 1,
+      .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+  };
+
+  VkDescriptorSetLayoutBinding meshInfoLayoutBinding{
+      .binding = 5,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = 1,
+      .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
+  };
+
+  VkDescriptorSetLayoutBinding depthPyramidLayoutBinding{
+      .binding = 6,
       .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
       .descriptorCount = 1,
-      .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
-      .pImmutableSamplers = nullptr,
+      .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+  };
+
+  VkDescriptorSetLayoutBinding visibilityLayoutBinding{
+      .binding = 7,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = 1,
+      .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
   };
 
-  std::array<VkDescriptorSetLayoutBinding, 2> bindings = {uboLayoutBinding, samplerLayoutBinding};
+  VkDescriptorSetLayoutBinding cullStatsLayoutBinding{
+      .binding = 8,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = 1,
+      .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+  };
+
+  std::array<VkDescriptorSetLayoutBinding, 9> bindings = {uboLayoutBinding, objectLayoutBinding, visibleLayoutBinding, drawCommandLayoutBinding, drawCountLayoutBinding, meshInfoLayoutBinding,
+                                                          depthPyramidLayoutBinding, visibilityLayoutBinding, cullStatsLayoutBinding};
 
   VkDescriptorSetLayoutCreateInfo layoutInfo{
       .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
@@ -428,45 +1190,146 @@ void VulkanRenderer::CreateDescriptorSetLayout()
   }
 }
 
-void VulkanRenderer::CreateUniformBuffers()
+void VulkanRenderer::CreateFrameBuffers()
 {
-  VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-
-  mUniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-  mUniformBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
-
-  for (size_t i = 0; i != MAX_FRAMES_IN_FLIGHT; ++i)
+  GrowObjectBuffer(1024);
+
+  mVisibleBuffers.resize(mFramesInFlight);
+  mVisibleCapacities.resize(mFramesInFlight, 0);
+  mDrawCommandBuffers.resize(mFramesInFlight);
+  mDrawCommandBuffersMapped.resize(mFramesInFlight, nullptr);
+  mDrawCountBuffers.resize(mFramesInFlight);
+  mDrawCountBuffersMapped.resize(mFramesInFlight, nullptr);
+  mMeshInfoBuffers.resize(mFramesInFlight);
+  mMeshInfoBuffersMapped.resize(mFramesInFlight, nullptr);
+  mDrawCapacities.resize(mFramesInFlight, 0);
+  mCullStatsBuffers.resize(mFramesInFlight);
+  mCullStatsBuffersMapped.resize(mFramesInFlight, nullptr);
+
+  for (uint32_t i = 0; i != mFramesInFlight; ++i)
   {
-    // HOST_VISIBLE | HOST_COHERENT
-    // Идеально было бы DEVICE_LOCAL | HOST_VISIBLE (ReBar)
-    mUniformBuffers[i].Create(
+    CreateVisibleBuffer(i, 1024 * MAX_MESH_LODS);
+    CreateDrawBuffers(i, 64);
+
+    // Read back by the CPU, so cached instead of write-combined
+    mCullStatsBuffers[i].Create(
         mContext->GetAllocator(),
-        bufferSize,
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        sizeof(CullStats),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
         VMA_MEMORY_USAGE_AUTO,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+    mCullStatsBuffersMapped[i] = mCullStatsBuffers[i].Map(mContext->GetAllocator());
+    *static_cast<CullStats *>(mCullStatsBuffersMapped[i]) = {};
+    mCullStatsBuffers[i].Flush(mContext->GetAllocator(), 0, sizeof(CullStats));
+  }
+}
 
-    mUniformBuffersMapped[i] = mUniformBuffers[i].Map(mContext->GetAllocator());
+void VulkanRenderer::CreateMappedBuffer(VulkanBuffer &buffer, void *&mapped, VkDeviceSize size, VkBufferUsageFlags usage)
+{
+  if (mapped)
+  {
+    buffer.Unmap(mContext->GetAllocator());
+    buffer.Destroy(mContext->GetAllocator());
   }
+
+  buffer.Create(
+      mContext->GetAllocator(),
+      size,
+      usage,
+      VMA_MEMORY_USAGE_AUTO,
+      VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+
+  mapped = buffer.Map(mContext->GetAllocator());
+}
+
+void VulkanRenderer::CreateVisibleBuffer(uint32_t frame, uint32_t capacity)
+{
+  // Only the GPU touches visible indices
+  mVisibleBuffers[frame].Destroy(mContext->GetAllocator());
+  mVisibleBuffers[frame].Create(mContext->GetAllocator(), sizeof(uint32_t) * capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+
+  mVisibleCapacities[frame] = capacity;
+}
+
+void VulkanRenderer::CreateDrawBuffers(uint32_t frame, uint32_t capacity)
+{
+  VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+  CreateMappedBuffer(mDrawCommandBuffers[frame], mDrawCommandBuffersMapped[frame], sizeof(VkDrawIndexedIndirectCommand) * capacity * MAX_MESH_LODS, usage);
+  CreateMappedBuffer(mDrawCountBuffers[frame], mDrawCountBuffersMapped[frame], sizeof(uint32_t) * capacity, usage);
+  CreateMappedBuffer(mMeshInfoBuffers[frame], mMeshInfoBuffersMapped[frame], sizeof(MeshInfo) * capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+  mDrawCapacities[frame] = capacity;
+}
+
+void VulkanRenderer::WriteFrameDescriptors(uint32_t frame)
+{
+  std::array<VkDescriptorBufferInfo, 7> bufferInfos{{
+      {mObjectBuffer.GetBuffer(), 0, VK_WHOLE_SIZE},
+      {mVisibleBuffers[frame].GetBuffer(), 0, VK_WHOLE_SIZE},
+      {mDrawCommandBuffers[frame].GetBuffer(), 0, VK_WHOLE_SIZE},
+      {mDrawCountBuffers[frame].GetBuffer(), 0, VK_WHOLE_SIZE},
+      {mMeshInfoBuffers[frame].GetBuffer(), 0, VK_WHOLE_SIZE},
+      {mVisibilityBuffer.GetBuffer(), 0, VK_WHOLE_SIZE},
+      {mCullStatsBuffers[frame].GetBuffer(), 0, VK_WHOLE_SIZE},
+  }};
+  std::array<uint32_t, 7> bufferBindings{1, 2, 3, 4, 5, 7, 8};
+
+  VkDescriptorImageInfo depthPyramidInfo{
+      .sampler = mDepthPyramid.GetSampler(),
+      .imageView = mDepthPyramid.GetView(),
+      .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+  };
+
+  // Storage buffers, written separately because their stage flags differ, and the depth pyramid
+  std::array<VkWriteDescriptorSet, 8> descriptorWrites;
+  for (uint32_t i = 0; i != bufferInfos.size(); ++i)
+  {
+    descriptorWrites[i] = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = mDescriptorSets[frame],
+        .dstBinding = bufferBindings[i],
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .pBufferInfo = &bufferInfos[i],
+    };
+  }
+  descriptorWrites[bufferInfos.size()] = {
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = mDescriptorSets[frame],
+      .dstBinding = 6,
+      .dstArrayElement = 0,
+      .descriptorCount = 1,
+      .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      .pImageInfo = &depthPyramidInfo,
+  };
+
+  vkUpdateDescriptorSets(mContext->GetDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 }
 
 void VulkanRenderer::CreateDescriptorPool()
 {
   VkDescriptorPoolSize matrixPoolSize{
-      .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-      .descriptorCount = MAX_FRAMES_IN_FLIGHT,
+      .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+      .descriptorCount = mFramesInFlight,
   };
 
-  VkDescriptorPoolSize texPoolSize{
+  VkDescriptorPoolSize storagePoolSize{
+      .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = mFramesInFlight * 7,
+  };
+
+  VkDescriptorPoolSize samplerPoolSize{
       .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-      .descriptorCount = MAX_FRAMES_IN_FLIGHT,
+      .descriptorCount = mFramesInFlight,
   };
 
-  std::array<VkDescriptorPoolSize, 2> poolSizes{matrixPoolSize, texPoolSize};
+  std::array<VkDescriptorPoolSize, 3> poolSizes{matrixPoolSize, storagePoolSize, samplerPoolSize};
 
   VkDescriptorPoolCreateInfo poolInfo{
       .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-      .maxSets = MAX_FRAMES_IN_FLIGHT,
+      .maxSets = mFramesInFlight,
       .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
       .pPoolSizes = poolSizes.data(),
   };
@@ -479,57 +1342,48 @@ void VulkanRenderer::CreateDescriptorPool()
 
 void VulkanRenderer::CreateDescriptorSets()
 {
-  std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, mDescriptorSetLayout);
+  std::vector<VkDescriptorSetLayout> layouts(mFramesInFlight, mDescriptorSetLayout);
 
   VkDescriptorSetAllocateInfo allocInfo{
       .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
       .descriptorPool = mDescriptorPool,
-      .descriptorSetCount = MAX_FRAMES_IN_FLIGHT,
+      .descriptorSetCount = mFramesInFlight,
       .pSetLayouts = layouts.data(),
   };
 
-  mDescriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
+  mDescriptorSets.resize(mFramesInFlight);
   if (vkAllocateDescriptorSets(mContext->GetDevice(), &allocInfo, mDescriptorSets.data()) != VK_SUCCESS)
   {
     throw std::runtime_error("Failed to allocate descriptor sets");
   }
 
-  for (size_t i = 0; i != MAX_FRAMES_IN_FLIGHT; ++i)
+  mUniformRingBuffers.resize(mFramesInFlight, VK_NULL_HANDLE);
+  for (size_t i = 0; i != mFramesInFlight; ++i)
   {
-    VkDescriptorBufferInfo bufferInfo{
-        .buffer = mUniformBuffers[i].GetBuffer(),
-        .offset = 0,
-        .range = sizeof(UniformBufferObject),
-    };
-    VkWriteDescriptorSet bufferDescriptorWrite{
-        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-        .dstSet = mDescriptorSets[i],
-        .dstBinding = 0,
-        .dstArrayElement = 0,
-        .descriptorCount = 1,
-        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-        .pBufferInfo = &bufferInfo,
-    };
-
-    VkDescriptorImageInfo imageInfo{
-        .sampler = mTexture.GetSampler(),
-        .imageView = mTexture.GetImageView(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    VkWriteDescriptorSet imageDescriptorWrite{
-        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-        .dstSet = mDescriptorSets[i],
-        .dstBinding = 1,
-        .dstArrayElement = 0,
-        .descriptorCount = 1,
-        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-        .pImageInfo = &imageInfo,
-    };
+    WriteUniformDescriptor(static_cast<uint32_t>(i), mUploadRing.GetBuffer());
+    WriteFrameDescriptors(static_cast<uint32_t>(i));
+  }
+}
 
-    std::array<VkWriteDescriptorSet, 2> descriptorWrites{bufferDescriptorWrite, imageDescriptorWrite};
+void VulkanRenderer::WriteUniformDescriptor(uint32_t frame, VkBuffer buffer)
+{
+  VkDescriptorBufferInfo bufferInfo{
+      .buffer = buffer,
+      .offset = 0,
+      .range = sizeof(UniformBufferObject),
+  };
+  VkWriteDescriptorSet bufferDescriptorWrite{
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = mDescriptorSets[frame],
+      .dstBinding = 0,
+      .dstArrayElement = 0,
+      .descriptorCount = 1,
+      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+      .pBufferInfo = &bufferInfo,
+  };
 
-    vkUpdateDescriptorSets(mContext->GetDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
-  }
+  vkUpdateDescriptorSets(mContext->GetDevice(), 1, &bufferDescriptorWrite, 0, nullptr);
+  mUniformRingBuffers[frame] = buffer;
 }
 
 void VulkanRenderer::UpdateUniformBuffer(uint32_t currentImage, const CameraRenderData &cameraData)
@@ -540,7 +1394,13 @@ void VulkanRenderer::UpdateUniformBuffer(uint32_t currentImage, const CameraRend
   };
   ubo.proj[1][1] *= -1;
 
-  memcpy(mUniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
+  // First allocation of the frame, the descriptor follows the ring when it was replaced by a larger one
+  UploadAllocation allocation = mUploadRing.Push(ubo);
+  if (allocation.buffer != mUniformRingBuffers[currentImage])
+  {
+    WriteUniformDescriptor(currentImage, allocation.buffer);
+  }
+  mUniformOffset = static_cast<uint32_t>(allocation.offset);
 }
 
 void VulkanRenderer::CreateDepthResources()
@@ -550,15 +1410,15 @@ void VulkanRenderer::CreateDepthResources()
       .imageType = VK_IMAGE_TYPE_2D,
       .format = mDepthFormat,
       .extent = {
-          .width = mSwapchain.GetExtent().width,
-          .height = mSwapchain.GetExtent().height,
+          .width = GetTargetExtent().width,
+          .height = GetTargetExtent().height,
           .depth = 1,
       },
       .mipLevels = 1,
       .arrayLayers = 1,
       .samples = VK_SAMPLE_COUNT_1_BIT,
       .tiling = VK_IMAGE_TILING_OPTIMAL,
-      .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+      .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
       .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
       .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
   };
@@ -624,20 +1484,16 @@ void VulkanRenderer::CreateDepthResources()
 
 void VulkanRenderer::RecreateSwapchain()
 {
-  int width = 0;
-  int height = 0;
-
-  glfwGetFramebufferSize(mContext->GetWindow()->GetGLFWwindow(), &width, &height);
-
-  while (width == 0 || height == 0)
+  // May run on the render thread, so no GLFW calls here: the main thread keeps the window size current.
+  // A minimized window has no valid swapchain extent, try again on a later frame
+  Window *window = mContext->GetWindow();
+  if (window->GetFramebufferWidth() == 0 || window->GetFramebufferHeight() == 0)
   {
-    glfwGetFramebufferSize(mContext->GetWindow()->GetGLFWwindow(), &width, &height);
-    glfwWaitEvents();
+    mFramebufferResized = true;
+    return;
   }
 
-  mContext->GetWindow()->UpdateDimensions();
-
-  vkDeviceWaitIdle(mContext->GetDevice());
+  mContext->WaitIdle();
 
   mSwapchain.Recreate(mContext);
 
@@ -645,6 +1501,12 @@ void VulkanRenderer::RecreateSwapchain()
   vmaDestroyImage(mContext->GetAllocator(), mDepthImage, mDepthAllocation);
 
   CreateDepthResources();
+
+  mDepthPyramid.Resize(GetTargetExtent(), mDepthImageView);
+  for (uint32_t i = 0; i != mFramesInFlight; ++i)
+  {
+    WriteFrameDescriptors(i);
+  }
 }
 
 void VulkanRenderer::SetFramebufferSizeCallback()
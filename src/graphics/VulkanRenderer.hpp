@@ -4,6 +4,8 @@
 #include <glm/glm.hpp>
 #include <entt/entt.hpp>
 #include <vector>
+#include <atomic>
+#include <mutex>
 #include <array>
 #include <stdexcept>
 #include <iostream>
@@ -15,19 +17,49 @@
 #include <fstream>
 #include <chrono>
 #include <unordered_map>
+#include <cfloat>
+#include <memory>
+#include <memory_resource>
 #include "VulkanBuffer.hpp"
 #include "VulkanContext.hpp"
 #include "VulkanTexture.hpp"
 #include "VulkanSwapchain.hpp"
+#include "VulkanOffscreenTarget.hpp"
 #include "VulkanPipeline.hpp"
+#include "PipelineLibrary.hpp"
+#include "UploadRing.hpp"
+#include "DepthPyramid.hpp"
 #include "VulkanMesh.hpp"
+#include "AssetManager.hpp"
 #include "Vertex.hpp"
 #include "RenderTypes.hpp"
+#include "../core/Profiler.hpp"
+#include "../core/JobSystem.hpp"
+#include "../core/FrameArena.hpp"
+#include "../geometry/Frustum.hpp"
 #include "../ecs/CameraComponent.hpp"
 #include "../ecs/TransformComponent.hpp"
 #include "../ecs/MeshComponent.hpp"
 
-const uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+// Upper bound of RendererSettings::framesInFlight
+const uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
+struct RendererSettings
+{
+  // Frames recorded ahead of the GPU: 2 overlaps CPU and GPU, 3 absorbs spikes for one more frame of latency
+  uint32_t framesInFlight = 2;
+  // FIFO, FIFO_RELAXED, MAILBOX or IMMEDIATE, FIFO when the surface does not support it
+  VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+  // Depth-only pass before shading, the color pass then shades each pixel once
+  bool depthPrepass = false;
+  // Two-phase Hi-Z culling: objects visible last frame are drawn first, a depth pyramid of that result
+  // culls the rest. Needs samplerFilterMinmax, ignored with a warning without it
+  bool occlusionCulling = false;
+};
+
+// Draw lists shorter than this are recorded inline, longer ones are split into secondary
+// command buffers recorded on the job system, at most one chunk per thread
+const uint32_t MIN_DRAWS_PER_RECORDING_CHUNK = 256;
 
 struct UniformBufferObject
 {
@@ -35,46 +67,199 @@ struct UniformBufferObject
   glm::mat4 proj;
 };
 
+// Coarsest LOD whose error projects to at most this many pixels is drawn
+const float LOD_PIXEL_ERROR = 1.0f;
+
+// Push constants of cull.comp, planes point inwards and are normalized
+struct CullConstants
+{
+  glm::vec4 frustumPlanes[6];
+  // xyz camera position, w pixels covered by one unit of error at distance 1
+  glm::vec4 cameraPosition;
+  uint32_t objectCount;
+  uint32_t meshCount;
+  // CULL_SINGLE, CULL_EARLY or CULL_LATE
+  uint32_t pass;
+};
+
+// CullConstants::pass: one pass without occlusion culling, or the two phases of it
+const uint32_t CULL_SINGLE = 0;
+const uint32_t CULL_EARLY = 1;
+const uint32_t CULL_LATE = 2;
+
+// Written by the late cull pass of a frame (std430)
+struct CullStats
+{
+  // In the frustum but behind the depth pyramid
+  uint32_t occlusionCulled;
+  // Not visible last frame, found visible by the late pass
+  uint32_t lateDrawn;
+};
+
+// One rendering scope over the indirect commands of the cull passes. Command set 0 is filled by the
+// single or early cull pass, set 1 by the late one
+struct DrawPass
+{
+  VulkanPipeline *pipeline;
+  uint32_t firstCommandSet;
+  uint32_t commandSetCount;
+  bool depthOnly;
+  bool clearColor;
+  bool clearDepth;
+  // Depth is read after the pass, by the pyramid or a later pass
+  bool storeDepth;
+};
+
+// Most draw passes of one frame: depth early, depth late and color with both pre-pass and occlusion culling
+const uint32_t MAX_DRAW_PASSES = 3;
+
+// Per mesh entry of the mesh info buffer (std430)
+struct MeshInfo
+{
+  // Object space error of each LOD, FLT_MAX past the last one
+  glm::vec4 lodErrors;
+  // Dequantizes PackedVertex positions: boundsMin and the AABB extent
+  glm::vec4 positionOffset;
+  glm::vec4 positionScale;
+};
+
+// LOD errors of one mesh are packed in a vec4
+static_assert(MAX_MESH_LODS == 4);
+
 class VulkanRenderer
 {
 public:
-  bool mFramebufferResized = false;
+  // Set from the GLFW callback on the main thread, read by whichever thread draws
+  std::atomic<bool> mFramebufferResized{false};
 
-  void Init(VulkanContext *context);
+  // Materials are sampled from the asset manager's bindless set, it must be initialized first
+  void Init(VulkanContext *context, AssetManager *assets, JobSystem *jobs, const RendererSettings &settings = {});
   void Cleanup();
-  void DrawFrame(const std::vector<RenderObject> &renderQueue, const CameraRenderData &cameraData);
+  // GPU-driven: culling runs in a compute pass and draws are indirect, the CPU records one draw per mesh.
+  // Object updates of the snapshot are kept even when the frame is skipped
+  void DrawFrame(const RenderSnapshot &snapshot);
   void WaitIdle();
+  // Latency limiter: blocks until at most maxQueuedFrames submitted frames are unfinished on the GPU.
+  // Called on the drawing thread right before input is sampled, so the frame starts as late as possible
+  void WaitForQueuedFrames(uint32_t maxQueuedFrames);
+  uint32_t GetFramesInFlight() const { return mFramesInFlight; }
+  // Occlusion culling results of the latest finished frame, zero while it is disabled
+  const CullStats &GetCullStats() const { return mCullStats; }
+  // Headless only: writes the last rendered frame to a PPM file
+  void SaveFrame(const std::string &filepath);
 
 private:
   VulkanContext *mContext = nullptr;
+  AssetManager *mAssets = nullptr;
   VulkanSwapchain mSwapchain;
-  VulkanPipeline mPipeline;
+  VulkanOffscreenTarget mOffscreenTarget;
+  bool mHeadless = false;
+  JobSystem *mJobs = nullptr;
+  PipelineLibrary mPipelines;
+  VulkanPipeline *mPipeline = nullptr;
+  VulkanPipeline *mDepthPipeline = nullptr;
+  VulkanPipeline *mCullPipeline = nullptr;
+  bool mDepthPrepass = false;
+  bool mOcclusionCulling = false;
+  DepthPyramid mDepthPyramid;
   std::vector<VkCommandBuffer> mCommandBuffers;
+  // [(frame * MAX_DRAW_PASSES + pass) * mRecordingChunkCapacity + chunk], one secondary command buffer per pool
+  std::vector<VkCommandPool> mRecordingPools;
+  std::vector<VkCommandBuffer> mRecordingBuffers;
+  uint32_t mRecordingChunkCapacity = 1;
+  // Scratch of the recorded frame (draw list, object copies), reset once its fence is signaled
+  std::unique_ptr<FrameArena[]> mFrameArenas;
   std::vector<VkSemaphore> mImageAvailableSemaphores;
   std::vector<VkSemaphore> mRenderFinishedSemaphores;
   std::vector<VkFence> mInFlightFences;
+  uint32_t mFramesInFlight = 2;
   uint32_t mCurrentFrame = 0;
   VkDescriptorSetLayout mDescriptorSetLayout;
   VkDescriptorPool mDescriptorPool;
   std::vector<VkDescriptorSet> mDescriptorSets;
-  std::vector<VulkanBuffer> mUniformBuffers;
-  std::vector<void *> mUniformBuffersMapped;
-  VulkanTexture mTexture;
+  // Streamed per-frame data: the camera uniforms and object update staging
+  UploadRing mUploadRing;
+  // Ring buffer each frame's uniform descriptor points at, bound with mUniformOffset as its dynamic offset
+  std::vector<VkBuffer> mUniformRingBuffers;
+  uint32_t mUniformOffset = 0;
+  // Persistent and device local, shared by all frames in flight. Changed slots are scattered into it
+  // from per-frame staging at the start of each command buffer
+  VulkanBuffer mObjectBuffer;
+  uint32_t mObjectCapacity = 0;
+  uint32_t mObjectCount = 0;
+  std::vector<ObjectUpdate> mPendingUpdates;
+  // Index + 1 into mPendingUpdates per slot, a slot changed twice before a recorded frame is copied once
+  std::vector<uint32_t> mPendingSlots;
+  // Per object slot, written by the late cull pass and read by the next frame's early one.
+  // Device local and shared by all frames in flight, cleared when the object buffer grows
+  VulkanBuffer mVisibilityBuffer;
+  // Per frame in flight, read back after the frame's fence
+  std::vector<VulkanBuffer> mCullStatsBuffers;
+  std::vector<void *> mCullStatsBuffersMapped;
+  CullStats mCullStats{};
+  // Per frame in flight: indirect commands are written by the CPU, visible indices only by the cull shader.
+  // With occlusion culling both hold a second command set for the late pass
+  std::vector<VulkanBuffer> mVisibleBuffers;
+  std::vector<uint32_t> mVisibleCapacities;
+  std::vector<VulkanBuffer> mDrawCommandBuffers;
+  std::vector<void *> mDrawCommandBuffersMapped;
+  std::vector<VulkanBuffer> mDrawCountBuffers;
+  std::vector<void *> mDrawCountBuffersMapped;
+  std::vector<VulkanBuffer> mMeshInfoBuffers;
+  std::vector<void *> mMeshInfoBuffersMapped;
+  // In meshes, every mesh has MAX_MESH_LODS commands
+  std::vector<uint32_t> mDrawCapacities;
+  std::vector<MeshDraw> mMeshDraws;
+  // Geometry pool buffers of the snapshot being drawn
+  VkBuffer mVertexBuffer = VK_NULL_HANDLE;
+  VkBuffer mIndexBuffer = VK_NULL_HANDLE;
+  uint64_t mGeometryReadyValue = 0;
   VkImage mDepthImage;
   VmaAllocation mDepthAllocation;
   VkImageView mDepthImageView;
   VkFormat mDepthFormat = VK_FORMAT_D32_SFLOAT;
 
+  // Two timestamps per frame in flight around the rendering pass, VK_NULL_HANDLE when the queue has no timestamps
+  VkQueryPool mTimestampPool = VK_NULL_HANDLE;
+  float mTimestampPeriod = 0.0f;
+  uint64_t mTimestampMask = 0;
+  std::vector<bool> mTimestampsPending;
+  std::vector<Profiler::Clock::time_point> mFrameSubmitTimes;
+
   void SetFramebufferSizeCallback();
+  VkExtent2D GetTargetExtent() const;
+  VkFormat GetTargetFormat() const;
+  VkImage GetTargetImage(uint32_t imageIndex) const;
+  VkImageView GetTargetImageView(uint32_t imageIndex) const;
+  uint32_t GetTargetImageCount() const;
   void CreatePipelineBarrierEntry(VkCommandBuffer commandBuffer, uint32_t imageIndex);
   void CreatePipelineBarrierOut(VkCommandBuffer commandBuffer, uint32_t imageIndex);
   void CreateCommandBuffers();
-  void RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const std::vector<RenderObject> &renderQueue);
+  void RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const CameraRenderData &cameraData);
+  void RecordObjectUpdates(VkCommandBuffer commandBuffer);
+  void RecordCulling(VkCommandBuffer commandBuffer, const CameraRenderData &cameraData, uint32_t pass);
+  // Begins rendering, records the pass inline or in parallel chunks and ends it. passIndex picks the recording pools
+  void RecordDrawPass(VkCommandBuffer commandBuffer, uint32_t imageIndex, const DrawPass &pass, uint32_t passIndex, std::span<const uint32_t> drawList);
+  // Binds all draw state and records the indirect draws of the given meshes, inside a rendering scope
+  void RecordDraws(VkCommandBuffer commandBuffer, const DrawPass &pass, std::span<const uint32_t> meshIndices);
+  // Splits the draw list into chunkCount secondary command buffers recorded in parallel and executes them
+  void RecordDrawChunks(VkCommandBuffer commandBuffer, const DrawPass &pass, uint32_t passIndex, std::span<const uint32_t> drawList, uint32_t chunkCount);
   void CreateSyncObjects();
+  void CreateTimestampQueries();
+  void ReadTimestamps(uint32_t frame);
+  void ReadCullStats(uint32_t frame);
   void CreateDescriptorSetLayout();
-  void CreateUniformBuffers();
+  void CreateFrameBuffers();
+  void GrowObjectBuffer(uint32_t capacity);
+  void CreateVisibleBuffer(uint32_t frame, uint32_t capacity);
+  void CreateDrawBuffers(uint32_t frame, uint32_t capacity);
+  void CreateMappedBuffer(VulkanBuffer &buffer, void *&mapped, VkDeviceSize size, VkBufferUsageFlags usage);
+  void WriteFrameDescriptors(uint32_t frame);
+  void QueueObjectUpdates(const std::vector<ObjectUpdate> &updates);
+  void PrepareDraws(const RenderSnapshot &snapshot);
   void CreateDescriptorPool();
   void CreateDescriptorSets();
+  void WriteUniformDescriptor(uint32_t frame, VkBuffer buffer);
   void UpdateUniformBuffer(uint32_t currentImage, const CameraRenderData &cameraData);
   void CreateDepthResources();
   void RecreateSwapchain();
@@ -1,7 +1,8 @@
 #include "VulkanSwapchain.hpp"
 
-void VulkanSwapchain::Create(VulkanContext *context)
+void VulkanSwapchain::Create(VulkanContext *context, VkPresentModeKHR presentMode)
 {
+  mPreferredPresentMode = presentMode;
   CreateSwapchain(context);
   CreateImageViews(context);
 }
@@ -23,9 +24,9 @@ void VulkanSwapchain::Destroy(const VulkanContext *context)
 
 void VulkanSwapchain::Recreate(VulkanContext *context)
 {
-  vkDeviceWaitIdle(context->GetDevice());
+  context->WaitIdle();
   Destroy(context);
-  Create(context);
+  Create(context, mPreferredPresentMode);
 }
 
 void VulkanSwapchain::CreateSwapchain(VulkanContext *context)
@@ -83,13 +84,14 @@ void VulkanSwapchain::CreateSwapchain(VulkanContext *context)
 
   mImageFormat = surfaceFormat.surfaceFormat.format;
   mExtent = extent;
+  mPresentMode = presentMode;
 
   vkGetSwapchainImagesKHR(context->GetDevice(), mSwapchain, &imageCount, nullptr);
   mImages.resize(imageCount);
   vkGetSwapchainImagesKHR(context->GetDevice(), mSwapchain, &imageCount, mImages.data());
 
   std::cout << "Swapchain created. Images: " << imageCount << ", Resolution: "
-            << extent.width << "x" << extent.height << std::endl;
+            << extent.width << "x" << extent.height << ", Present mode: " << presentMode << std::endl;
 }
 
 void VulkanSwapchain::CreateImageViews(VulkanContext *context)
@@ -182,12 +184,13 @@ VkPresentModeKHR VulkanSwapchain::ChoosePresentMode(const std::vector<VkPresentM
 {
   for (const auto &availablePresentMode : availablePresentModes)
   {
-    if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+    if (availablePresentMode == mPreferredPresentMode)
     {
       return availablePresentMode;
     }
   }
 
+  // The only mode every surface supports
   return VK_PRESENT_MODE_FIFO_KHR;
 }
 
@@ -13,7 +13,8 @@ struct SwapchainSupportDetails
 class VulkanSwapchain
 {
 public:
-  void Create(VulkanContext *context);
+  // presentMode is used when the surface supports it, FIFO otherwise. Recreate keeps the preference
+  void Create(VulkanContext *context, VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR);
   void Destroy(const VulkanContext *context);
   void Recreate(VulkanContext *context);
 
@@ -24,6 +25,7 @@ public:
   VkImageView GetImageView(uint32_t index) const { return mImageViews[index]; }
   const std::vector<VkImage> &GetImages() const { return mImages; }
   VkImage GetImage(uint32_t index) const { return mImages[index]; }
+  VkPresentModeKHR GetPresentMode() const { return mPresentMode; }
 
 private:
   VkSwapchainKHR mSwapchain = VK_NULL_HANDLE;
@@ -31,6 +33,8 @@ private:
   std::vector<VkImageView> mImageViews;
   VkFormat mImageFormat;
   VkExtent2D mExtent;
+  VkPresentModeKHR mPreferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+  VkPresentModeKHR mPresentMode = VK_PRESENT_MODE_FIFO_KHR;
 
   void CreateSwapchain(VulkanContext *context);
   void CreateImageViews(VulkanContext *context);
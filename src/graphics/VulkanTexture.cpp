@@ -1,16 +1,19 @@
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
 #include "VulkanTexture.hpp"
+#include "TextureImporter.hpp"
+#include <algorithm>
 
 void VulkanTexture::Create(VulkanContext *context, const std::string &filepath)
 {
-  stbi_uc *pixels = stbi_load(filepath.c_str(), &mWidth, &mHeight, &mChannels, STBI_rgb_alpha);
-  VkDeviceSize imageSize = mWidth * mHeight * 4; // RGBA
+  Upload(context, TextureImporter::Import(filepath));
+}
 
-  if (!pixels)
-  {
-    throw std::runtime_error("Failed to load texture image by path: " + filepath);
-  }
+void VulkanTexture::Upload(VulkanContext *context, const TextureData &data)
+{
+  mWidth = static_cast<int>(data.width);
+  mHeight = static_cast<int>(data.height);
+  mMipLevels = static_cast<uint32_t>(data.mips.size());
+  mFormat = data.format;
+  VkDeviceSize imageSize = data.pixels.size();
 
   VulkanBuffer stagingBuffer;
   stagingBuffer.Create(
@@ -19,34 +22,53 @@ void VulkanTexture::Create(VulkanContext *context, const std::string &filepath)
       VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
       VMA_MEMORY_USAGE_AUTO,
       VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
-  stagingBuffer.Upload(context->GetAllocator(), pixels, static_cast<size_t>(imageSize));
-
-  stbi_image_free(pixels);
+  stagingBuffer.Upload(context->GetAllocator(), data.pixels.data(), static_cast<size_t>(imageSize));
 
   // Создаем Image на GPU
-  CreateImage(context, mWidth, mHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
+  CreateImage(context, mWidth, mHeight, mFormat, VK_IMAGE_TILING_OPTIMAL,
               VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_AUTO);
 
   // Транзакция: Undefined -> TransferDst
-  TransitionImageLayout(context, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+  TransitionImageLayout(context, mFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
-  // Копируем буфер в картинку
-  CopyBufferToImage(context, stagingBuffer.GetBuffer(), static_cast<uint32_t>(mWidth), static_cast<uint32_t>(mHeight));
+  // Копируем буфер в картинку, каждый mip своим регионом
+  CopyBufferToImage(context, stagingBuffer.GetBuffer(), data.mips);
 
   // Транзакция: TransferDst -> ShaderReadOnly
-  TransitionImageLayout(context, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  TransitionImageLayout(context, mFormat, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
   stagingBuffer.Destroy(context->GetAllocator());
 
+  CreateImageViewAndSampler(context);
+
+  mReady = true;
+}
+
+uint64_t VulkanTexture::UploadAsync(VulkanContext *context, const TextureData &data)
+{
+  mWidth = static_cast<int>(data.width);
+  mHeight = static_cast<int>(data.height);
+  mMipLevels = static_cast<uint32_t>(data.mips.size());
+  mFormat = data.format;
+
+  CreateImage(context, mWidth, mHeight, mFormat, VK_IMAGE_TILING_OPTIMAL,
+              VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_AUTO);
+  CreateImageViewAndSampler(context);
+
+  return context->GetUploader().UploadImage(mImage, data.mips, data.pixels.data(), data.pixels.size());
+}
+
+void VulkanTexture::CreateImageViewAndSampler(VulkanContext *context)
+{
   VkImageViewCreateInfo viewInfo{
       .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
       .image = mImage,
       .viewType = VK_IMAGE_VIEW_TYPE_2D,
-      .format = VK_FORMAT_R8G8B8A8_SRGB,
+      .format = mFormat,
       .subresourceRange = {
           .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
           .baseMipLevel = 0,
-          .levelCount = 1,
+          .levelCount = mMipLevels,
           .baseArrayLayer = 0,
           .layerCount = 1,
       },
@@ -65,10 +87,13 @@ void VulkanTexture::Create(VulkanContext *context, const std::string &filepath)
       .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
       .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
       .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-      .anisotropyEnable = VK_FALSE,
-      .maxAnisotropy = 1.0f,
+      .mipLodBias = 0.0f,
+      .anisotropyEnable = VK_TRUE,
+      .maxAnisotropy = std::min(16.0f, context->GetMaxSamplerAnisotropy()),
       .compareEnable = VK_FALSE,
       .compareOp = VK_COMPARE_OP_ALWAYS,
+      .minLod = 0.0f,
+      .maxLod = static_cast<float>(mMipLevels),
       .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
       .unnormalizedCoordinates = VK_FALSE,
   };
@@ -84,10 +109,20 @@ void VulkanTexture::Destroy(VulkanContext *context)
   vkDestroySampler(context->GetDevice(), mSampler, nullptr);
   vkDestroyImageView(context->GetDevice(), mImageView, nullptr);
   vmaDestroyImage(context->GetAllocator(), mImage, mAllocation);
+  mSampler = VK_NULL_HANDLE;
+  mImageView = VK_NULL_HANDLE;
+  mImage = VK_NULL_HANDLE;
+  mAllocation = VK_NULL_HANDLE;
+  mReady = false;
 }
 
 void VulkanTexture::CreateImage(VulkanContext *context, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VmaMemoryUsage memoryUsage)
 {
+  if (TextureImporter::IsBlockCompressed(format) && !context->SupportsTextureCompressionBC())
+  {
+    throw std::runtime_error("Device does not support BC texture compression");
+  }
+
   VkImageCreateInfo imageInfo{
       .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
       .imageType = VK_IMAGE_TYPE_2D,
@@ -97,7 +132,7 @@ void VulkanTexture::CreateImage(VulkanContext *context, uint32_t width, uint32_t
           .height = height,
           .depth = 1,
       },
-      .mipLevels = 1,
+      .mipLevels = mMipLevels,
       .arrayLayers = 1,
       .samples = VK_SAMPLE_COUNT_1_BIT,
       .tiling = tiling,
@@ -106,6 +141,15 @@ void VulkanTexture::CreateImage(VulkanContext *context, uint32_t width, uint32_t
       .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
   };
 
+  // Streamed textures are written on the transfer queue and sampled on the graphics queue
+  std::span<const uint32_t> queueFamilies = context->GetSharedQueueFamilies();
+  if (queueFamilies.size() > 1)
+  {
+    imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    imageInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+    imageInfo.pQueueFamilyIndices = queueFamilies.data();
+  }
+
   VmaAllocationCreateInfo allocInfo{
       .usage = memoryUsage,
   };
@@ -134,7 +178,7 @@ void VulkanTexture::TransitionImageLayout(VulkanContext *context, VkFormat forma
       .subresourceRange = {
           .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
           .baseMipLevel = 0,
-          .levelCount = 1,
+          .levelCount = mMipLevels,
           .baseArrayLayer = 0,
           .layerCount = 1,
       },
@@ -172,32 +216,38 @@ void VulkanTexture::TransitionImageLayout(VulkanContext *context, VkFormat forma
   context->EndSingleTimeCommands(commandBuffer);
 }
 
-void VulkanTexture::CopyBufferToImage(VulkanContext *context, VkBuffer buffer, uint32_t width, uint32_t height)
+void VulkanTexture::CopyBufferToImage(VulkanContext *context, VkBuffer buffer, std::span<const TextureMip> mips)
 {
   VkCommandBuffer commandBuffer = context->BeginSingleTimeCommands();
 
-  VkBufferImageCopy2 region{
-      .sType = VK_STRUCTURE_TYPE_BUFFER_IMAGE_COPY_2,
-      .bufferOffset = 0,
-      .bufferRowLength = 0,
-      .bufferImageHeight = 0,
-      .imageSubresource = {
-          .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-          .mipLevel = 0,
-          .baseArrayLayer = 0,
-          .layerCount = 1,
-      },
-      .imageOffset = {0, 0, 0},
-      .imageExtent = {width, height, 1},
-  };
+  std::vector<VkBufferImageCopy2> regions;
+  regions.reserve(mips.size());
+
+  for (uint32_t level = 0; level != mips.size(); ++level)
+  {
+    regions.push_back({
+        .sType = VK_STRUCTURE_TYPE_BUFFER_IMAGE_COPY_2,
+        .bufferOffset = mips[level].offset,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = level,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+        .imageOffset = {0, 0, 0},
+        .imageExtent = {mips[level].width, mips[level].height, 1},
+    });
+  }
 
   VkCopyBufferToImageInfo2 copyInfo{
       .sType = VK_STRUCTURE_TYPE_COPY_BUFFER_TO_IMAGE_INFO_2,
       .srcBuffer = buffer,
       .dstImage = mImage,
       .dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-      .regionCount = 1,
-      .pRegions = &region,
+      .regionCount = static_cast<uint32_t>(regions.size()),
+      .pRegions = regions.data(),
   };
 
   vkCmdCopyBufferToImage2(commandBuffer, &copyInfo);
@@ -1,9 +1,12 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <span>
 #include <stdexcept>
 #include <iostream>
 #include "VulkanContext.hpp"
 #include "VulkanBuffer.hpp"
+#include "TextureData.hpp"
 
 class VulkanTexture
 {
@@ -13,17 +16,33 @@ public:
   VkImageView GetImageView() const { return mImageView; }
   VkSampler GetSampler() const { return mSampler; }
 
+  // Blocking upload through the graphics queue
+  void Upload(VulkanContext *context, const TextureData &data);
+  // Records the copy on the transfer queue, returns the uploader timeline value that makes the texture ready
+  uint64_t UploadAsync(VulkanContext *context, const TextureData &data);
+
+  bool IsReady() const { return mReady; }
+  void SetReady(bool ready) { mReady = ready; }
+
+  // Slot in the bindless texture array, assigned by AssetManager
+  uint32_t GetMaterialIndex() const { return mMaterialIndex; }
+  void SetMaterialIndex(uint32_t index) { mMaterialIndex = index; }
+
 private:
-  VkImage mImage;
-  VmaAllocation mAllocation;
-  VkImageView mImageView;
-  VkSampler mSampler;
+  VkImage mImage = VK_NULL_HANDLE;
+  VmaAllocation mAllocation = VK_NULL_HANDLE;
+  VkImageView mImageView = VK_NULL_HANDLE;
+  VkSampler mSampler = VK_NULL_HANDLE;
+  bool mReady = false;
+  uint32_t mMaterialIndex = 0;
 
   int mWidth;
   int mHeight;
-  int mChannels;
+  uint32_t mMipLevels = 1;
+  VkFormat mFormat = VK_FORMAT_R8G8B8A8_SRGB;
 
   void CreateImage(VulkanContext *context, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VmaMemoryUsage memoryUsage);
+  void CreateImageViewAndSampler(VulkanContext *context);
   void TransitionImageLayout(VulkanContext *context, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
-  void CopyBufferToImage(VulkanContext *context, VkBuffer buffer, uint32_t width, uint32_t height);
-};
\ No newline at end of file
+  void CopyBufferToImage(VulkanContext *context, VkBuffer buffer, std::span<const TextureMip> mips);
+};
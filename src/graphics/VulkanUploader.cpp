@@ -0,0 +1,407 @@
+#include "VulkanUploader.hpp"
+#include "VulkanContext.hpp"
+
+void VulkanUploader::Init(VulkanContext *context, VkDeviceSize stagingSize)
+{
+  mContext = context;
+  mStagingSize = stagingSize;
+
+  VkCommandPoolCreateInfo poolInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+      .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+      .queueFamilyIndex = mContext->GetTransferFamily(),
+  };
+  if (vkCreateCommandPool(mContext->GetDevice(), &poolInfo, nullptr, &mCommandPool) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to create transfer command pool");
+  }
+
+  VkSemaphoreTypeCreateInfo timelineInfo{
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+      .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+      .initialValue = 0,
+  };
+  VkSemaphoreCreateInfo semaphoreInfo{
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+      .pNext = &timelineInfo,
+  };
+  if (vkCreateSemaphore(mContext->GetDevice(), &semaphoreInfo, nullptr, &mTimelineSemaphore) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to create upload timeline semaphore");
+  }
+
+  mStagingBuffer.Create(
+      mContext->GetAllocator(),
+      mStagingSize,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VMA_MEMORY_USAGE_AUTO,
+      VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+  mStagingMapped = static_cast<uint8_t *>(mStagingBuffer.Map(mContext->GetAllocator()));
+}
+
+void VulkanUploader::Cleanup()
+{
+  if (!mContext)
+  {
+    return;
+  }
+
+  Flush();
+
+  uint64_t lastValue = mNextValue - 1;
+  VkSemaphoreWaitInfo waitInfo{
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+      .semaphoreCount = 1,
+      .pSemaphores = &mTimelineSemaphore,
+      .pValues = &lastValue,
+  };
+  vkWaitSemaphores(mContext->GetDevice(), &waitInfo, UINT64_MAX);
+
+  for (auto &staging : mDedicatedStaging)
+  {
+    staging.buffer.Destroy(mContext->GetAllocator());
+  }
+  mDedicatedStaging.clear();
+  mStagingAllocations.clear();
+  mInFlight.clear();
+  mFreeCommandBuffers.clear();
+
+  mStagingBuffer.Unmap(mContext->GetAllocator());
+  mStagingBuffer.Destroy(mContext->GetAllocator());
+  mStagingMapped = nullptr;
+
+  vkDestroySemaphore(mContext->GetDevice(), mTimelineSemaphore, nullptr);
+  vkDestroyCommandPool(mContext->GetDevice(), mCommandPool, nullptr);
+  mTimelineSemaphore = VK_NULL_HANDLE;
+  mCommandPool = VK_NULL_HANDLE;
+
+  mContext = nullptr;
+}
+
+bool VulkanUploader::AllocateRing(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset)
+{
+  if (size > mStagingSize)
+  {
+    return false;
+  }
+
+  if (mUsed == 0)
+  {
+    mHead = 0;
+    mTail = 0;
+  }
+  else if (mHead == mTail)
+  {
+    return false;
+  }
+
+  VkDeviceSize alignedHead = (mHead + alignment - 1) & ~(alignment - 1);
+  VkDeviceSize start = 0;
+
+  if (mHead >= mTail)
+  {
+    // Free space is [head, end) and [0, tail)
+    if (alignedHead + size <= mStagingSize)
+    {
+      start = alignedHead;
+    }
+    else if (size <= mTail)
+    {
+      start = 0;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  else
+  {
+    // Free space is [head, tail)
+    if (alignedHead + size <= mTail)
+    {
+      start = alignedHead;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  VkDeviceSize end = start + size;
+  VkDeviceSize consumed = start >= mHead ? end - mHead : (mStagingSize - mHead) + end;
+
+  mHead = end;
+  mUsed += consumed;
+  mStagingAllocations.push_back({end, consumed, mNextValue});
+
+  offset = start;
+  return true;
+}
+
+std::pair<VkBuffer, VkDeviceSize> VulkanUploader::Stage(const void *data, VkDeviceSize size)
+{
+  VkDeviceSize offset = 0;
+
+  if (AllocateRing(size, 16, offset))
+  {
+    memcpy(mStagingMapped + offset, data, size);
+    mStagingBuffer.Flush(mContext->GetAllocator(), offset, size);
+    return {mStagingBuffer.GetBuffer(), offset};
+  }
+
+  // Ring is full or too small: one-off staging buffer, released together with the batch
+  DedicatedStaging staging;
+  staging.value = mNextValue;
+  staging.buffer.Create(
+      mContext->GetAllocator(),
+      size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VMA_MEMORY_USAGE_AUTO,
+      VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+  staging.buffer.Upload(mContext->GetAllocator(), data, size);
+  staging.buffer.Flush(mContext->GetAllocator(), 0, size);
+
+  VkBuffer buffer = staging.buffer.GetBuffer();
+  mDedicatedStaging.push_back(std::move(staging));
+
+  return {buffer, 0};
+}
+
+VkCommandBuffer VulkanUploader::GetRecordingCommandBuffer()
+{
+  if (mRecording != VK_NULL_HANDLE)
+  {
+    return mRecording;
+  }
+
+  if (!mFreeCommandBuffers.empty())
+  {
+    mRecording = mFreeCommandBuffers.back();
+    mFreeCommandBuffers.pop_back();
+  }
+  else
+  {
+    VkCommandBufferAllocateInfo allocInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = mCommandPool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+    if (vkAllocateCommandBuffers(mContext->GetDevice(), &allocInfo, &mRecording) != VK_SUCCESS)
+    {
+      throw std::runtime_error("Failed to allocate transfer command buffer");
+    }
+  }
+
+  VkCommandBufferBeginInfo beginInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+  };
+  vkBeginCommandBuffer(mRecording, &beginInfo);
+
+  return mRecording;
+}
+
+uint64_t VulkanUploader::UploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void *data, VkDeviceSize size)
+{
+  auto [srcBuffer, srcOffset] = Stage(data, size);
+  VkCommandBuffer commandBuffer = GetRecordingCommandBuffer();
+
+  VkBufferCopy copyRegion{
+      .srcOffset = srcOffset,
+      .dstOffset = dstOffset,
+      .size = size,
+  };
+  vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+
+  return mNextValue;
+}
+
+uint64_t VulkanUploader::UploadImage(VkImage dstImage, std::span<const TextureMip> mips, const void *data, VkDeviceSize size)
+{
+  auto [srcBuffer, srcOffset] = Stage(data, size);
+  VkCommandBuffer commandBuffer = GetRecordingCommandBuffer();
+
+  VkImageSubresourceRange subresourceRange{
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .baseMipLevel = 0,
+      .levelCount = static_cast<uint32_t>(mips.size()),
+      .baseArrayLayer = 0,
+      .layerCount = 1,
+  };
+
+  // Undefined -> TransferDst
+  VkImageMemoryBarrier2 toTransferBarrier{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+      .srcStageMask = VK_PIPELINE_STAGE_2_NONE,
+      .srcAccessMask = VK_ACCESS_2_NONE,
+      .dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+      .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+      .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+      .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = dstImage,
+      .subresourceRange = subresourceRange,
+  };
+  VkDependencyInfo toTransferDependency{
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .imageMemoryBarrierCount = 1,
+      .pImageMemoryBarriers = &toTransferBarrier,
+  };
+  vkCmdPipelineBarrier2(commandBuffer, &toTransferDependency);
+
+  std::vector<VkBufferImageCopy2> regions;
+  regions.reserve(mips.size());
+
+  for (uint32_t level = 0; level != mips.size(); ++level)
+  {
+    regions.push_back({
+        .sType = VK_STRUCTURE_TYPE_BUFFER_IMAGE_COPY_2,
+        .bufferOffset = srcOffset + mips[level].offset,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = level,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+        .imageOffset = {0, 0, 0},
+        .imageExtent = {mips[level].width, mips[level].height, 1},
+    });
+  }
+
+  VkCopyBufferToImageInfo2 copyInfo{
+      .sType = VK_STRUCTURE_TYPE_COPY_BUFFER_TO_IMAGE_INFO_2,
+      .srcBuffer = srcBuffer,
+      .dstImage = dstImage,
+      .dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      .regionCount = static_cast<uint32_t>(regions.size()),
+      .pRegions = regions.data(),
+  };
+  vkCmdCopyBufferToImage2(commandBuffer, &copyInfo);
+
+  // TransferDst -> ShaderReadOnly, the graphics queue waits on the timeline semaphore before sampling
+  VkImageMemoryBarrier2 toShaderBarrier{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+      .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+      .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+      .dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+      .dstAccessMask = VK_ACCESS_2_NONE,
+      .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = dstImage,
+      .subresourceRange = subresourceRange,
+  };
+  VkDependencyInfo toShaderDependency{
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .imageMemoryBarrierCount = 1,
+      .pImageMemoryBarriers = &toShaderBarrier,
+  };
+  vkCmdPipelineBarrier2(commandBuffer, &toShaderDependency);
+
+  return mNextValue;
+}
+
+uint64_t VulkanUploader::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, std::span<const VkBufferCopy> regions)
+{
+  VkCommandBuffer commandBuffer = GetRecordingCommandBuffer();
+
+  // The source may still be written by an earlier upload on this queue
+  VkMemoryBarrier2 barrier{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+      .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+      .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+      .dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+      .dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT,
+  };
+  VkDependencyInfo dependency{
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .memoryBarrierCount = 1,
+      .pMemoryBarriers = &barrier,
+  };
+  vkCmdPipelineBarrier2(commandBuffer, &dependency);
+
+  if (!regions.empty())
+  {
+    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, static_cast<uint32_t>(regions.size()), regions.data());
+  }
+
+  return mNextValue;
+}
+
+void VulkanUploader::Flush()
+{
+  if (mRecording == VK_NULL_HANDLE)
+  {
+    return;
+  }
+
+  if (vkEndCommandBuffer(mRecording) != VK_SUCCESS)
+  {
+    throw std::runtime_error("Failed to record transfer command buffer");
+  }
+
+  VkCommandBufferSubmitInfo commandBufferInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+      .commandBuffer = mRecording,
+      .deviceMask = 0,
+  };
+
+  VkSemaphoreSubmitInfo signalSemaphoreInfo{
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+      .semaphore = mTimelineSemaphore,
+      .value = mNextValue,
+      .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+      .deviceIndex = 0,
+  };
+
+  VkSubmitInfo2 submitInfo{
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+      .commandBufferInfoCount = 1,
+      .pCommandBufferInfos = &commandBufferInfo,
+      .signalSemaphoreInfoCount = 1,
+      .pSignalSemaphoreInfos = &signalSemaphoreInfo,
+  };
+
+  {
+    std::lock_guard<std::mutex> lock(mContext->GetQueueMutex());
+    if (vkQueueSubmit2(mContext->GetTransferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+      throw std::runtime_error("Failed to submit transfer command buffer");
+    }
+  }
+
+  mInFlight.push_back({mRecording, mNextValue});
+  mRecording = VK_NULL_HANDLE;
+  ++mNextValue;
+}
+
+void VulkanUploader::Update()
+{
+  uint64_t completedValue = 0;
+  vkGetSemaphoreCounterValue(mContext->GetDevice(), mTimelineSemaphore, &completedValue);
+  mCompletedValue.store(completedValue, std::memory_order_release);
+
+  while (!mInFlight.empty() && mInFlight.front().value <= completedValue)
+  {
+    mFreeCommandBuffers.push_back(mInFlight.front().commandBuffer);
+    mInFlight.pop_front();
+  }
+
+  while (!mStagingAllocations.empty() && mStagingAllocations.front().value <= completedValue)
+  {
+    mTail = mStagingAllocations.front().end;
+    mUsed -= mStagingAllocations.front().consumed;
+    mStagingAllocations.pop_front();
+  }
+
+  while (!mDedicatedStaging.empty() && mDedicatedStaging.front().value <= completedValue)
+  {
+    mDedicatedStaging.front().buffer.Destroy(mContext->GetAllocator());
+    mDedicatedStaging.pop_front();
+  }
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+#include <vector>
+#include <deque>
+#include <span>
+#include <atomic>
+#include <cstdint>
+#include "VulkanBuffer.hpp"
+#include "TextureData.hpp"
+
+class VulkanContext;
+
+// Streams buffer and image data to the GPU on the transfer queue without blocking the frame loop.
+// Copies are staged in one persistently mapped ring buffer and recorded into a batch that Flush submits.
+// Every batch signals the next value of a timeline semaphore, ring space is reclaimed once the GPU reaches it.
+class VulkanUploader
+{
+public:
+  void Init(VulkanContext *context, VkDeviceSize stagingSize = 64ull * 1024 * 1024);
+  void Cleanup();
+
+  // Both return the timeline value that signals completion of the copy
+  uint64_t UploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void *data, VkDeviceSize size);
+  // Copies every mip level in one batch and leaves the image in SHADER_READ_ONLY_OPTIMAL
+  uint64_t UploadImage(VkImage dstImage, std::span<const TextureMip> mips, const void *data, VkDeviceSize size);
+  // Device to device copies, ordered after every transfer submitted or recorded before
+  uint64_t CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, std::span<const VkBufferCopy> regions);
+
+  // Submits everything recorded since the last flush, once per frame is enough
+  void Flush();
+  // Polls the timeline semaphore and releases staging memory of finished batches
+  void Update();
+
+  bool IsComplete(uint64_t value) const { return value <= GetCompletedValue(); }
+  // Safe to read from the render thread
+  uint64_t GetCompletedValue() const { return mCompletedValue.load(std::memory_order_acquire); }
+  VkSemaphore GetTimelineSemaphore() const { return mTimelineSemaphore; }
+
+private:
+  struct StagingAllocation
+  {
+    VkDeviceSize end;
+    VkDeviceSize consumed;
+    uint64_t value;
+  };
+
+  struct Batch
+  {
+    VkCommandBuffer commandBuffer;
+    uint64_t value;
+  };
+
+  struct DedicatedStaging
+  {
+    VulkanBuffer buffer;
+    uint64_t value;
+  };
+
+  VulkanContext *mContext = nullptr;
+  VkCommandPool mCommandPool = VK_NULL_HANDLE;
+  VkSemaphore mTimelineSemaphore = VK_NULL_HANDLE;
+
+  VulkanBuffer mStagingBuffer;
+  uint8_t *mStagingMapped = nullptr;
+  VkDeviceSize mStagingSize = 0;
+  VkDeviceSize mHead = 0;
+  VkDeviceSize mTail = 0;
+  VkDeviceSize mUsed = 0;
+  std::deque<StagingAllocation> mStagingAllocations;
+  std::deque<DedicatedStaging> mDedicatedStaging;
+
+  VkCommandBuffer mRecording = VK_NULL_HANDLE;
+  std::deque<Batch> mInFlight;
+  std::vector<VkCommandBuffer> mFreeCommandBuffers;
+
+  uint64_t mNextValue = 1;
+  std::atomic<uint64_t> mCompletedValue{0};
+
+  // Copies data into staging memory, returns the buffer and offset to copy from
+  std::pair<VkBuffer, VkDeviceSize> Stage(const void *data, VkDeviceSize size);
+  bool AllocateRing(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+  VkCommandBuffer GetRecordingCommandBuffer();
+};
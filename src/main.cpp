@@ -1,12 +1,88 @@
 #include "core/Engine.hpp"
+#include <cstring>
+#include <string>
 
-int main(int, char **)
+int main(int argc, char **argv)
 {
+  EngineSettings settings;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--headless") == 0)
+    {
+      settings.headless = true;
+    }
+    else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+    {
+      settings.frameLimit = static_cast<uint32_t>(std::stoul(argv[++i]));
+    }
+    else if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
+    {
+      settings.tickRate = std::stof(argv[++i]);
+    }
+    else if (std::strcmp(argv[i], "--profile") == 0)
+    {
+      settings.profile = true;
+    }
+    else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+    {
+      settings.tracePath = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "--render-thread") == 0)
+    {
+      settings.renderThread = true;
+    }
+    else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+    {
+      settings.capturePath = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+    {
+      settings.renderer.framesInFlight = static_cast<uint32_t>(std::stoul(argv[++i]));
+    }
+    else if (std::strcmp(argv[i], "--present-mode") == 0 && i + 1 < argc)
+    {
+      const char *mode = argv[++i];
+      if (std::strcmp(mode, "fifo") == 0)
+      {
+        settings.renderer.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+      }
+      else if (std::strcmp(mode, "fifo-relaxed") == 0)
+      {
+        settings.renderer.presentMode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+      }
+      else if (std::strcmp(mode, "mailbox") == 0)
+      {
+        settings.renderer.presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+      }
+      else if (std::strcmp(mode, "immediate") == 0)
+      {
+        settings.renderer.presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+      }
+    }
+    else if (std::strcmp(argv[i], "--max-queued-frames") == 0 && i + 1 < argc)
+    {
+      settings.maxQueuedFrames = std::stoi(argv[++i]);
+    }
+    else if (std::strcmp(argv[i], "--depth-prepass") == 0)
+    {
+      settings.renderer.depthPrepass = true;
+    }
+    else if (std::strcmp(argv[i], "--occlusion-culling") == 0)
+    {
+      settings.renderer.occlusionCulling = true;
+    }
+    else if (std::strcmp(argv[i], "--require-zero-allocations") == 0)
+    {
+      settings.requireZeroAllocations = true;
+    }
+  }
+
   Engine app;
-  if (app.Init())
+  if (!app.Init(settings))
   {
-    app.Run();
+    return 1;
   }
 
-  return 0;
-}
\ No newline at end of file
+  return app.Run() ? 0 : 1;
+}
@@ -1,48 +1,97 @@
 #include "CollisionSystem.hpp"
 
-void CollisionSystem::Update(entt::registry &registry, float dt)
+void CollisionSystem::ResolvePair(Position &posA, float ax, float ay, float radiusA, float bx, float by, float radiusB, bool isStaticB, float dt)
+{
+  float dx = ax - bx;
+  float dy = ay - by;
+  float distSq = dx * dx + dy * dy;
+
+  float minDist = radiusA + radiusB;
+
+  if (distSq < minDist * minDist && distSq > 0.0001f)
+  {
+    float dist = std::sqrt(distSq);
+    float overlap = minDist - dist;
+
+    float pushX = dx / dist;
+    float pushY = dy / dist;
+
+    float pushFactor = 0.5f;
+
+    if (isStaticB)
+    {
+      pushFactor = 1.0f;
+    }
+
+    float strength = 2.0f;
+
+    posA.x += pushX * overlap * pushFactor * strength * dt;
+    posA.y += pushY * overlap * pushFactor * strength * dt;
+  }
+}
+
+void CollisionSystem::Update(entt::registry &registry, JobSystem &jobs, float dt)
 {
   auto view = registry.view<Position, Collider>();
 
-  view.each([&](auto entityA, auto &posA, const auto &colA)
-            {
-              if (colA.isStatic)
-              {
-                return;
-              }
+  // Broadphase: snapshot positions into the grid, cell size covers the largest possible pair distance
+  mBodies.clear();
+  mGrid.Clear();
 
-              view.each([&](auto entityB, const auto &posB, const auto &colB)
-            {
-              if (entityA == entityB)
-              {
-                return;
-              }
+  float maxRadius = 0.0f;
 
-              float dx = posA.x - posB.x;
-              float dy = posA.y - posB.y;
-              float distSq = dx*dx + dy*dy;
+  for (auto [entity, pos, col] : view.each())
+  {
+    uint32_t index = static_cast<uint32_t>(mBodies.size());
+    mBodies.push_back({&pos, pos.x, pos.y, col.radius, col.isStatic});
+    mGrid.Insert(pos.x, pos.y, index);
+    maxRadius = std::max(maxRadius, col.radius);
+  }
 
-              float minDist = colA.radius + colB.radius;
+  mGrid.Build(maxRadius * 2.0f);
 
-              if (distSq < minDist * minDist && distSq > 0.0001f)
-              {
-                float dist = std::sqrt(distSq);
-                float overlap = minDist - dist;
+  // Narrowphase: every body reads the snapshot and writes only its own Position, so bodies run in parallel
+  jobs.ParallelFor(static_cast<uint32_t>(mBodies.size()), 64, [&](uint32_t begin, uint32_t end)
+                   {
+    for (uint32_t i = begin; i != end; ++i)
+    {
+      const Body &bodyA = mBodies[i];
 
-                float pushX = dx / dist;
-                float pushY = dy / dist;
+      if (bodyA.isStatic)
+      {
+        continue;
+      }
 
-                float pushFactor = 0.5f;
+      mGrid.Query(bodyA.x, bodyA.y, [&](const SpatialHashGrid::Item &item)
+                  {
+                    if (item.index == i)
+                    {
+                      return;
+                    }
 
-                if (colB.isStatic)
-                {
-                  pushFactor = 1.0f;
-                }
+                    const Body &bodyB = mBodies[item.index];
+                    ResolvePair(*bodyA.position, bodyA.x, bodyA.y, bodyA.radius, bodyB.x, bodyB.y, bodyB.radius, bodyB.isStatic, dt); });
+    } });
+}
 
-                float strength = 2.0f;
+void CollisionSystem::UpdateBruteForce(entt::registry &registry, float dt)
+{
+  auto view = registry.view<Position, Collider>();
+
+  // The original loop: pushes are applied in place, so later pairs already see them
+  view.each([&](auto entityA, auto &posA, const auto &colA)
+            {
+    if (colA.isStatic)
+    {
+      return;
+    }
+
+    view.each([&](auto entityB, const auto &posB, const auto &colB)
+              {
+      if (entityA == entityB)
+      {
+        return;
+      }
 
-                posA.x += pushX * overlap * pushFactor * strength * dt;
-                posA.y += pushY * overlap * pushFactor * strength * dt;
-              }
-            }); });
+      ResolvePair(posA, posA.x, posA.y, colA.radius, posB.x, posB.y, colB.radius, colB.isStatic, dt); }); });
 }
\ No newline at end of file
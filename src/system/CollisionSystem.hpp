@@ -1,10 +1,33 @@
 #pragma once
 #include <entt/entt.hpp>
 #include <cmath>
+#include <vector>
 #include "../ecs/Components.hpp"
+#include "../geometry/SpatialHashGrid.hpp"
+#include "../core/JobSystem.hpp"
 
 class CollisionSystem
 {
 public:
-  void Update(entt::registry &registry, float dt);
-};
\ No newline at end of file
+  // Every body is resolved against the positions at the start of the tick (Jacobi), which keeps the result
+  // independent of entity order and lets bodies run in parallel
+  void Update(entt::registry &registry, JobSystem &jobs, float dt);
+  // The original O(n^2) loop, resolving in place (Gauss-Seidel): a body sees the pushes already applied this tick.
+  // tests/CollisionBench checks that the broadphase stays within a tolerance of it
+  void UpdateBruteForce(entt::registry &registry, float dt);
+
+private:
+  struct Body
+  {
+    Position *position;
+    float x;
+    float y;
+    float radius;
+    bool isStatic;
+  };
+
+  std::vector<Body> mBodies;
+  SpatialHashGrid mGrid;
+
+  static void ResolvePair(Position &posA, float ax, float ay, float radiusA, float bx, float by, float radiusB, bool isStaticB, float dt);
+};
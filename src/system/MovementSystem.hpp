@@ -2,16 +2,19 @@
 #include <entt/entt.hpp>
 #include <cmath>
 #include "../ecs/Components.hpp"
+#include "../ecs/EntityCommandBuffer.hpp"
+#include "../core/JobSystem.hpp"
 
 class MovementSystem
 {
 public:
-  void Update(entt::registry &registry, float dt)
+  // Arrivals are recorded into commands, play them back before the next structural read of Destination
+  void Update(entt::registry &registry, JobSystem &jobs, EntityCommandBuffer &commands, float dt)
   {
     auto view = registry.view<Position, Destination>();
 
-    view.each([&](auto entity, auto &pos, auto &dest)
-              { float dx = dest.targetX - pos.x;
+    jobs.ParallelEach(view, 256, [&](entt::entity entity, Position &pos, Destination &dest)
+                      { float dx = dest.targetX - pos.x;
               float dy = dest.targetY - pos.y;
               float distance = std::sqrt(dx * dx + dy * dy);
 
@@ -21,7 +24,7 @@ public:
                 pos.x += (dx / distance) * speed * dt;
                 pos.y += (dy / distance) * speed * dt;
               } else {
-                registry.remove<Destination>(entity);
+                commands.Remove<Destination>(entity);
               } });
   }
-};
\ No newline at end of file
+};
@@ -0,0 +1,259 @@
+#include "geometry/AabbTree.hpp"
+#include "Check.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+// Query throughput of the tree against a linear scan over the same fat boxes. The tree reports
+// exactly the leaves whose fat box passes the test, so both must return the same set for every query
+
+static std::vector<uint32_t> Sorted(std::vector<uint32_t> hits)
+{
+  std::sort(hits.begin(), hits.end());
+  return hits;
+}
+
+static bool RayHitsBox(const Aabb &box, const glm::vec3 &origin, const glm::vec3 &invDirection, float maxDistance)
+{
+  // Same slab test as AabbTree::Raycast
+  glm::vec3 t0 = (box.min - origin) * invDirection;
+  glm::vec3 t1 = (box.max - origin) * invDirection;
+  glm::vec3 tNear = glm::min(t0, t1);
+  glm::vec3 tFar = glm::max(t0, t1);
+  float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+  float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+  return enter <= exit;
+}
+
+static bool FrustumTouchesBox(const Frustum &frustum, const Aabb &box)
+{
+  glm::vec3 center = (box.min + box.max) * 0.5f;
+  glm::vec3 extent = (box.max - box.min) * 0.5f;
+  for (const glm::vec4 &plane : frustum.planes)
+  {
+    if (glm::dot(glm::vec3(plane), center) + plane.w < -glm::dot(glm::abs(glm::vec3(plane)), extent))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t count = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 100000;
+  // Unit sized objects at roughly the density of a large battle
+  float worldSize = std::cbrt(static_cast<float>(count)) * 10.0f;
+
+  std::mt19937 random(16);
+  std::uniform_real_distribution<float> coordinate(0.0f, worldSize);
+  std::uniform_real_distribution<float> extent(0.25f, 1.5f);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+  AabbTree tree;
+  std::vector<int32_t> proxies(count);
+  for (uint32_t i = 0; i != count; ++i)
+  {
+    glm::vec3 center(coordinate(random), coordinate(random), coordinate(random));
+    glm::vec3 half(extent(random), extent(random), extent(random));
+    proxies[i] = tree.CreateProxy({center - half, center + half}, i);
+  }
+
+  // Leaves as queries see them, after insertion grew each box by the margin
+  std::vector<Aabb> fatBoxes(count);
+  for (uint32_t i = 0; i != count; ++i)
+  {
+    fatBoxes[i] = tree.GetFatBox(proxies[i]);
+  }
+
+  auto randomPoint = [&]()
+  { return glm::vec3(coordinate(random), coordinate(random), coordinate(random)); };
+  auto randomDirection = [&]()
+  {
+    glm::vec3 direction(unit(random), unit(random), unit(random));
+    return glm::length(direction) > 0.01f ? glm::normalize(direction) : glm::vec3(1.0f, 0.0f, 0.0f);
+  };
+
+  const uint32_t queryCount = 200;
+  std::vector<Aabb> boxes;
+  std::vector<glm::vec4> spheres;
+  std::vector<Frustum> frustums;
+  std::vector<std::pair<glm::vec3, glm::vec3>> rays;
+  for (uint32_t i = 0; i != queryCount; ++i)
+  {
+    // Selection rectangles and area effects: a few to a few hundred units
+    glm::vec3 center = randomPoint();
+    glm::vec3 half(std::uniform_real_distribution<float>(2.0f, 20.0f)(random));
+    boxes.push_back({center - half, center + half});
+    spheres.push_back(glm::vec4(randomPoint(), std::uniform_real_distribution<float>(2.0f, 20.0f)(random)));
+    rays.push_back({randomPoint(), randomDirection()});
+  }
+  // Cameras inside the world looking in random directions, a far plane a quarter of the world away
+  for (uint32_t i = 0; i != queryCount / 10; ++i)
+  {
+    glm::vec3 eye = randomPoint();
+    glm::mat4 view = glm::lookAt(eye, eye + randomDirection(), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, worldSize * 0.25f);
+    frustums.push_back(Frustum::FromMatrix(projection * view));
+  }
+  const float rayLength = worldSize * 0.5f;
+
+  // Results first: every query of both paths collected and compared
+  uint32_t mismatched = 0;
+  for (const Aabb &box : boxes)
+  {
+    std::vector<uint32_t> treeHits, scanHits;
+    tree.QueryBox(box, [&](uint32_t id)
+                  { treeHits.push_back(id); });
+    for (uint32_t id = 0; id != count; ++id)
+    {
+      if (fatBoxes[id].Overlaps(box))
+      {
+        scanHits.push_back(id);
+      }
+    }
+    mismatched += Sorted(treeHits) != scanHits;
+  }
+  CHECK(mismatched == 0);
+
+  mismatched = 0;
+  for (const glm::vec4 &sphere : spheres)
+  {
+    glm::vec3 center(sphere);
+    std::vector<uint32_t> treeHits, scanHits;
+    tree.QueryRadius(center, sphere.w, [&](uint32_t id)
+                     { treeHits.push_back(id); });
+    for (uint32_t id = 0; id != count; ++id)
+    {
+      glm::vec3 d = glm::clamp(center, fatBoxes[id].min, fatBoxes[id].max) - center;
+      if (glm::dot(d, d) <= sphere.w * sphere.w)
+      {
+        scanHits.push_back(id);
+      }
+    }
+    mismatched += Sorted(treeHits) != scanHits;
+  }
+  CHECK(mismatched == 0);
+
+  mismatched = 0;
+  for (const Frustum &frustum : frustums)
+  {
+    std::vector<uint32_t> treeHits, scanHits;
+    tree.QueryFrustum(frustum, [&](uint32_t id)
+                      { treeHits.push_back(id); });
+    for (uint32_t id = 0; id != count; ++id)
+    {
+      if (FrustumTouchesBox(frustum, fatBoxes[id]))
+      {
+        scanHits.push_back(id);
+      }
+    }
+    mismatched += Sorted(treeHits) != scanHits;
+  }
+  CHECK(mismatched == 0);
+
+  mismatched = 0;
+  for (const auto &[origin, direction] : rays)
+  {
+    glm::vec3 invDirection = 1.0f / direction;
+    std::vector<uint32_t> treeHits, scanHits;
+    tree.Raycast(origin, direction, rayLength, [&](uint32_t id, float)
+                 { treeHits.push_back(id); return rayLength; });
+    for (uint32_t id = 0; id != count; ++id)
+    {
+      if (RayHitsBox(fatBoxes[id], origin, invDirection, rayLength))
+      {
+        scanHits.push_back(id);
+      }
+    }
+    mismatched += Sorted(treeHits) != scanHits;
+  }
+  CHECK(mismatched == 0);
+
+  // Timings: hits are summed so neither loop can be dropped
+  uint64_t hits = 0;
+  auto report = [&](const char *name, size_t queries, double treeMs, double scanMs)
+  {
+    std::printf("%-7s %4zu queries: tree %8.3f ms (%6.2f us/query), brute force %8.3f ms\n",
+                name, queries, treeMs, treeMs * 1000.0 / queries, scanMs);
+  };
+
+  double treeMs = MeasureMs([&]()
+                            {
+    for (const Aabb &box : boxes)
+    {
+      tree.QueryBox(box, [&](uint32_t)
+                    { ++hits; });
+    } });
+  double scanMs = MeasureMs([&]()
+                            {
+    for (const Aabb &box : boxes)
+    {
+      for (const Aabb &fat : fatBoxes)
+      {
+        hits += fat.Overlaps(box);
+      }
+    } }, 1);
+  report("box", boxes.size(), treeMs, scanMs);
+
+  treeMs = MeasureMs([&]()
+                     {
+    for (const glm::vec4 &sphere : spheres)
+    {
+      tree.QueryRadius(glm::vec3(sphere), sphere.w, [&](uint32_t)
+                       { ++hits; });
+    } });
+  scanMs = MeasureMs([&]()
+                     {
+    for (const glm::vec4 &sphere : spheres)
+    {
+      glm::vec3 center(sphere);
+      for (const Aabb &fat : fatBoxes)
+      {
+        glm::vec3 d = glm::clamp(center, fat.min, fat.max) - center;
+        hits += glm::dot(d, d) <= sphere.w * sphere.w;
+      }
+    } }, 1);
+  report("radius", spheres.size(), treeMs, scanMs);
+
+  treeMs = MeasureMs([&]()
+                     {
+    for (const Frustum &frustum : frustums)
+    {
+      tree.QueryFrustum(frustum, [&](uint32_t)
+                        { ++hits; });
+    } });
+  scanMs = MeasureMs([&]()
+                     {
+    for (const Frustum &frustum : frustums)
+    {
+      for (const Aabb &fat : fatBoxes)
+      {
+        hits += FrustumTouchesBox(frustum, fat);
+      }
+    } }, 1);
+  report("frustum", frustums.size(), treeMs, scanMs);
+
+  treeMs = MeasureMs([&]()
+                     {
+    for (const auto &[origin, direction] : rays)
+    {
+      tree.Raycast(origin, direction, rayLength, [&](uint32_t, float)
+                   { ++hits; return rayLength; });
+    } });
+  scanMs = MeasureMs([&]()
+                     {
+    for (const auto &[origin, direction] : rays)
+    {
+      glm::vec3 invDirection = 1.0f / direction;
+      for (const Aabb &fat : fatBoxes)
+      {
+        hits += RayHitsBox(fat, origin, invDirection, rayLength);
+      }
+    } }, 1);
+  report("ray", rays.size(), treeMs, scanMs);
+
+  std::printf("%u proxies, tree height %d, %llu hits\n", count, tree.GetHeight(), static_cast<unsigned long long>(hits));
+  return gCheckFailures;
+}
\ No newline at end of file
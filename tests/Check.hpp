@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+// Minimal checks for the test executables: failures are printed and counted, main returns the count.
+// Atomic since checks also run inside jobs
+inline std::atomic<int> gCheckFailures{0};
+
+#define CHECK(condition)                                                      \
+  do                                                                          \
+  {                                                                           \
+    if (!(condition))                                                         \
+    {                                                                         \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      ++gCheckFailures;                                                       \
+    }                                                                         \
+  } while (false)
+
+// Milliseconds fn takes, best of a few runs
+template <typename Fn>
+double MeasureMs(Fn &&fn, int runs = 5)
+{
+  double best = 0.0;
+  for (int run = 0; run != runs; ++run)
+  {
+    auto begin = std::chrono::steady_clock::now();
+    fn();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    best = run == 0 ? ms : std::min(best, ms);
+  }
+  return best;
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "system/CollisionSystem.hpp"
+#include "Check.hpp"
+#include <random>
+#include <string>
+
+// Broadphase against the original O(n^2) loop on a crowd of overlapping units. The broadphase resolves against
+// the positions at the start of the tick while the original applies pushes in place, so the two agree up to that
+// ordering: per body within a fraction of one tick's push, on average far closer than the bodies moved
+static void FillCrowd(entt::registry &registry, uint32_t count, float area)
+{
+  std::mt19937 random(7);
+  std::uniform_real_distribution<float> coordinate(0.0f, area);
+  std::uniform_real_distribution<float> radius(0.3f, 1.0f);
+
+  for (uint32_t i = 0; i != count; ++i)
+  {
+    entt::entity entity = registry.create();
+    registry.emplace<Position>(entity, coordinate(random), coordinate(random));
+    registry.emplace<Collider>(entity, radius(random), i % 16 == 0);
+  }
+}
+
+static void RunCrowd(JobSystem &jobs, uint32_t count)
+{
+  float area = std::sqrt(static_cast<float>(count)) * 2.0f;
+  const float dt = 1.0f / 60.0f;
+
+  entt::registry broadphase;
+  entt::registry reference;
+  entt::registry initial;
+  FillCrowd(broadphase, count, area);
+  FillCrowd(reference, count, area);
+  FillCrowd(initial, count, area);
+
+  // The first tick of each path is the one compared, and timed as well
+  CollisionSystem broadphaseSystem;
+  CollisionSystem referenceSystem;
+  double broadphaseMs = MeasureMs([&]()
+                                  { broadphaseSystem.Update(broadphase, jobs, dt); }, 1);
+  double referenceMs = MeasureMs([&]()
+                                 { referenceSystem.UpdateBruteForce(reference, dt); }, 1);
+
+  uint32_t moved = 0;
+  float maxDifference = 0.0f;
+  double differenceSum = 0.0;
+  double displacementSum = 0.0;
+  for (auto [entity, position] : broadphase.view<Position>().each())
+  {
+    const Position &expected = reference.get<Position>(entity);
+    const Position &start = initial.get<Position>(entity);
+
+    float difference = std::hypot(position.x - expected.x, position.y - expected.y);
+    maxDifference = std::max(maxDifference, difference);
+    differenceSum += difference;
+    displacementSum += std::hypot(expected.x - start.x, expected.y - start.y);
+    moved += expected.x != start.x || expected.y != start.y ? 1 : 0;
+  }
+  // The most crowded bodies move up to about 0.09 in a tick, ordering may shift one by a good part of that.
+  // On average the two stay within a few percent of how far bodies moved (about 1.5% at every size)
+  CHECK(maxDifference < 0.1f);
+  CHECK(differenceSum < 0.05 * displacementSum);
+  // The crowd is dense enough that the comparison covers real contacts
+  CHECK(moved > count / 4);
+
+  // More ticks for steadier numbers, the quadratic path only while that stays affordable
+  broadphaseMs = std::min(broadphaseMs, MeasureMs([&]()
+                                                  { broadphaseSystem.Update(broadphase, jobs, dt); }));
+  if (count <= 10000)
+  {
+    referenceMs = std::min(referenceMs, MeasureMs([&]()
+                                                  { referenceSystem.UpdateBruteForce(reference, dt); }, 3));
+  }
+
+  std::printf("%6u bodies, %6u in contact: broadphase %9.3f ms, brute force %10.3f ms, max difference %.5f\n",
+              count, moved, broadphaseMs, referenceMs, maxDifference);
+}
+
+int main(int argc, char **argv)
+{
+  JobSystem jobs;
+  jobs.Init();
+
+  if (argc > 1)
+  {
+    RunCrowd(jobs, static_cast<uint32_t>(std::stoul(argv[1])));
+  }
+  else
+  {
+    for (uint32_t count : {1000u, 10000u, 100000u})
+    {
+      RunCrowd(jobs, count);
+    }
+  }
+
+  jobs.Shutdown();
+  return gCheckFailures;
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "core/JobSystem.hpp"
+#include "core/AllocationCounter.hpp"
+#include "ecs/Components.hpp"
+#include "Check.hpp"
+#include <entt/entt.hpp>
+#include <memory>
+
+// Every index and every entity of a view must be handed to exactly one batch, on whichever thread runs it
+static void CheckParallelFor(JobSystem &jobs, uint32_t count, uint32_t minBatch)
+{
+  auto visits = std::make_unique<std::atomic<uint32_t>[]>(count);
+  jobs.ParallelFor(count, minBatch, [&](uint32_t begin, uint32_t end)
+                   {
+    for (uint32_t i = begin; i != end; ++i)
+    {
+      visits[i].fetch_add(1, std::memory_order_relaxed);
+    } });
+
+  uint32_t wrong = 0;
+  for (uint32_t i = 0; i != count; ++i)
+  {
+    wrong += visits[i].load() != 1;
+  }
+  CHECK(wrong == 0);
+}
+
+// Per-thread scratch is indexed by GetThreadIndex without locks, as EntityCommandBuffer does: an attached thread
+// running loops next to the main thread must not share an index with it, or increments here get lost
+static void CheckAttachedThread(JobSystem &jobs)
+{
+  constexpr uint32_t count = 200000;
+  std::vector<uint32_t> perThread(jobs.GetThreadCount(), 0);
+  auto countVisits = [&]()
+  {
+    jobs.ParallelFor(count, 1, [&](uint32_t begin, uint32_t end)
+                     {
+      for (uint32_t i = begin; i != end; ++i)
+      {
+        ++perThread[JobSystem::GetThreadIndex()];
+      } });
+  };
+
+  uint32_t attachedIndex = 0;
+  std::thread attached([&]()
+                       {
+    jobs.AttachThread();
+    attachedIndex = JobSystem::GetThreadIndex();
+    countVisits(); });
+  countVisits();
+  attached.join();
+
+  CHECK(attachedIndex == jobs.GetThreadCount() - 1);
+  uint32_t total = 0;
+  for (uint32_t visits : perThread)
+  {
+    total += visits;
+  }
+  CHECK(total == 2 * count);
+}
+
+static constexpr uint32_t ENTITY_COUNT = 20000;
+
+static void CheckParallelEach(JobSystem &jobs, entt::registry &registry, uint32_t minBatch)
+{
+  auto view = registry.view<Position, Velocity>();
+  std::vector<std::atomic<uint32_t>> visits(ENTITY_COUNT);
+  std::atomic<uint32_t> mismatched{0};
+
+  jobs.ParallelEach(view, minBatch, [&](entt::entity entity, Position &position, Velocity &velocity)
+                    {
+    visits[static_cast<size_t>(entt::to_entity(entity))].fetch_add(1, std::memory_order_relaxed);
+    // Components belong to the entity they are passed with
+    if (position.x != static_cast<float>(entt::to_integral(entity)) || velocity.vx != position.x)
+    {
+      mismatched.fetch_add(1, std::memory_order_relaxed);
+    } });
+
+  uint32_t wrong = 0;
+  for (entt::entity entity : registry.view<Position>())
+  {
+    uint32_t expected = registry.all_of<Velocity>(entity) ? 1 : 0;
+    wrong += visits[static_cast<size_t>(entt::to_entity(entity))].load() != expected;
+  }
+  CHECK(wrong == 0);
+  CHECK(mismatched.load() == 0);
+}
+
+// Fixed ticks call ParallelEach every step, after the first call its gathered list is reused
+static void CheckParallelEachAllocations(JobSystem &jobs, entt::registry &registry)
+{
+  auto view = registry.view<Position, Velocity>();
+  auto step = [&]()
+  {
+    jobs.ParallelEach(view, 64, [](entt::entity, Position &position, Velocity &velocity)
+                      { position.y += velocity.vy * 0.0f; });
+  };
+
+  step();
+  uint64_t allocations = AllocationCounter::GetCount();
+  for (int i = 0; i != 10; ++i)
+  {
+    step();
+  }
+  allocations = AllocationCounter::GetCount() - allocations;
+
+  if (allocations != 0)
+  {
+    std::fprintf(stderr, "ParallelEach allocated %llu times in 10 steady calls\n", static_cast<unsigned long long>(allocations));
+  }
+  CHECK(allocations == 0);
+}
+
+int main()
+{
+  JobSystem jobs;
+  jobs.Init(3, 1);
+
+  CheckParallelFor(jobs, 1, 64);
+  CheckParallelFor(jobs, 100000, 1);
+  CheckParallelFor(jobs, 100000, 256);
+
+  // Every third entity lacks Velocity, so the view spans two pools and has to be gathered
+  entt::registry registry;
+  for (uint32_t i = 0; i != ENTITY_COUNT; ++i)
+  {
+    entt::entity entity = registry.create();
+    float value = static_cast<float>(entt::to_integral(entity));
+    registry.emplace<Position>(entity, value, value);
+    if (i % 3 != 0)
+    {
+      registry.emplace<Velocity>(entity, value, value);
+    }
+  }
+
+  // Batches smaller than the view run on the workers, the case that used to read an empty list there
+  CheckParallelEach(jobs, registry, 256);
+  CheckParallelEach(jobs, registry, 1);
+
+  // Nested: a thread waiting on the outer loop runs inner ones in between
+  jobs.ParallelFor(8, 1, [&](uint32_t begin, uint32_t end)
+                   {
+    for (uint32_t i = begin; i != end; ++i)
+    {
+      CheckParallelEach(jobs, registry, 64);
+    } });
+
+  CheckParallelEachAllocations(jobs, registry);
+  CheckAttachedThread(jobs);
+
+  jobs.Shutdown();
+  return gCheckFailures;
+}
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "graphics/MeshImporter.hpp"
+#include "tiny_obj_loader.h"
+#include "Check.hpp"
+#include <unordered_map>
+#include <thread>
+#include <stdexcept>
+#include <filesystem>
+#include <string>
+#include <cstdio>
+#include <cmath>
+
+// The serial importer the sharded dedupe replaced: first occurrence of a vertex gets the next index
+static MeshData LoadObjReference(const std::string &filepath)
+{
+  tinyobj::attrib_t attrib;
+  std::vector<tinyobj::shape_t> shapes;
+  std::vector<tinyobj::material_t> materials;
+  std::string warn, err;
+
+  if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str()))
+  {
+    throw std::runtime_error(warn + err);
+  }
+
+  std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+  MeshData data;
+
+  for (const auto &shape : shapes)
+  {
+    for (const auto &index : shape.mesh.indices)
+    {
+      Vertex vertex{};
+
+      vertex.pos = {
+          attrib.vertices[3 * index.vertex_index + 0],
+          attrib.vertices[3 * index.vertex_index + 1],
+          attrib.vertices[3 * index.vertex_index + 2],
+      };
+
+      if (index.texcoord_index >= 0)
+      {
+        vertex.texCoord = {
+            attrib.texcoords[2 * index.texcoord_index + 0],
+            1.0f - attrib.texcoords[2 * index.texcoord_index + 1],
+        };
+      }
+
+      vertex.color = {1.0f, 1.0f, 1.0f};
+
+      auto [it, inserted] = uniqueVertices.try_emplace(vertex, static_cast<uint32_t>(data.vertices.size()));
+      if (inserted)
+      {
+        data.vertices.push_back(vertex);
+      }
+      data.indices.push_back(it->second);
+    }
+  }
+
+  return data;
+}
+
+static void CheckSameGeometry(const MeshData &expected, const MeshData &actual)
+{
+  CHECK(expected.vertices.size() == actual.vertices.size());
+  CHECK(expected.indices == actual.indices);
+  CHECK(std::equal(expected.vertices.begin(), expected.vertices.end(), actual.vertices.begin(), actual.vertices.end()));
+}
+
+// Terrain-like grid of quads split into triangles. Interior corners are shared by six triangles,
+// so the dedupe folds about 6 corners into every vertex, as on real scanned or sculpted meshes
+static std::string WriteGridObj(uint32_t quadsPerSide)
+{
+  std::string path = (std::filesystem::temp_directory_path() / ("aboba_grid_" + std::to_string(quadsPerSide) + ".obj")).string();
+  std::FILE *file = std::fopen(path.c_str(), "wb");
+  if (!file)
+  {
+    throw std::runtime_error("Failed to create " + path);
+  }
+
+  uint32_t side = quadsPerSide + 1;
+  for (uint32_t z = 0; z != side; ++z)
+  {
+    for (uint32_t x = 0; x != side; ++x)
+    {
+      float height = std::sin(x * 0.05f) * std::cos(z * 0.07f) * 4.0f;
+      std::fprintf(file, "v %u %.4f %u\n", x, height, z);
+    }
+  }
+  for (uint32_t z = 0; z != side; ++z)
+  {
+    for (uint32_t x = 0; x != side; ++x)
+    {
+      std::fprintf(file, "vt %.6f %.6f\n", static_cast<float>(x) / quadsPerSide, static_cast<float>(z) / quadsPerSide);
+    }
+  }
+  // OBJ indices are 1-based, positions and texcoords share them
+  for (uint32_t z = 0; z != quadsPerSide; ++z)
+  {
+    for (uint32_t x = 0; x != quadsPerSide; ++x)
+    {
+      uint32_t a = z * side + x + 1;
+      uint32_t b = a + 1;
+      uint32_t c = a + side;
+      uint32_t d = c + 1;
+      std::fprintf(file, "f %u/%u %u/%u %u/%u\nf %u/%u %u/%u %u/%u\n", a, a, c, c, b, b, b, b, c, c, d, d);
+    }
+  }
+
+  std::fclose(file);
+  return path;
+}
+
+static void BenchObj(const std::string &path, uint32_t threadCount, int runs)
+{
+  MeshData reference = LoadObjReference(path);
+  CHECK(!reference.indices.empty());
+
+  // Forced thread counts take the sharded path even below the size where it kicks in by default
+  CheckSameGeometry(reference, MeshImporter::LoadObjGeometry(path, 1));
+  CheckSameGeometry(reference, MeshImporter::LoadObjGeometry(path, 3));
+  CheckSameGeometry(reference, MeshImporter::LoadObjGeometry(path, threadCount));
+
+  // Both include parsing the file, which the dedupe does not change
+  double referenceMs = MeasureMs([&]()
+                                 { LoadObjReference(path); }, runs);
+  double shardedMs = MeasureMs([&]()
+                               { MeshImporter::LoadObjGeometry(path, threadCount); }, runs);
+  std::printf("%s: %zu triangles, %zu vertices: unordered_map %.3f ms, sharded on %u threads %.3f ms\n",
+              path.c_str(), reference.indices.size() / 3, reference.vertices.size(), referenceMs, threadCount, shardedMs);
+}
+
+// Run from the source directory, or pass an OBJ file
+int main(int argc, char **argv)
+{
+  uint32_t threadCount = std::max(2u, std::thread::hardware_concurrency());
+
+  if (argc > 1)
+  {
+    BenchObj(argv[1], threadCount, 5);
+    return gCheckFailures;
+  }
+
+  BenchObj("models/Panda.obj", threadCount, 5);
+
+  // 2 million triangles, generated since no such model ships with the repo
+  std::string gridPath = WriteGridObj(1000);
+  BenchObj(gridPath, threadCount, 2);
+  std::filesystem::remove(gridPath);
+
+  return gCheckFailures;
+}
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "geometry/TransformBatch.hpp"
+#include "ecs/TransformComponent.hpp"
+#include "Check.hpp"
+#include <random>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <string>
+
+// Same interleaving GpuScene writes into: each matrix lands inside a larger struct, neighbours must stay untouched
+struct StridedMatrix
+{
+  uint32_t before;
+  glm::mat4 model;
+  uint32_t after;
+};
+
+static constexpr uint32_t GUARD = 0xA5A5A5A5u;
+
+static std::vector<TransformComponent> RandomTransforms(size_t count, std::mt19937 &random)
+{
+  std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+  // Well past one turn both ways, the kernel reduces angles itself
+  std::uniform_real_distribution<float> rotation(-2000.0f, 2000.0f);
+  std::uniform_real_distribution<float> scale(0.01f, 100.0f);
+
+  std::vector<TransformComponent> transforms(count);
+  for (TransformComponent &transform : transforms)
+  {
+    transform.position = {position(random), position(random), position(random)};
+    transform.rotation = {rotation(random), rotation(random), rotation(random)};
+    transform.scale = {scale(random), scale(random), scale(random)};
+  }
+
+  // Exact multiples of a quarter turn, where the reduction lands on the edges of its range
+  const float edges[] = {0.0f, 90.0f, -90.0f, 180.0f, -180.0f, 360.0f, -360.0f, 720.0f, -1080.0f, 1890.0f};
+  for (size_t i = 0; i != std::min(count, std::size(edges)); ++i)
+  {
+    transforms[i].rotation = {edges[i], edges[(i + 3) % std::size(edges)], edges[(i + 7) % std::size(edges)]};
+  }
+  return transforms;
+}
+
+// The same transforms split into the arrays BuildModelMatrices reads
+struct TransformSoa
+{
+  std::vector<float> arrays[9];
+
+  explicit TransformSoa(const std::vector<TransformComponent> &transforms)
+  {
+    for (std::vector<float> &array : arrays)
+    {
+      array.resize(transforms.size());
+    }
+    for (size_t i = 0; i != transforms.size(); ++i)
+    {
+      for (int axis = 0; axis != 3; ++axis)
+      {
+        arrays[axis][i] = transforms[i].position[axis];
+        arrays[3 + axis][i] = transforms[i].rotation[axis];
+        arrays[6 + axis][i] = transforms[i].scale[axis];
+      }
+    }
+  }
+
+  TransformArrays View() const
+  {
+    return {arrays[0].data(), arrays[1].data(), arrays[2].data(),
+            arrays[3].data(), arrays[4].data(), arrays[5].data(),
+            arrays[6].data(), arrays[7].data(), arrays[8].data()};
+  }
+};
+
+static void CheckBatch(size_t count, std::mt19937 &random)
+{
+  std::vector<TransformComponent> transforms = RandomTransforms(count, random);
+  TransformSoa soa(transforms);
+  TransformArrays batch = soa.View();
+
+  std::vector<StridedMatrix> out(count + 1);
+  for (StridedMatrix &entry : out)
+  {
+    entry.before = GUARD;
+    entry.model = glm::mat4(0.0f);
+    entry.after = GUARD;
+  }
+  BuildModelMatrices(batch, count, &out[0].model, sizeof(StridedMatrix));
+
+  uint32_t mismatched = 0;
+  uint32_t overwritten = 0;
+  for (size_t i = 0; i != count; ++i)
+  {
+    glm::mat4 expected = transforms[i].GetModelMatrix();
+    for (int column = 0; column != 4; ++column)
+    {
+      // Float angles in radians lose precision with magnitude, so the error scales with the column
+      float magnitude = 0.0f;
+      for (int row = 0; row != 4; ++row)
+      {
+        magnitude = std::max(magnitude, std::abs(expected[column][row]));
+      }
+      for (int row = 0; row != 4; ++row)
+      {
+        mismatched += std::abs(out[i].model[column][row] - expected[column][row]) > 1e-4f * (1.0f + magnitude);
+      }
+    }
+    overwritten += out[i].before != GUARD || out[i].after != GUARD;
+  }
+  // The entry past the end is never written
+  overwritten += out[count].before != GUARD || out[count].after != GUARD || out[count].model != glm::mat4(0.0f);
+
+  if (mismatched != 0 || overwritten != 0)
+  {
+    std::fprintf(stderr, "count %zu: %u elements off, %u entries overwritten\n", count, mismatched, overwritten);
+  }
+  CHECK(mismatched == 0);
+  CHECK(overwritten == 0);
+}
+
+// Both paths write into the same strided layout, the scalar one is what extraction did before batching
+static void BenchBatch(size_t count, std::mt19937 &random)
+{
+  std::vector<TransformComponent> transforms = RandomTransforms(count, random);
+  TransformSoa soa(transforms);
+  TransformArrays batch = soa.View();
+  std::vector<StridedMatrix> out(count);
+
+  double batchMs = MeasureMs([&]()
+                             { BuildModelMatrices(batch, count, &out[0].model, sizeof(StridedMatrix)); });
+  float batchTranslation = out[count / 2].model[3][0];
+  double scalarMs = MeasureMs([&]()
+                              {
+    for (size_t i = 0; i != count; ++i)
+    {
+      out[i].model = transforms[i].GetModelMatrix();
+    } });
+  float scalarTranslation = out[count / 2].model[3][0];
+
+  std::printf("%zu transforms: batch %.3f ms, scalar %.3f ms (%.1fx)\n", count, batchMs, scalarMs, scalarMs / batchMs);
+  // Same translation from both, also keeps either loop from being dropped
+  CHECK(batchTranslation == scalarTranslation);
+}
+
+int main(int argc, char **argv)
+{
+  std::mt19937 random(25);
+
+  // Counts below, at and past one SSE2 group, then a large one whose tail is not a multiple of 4
+  for (size_t count : {0, 1, 2, 3, 4, 5, 7, 8, 63, 64, 65, 1003})
+  {
+    CheckBatch(count, random);
+  }
+
+  BenchBatch(argc > 1 ? static_cast<size_t>(std::stoul(argv[1])) : 100000, random);
+
+  return gCheckFailures;
+}
\ No newline at end of file